@@ -20,7 +20,7 @@
 #define BLOCK_HEADER_MAGIC_NUMBER  0x4C                  // the magic number value
 
 // #define MAX_ALLOC_SIZE (1ULL << 39)
-#define MAX_ALLOC_SIZE (1ULL << 20)
+#define MAX_ALLOC_SIZE (1ULL << 27) // MAX_LARGE_ALLOC_SIZE
 
 #define ARENA_DEFAULT_CHUNK_SIZE 4096
 
@@ -281,7 +281,7 @@ static inline BlockHeader *chunk_alloc_block(ArenaChunk *chunk, Logger *logger,
         size_t capacity = block_size(*header);
         if (block_available(*header) && capacity >= size) {
             // found free block
-            Assert(capacity < MAX_ALLOC_SIZE);
+            Assert(capacity <= MAX_ALLOC_SIZE);
             block_checkout(header);
             DEBUG(logger,
                   "Repurposed block of capacity %zu for size %zu at offset %d from chunk %p",
@@ -2,6 +2,8 @@
 
 #include "array.h"
 
+#define STRING_MIN_CAPACITY 64
+
 #pragma region Declare
 
 static String *empty_string(Allocator *alloc);
@@ -106,6 +108,36 @@ String *string_sprintf(Allocator *alloc, const char *format, ...) {
     return string;
 }
 
+// Appends formatted text to the end of str, growing it geometrically when the capacity is
+// exhausted. The returned string replaces str, which must not be used afterwards.
+String *string_appendf(String *str, Allocator *alloc, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    Assert(length >= 0);
+
+    size_t required = str->length + length + 1;
+    if (required > str->capacity) {
+        size_t capacity = str->capacity > 0 ? str->capacity : STRING_MIN_CAPACITY;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+        String *grown = string_create(alloc, capacity);
+        memcpy(grown->data, str->data, str->length);
+        grown->length = str->length;
+        string_destroy(str, alloc);
+        str = grown;
+    }
+
+    va_start(args, format);
+    length = vsnprintf(str->data + str->length, str->capacity - str->length, format, args);
+    va_end(args);
+    Assert(length >= 0);
+    str->length += length;
+    return str;
+}
+
 #pragma endregion
 
 #pragma region Private
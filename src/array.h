@@ -59,6 +59,7 @@ void string_destroy(String *string, Allocator *alloc);
 String *string_dup_cstr(Allocator *alloc, const char *source);
 String *string_dup(Allocator *alloc, String *source);
 String *string_sprintf(Allocator *alloc, const char *format, ...);
+String *string_appendf(String *str, Allocator *alloc, const char *format, ...);
 
 static inline const char *string_cstr(String *str) {
     return (const char *)str->data;
@@ -0,0 +1,265 @@
+#include <string.h>
+
+#include "batch.h"
+#include "verifier.h"
+
+// The widest vector unit the build targets; compile with -mavx for 4 lanes. Without SSE2 the
+// kernels are plain loops.
+#if defined(__AVX__)
+#include <immintrin.h>
+#define VECTOR_WIDTH         4
+#define VECTOR               __m256d
+#define vector_load(p)       _mm256_loadu_pd(p)
+#define vector_store(p, v)   _mm256_storeu_pd(p, v)
+#define vector_broadcast(x)  _mm256_set1_pd(x)
+#define vector_add(a, b)     _mm256_add_pd(a, b)
+#define vector_subtract(a, b) _mm256_sub_pd(a, b)
+#define vector_multiply(a, b) _mm256_mul_pd(a, b)
+#define vector_divide(a, b)  _mm256_div_pd(a, b)
+#define vector_xor(a, b)     _mm256_xor_pd(a, b)
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VECTOR_WIDTH         2
+#define VECTOR               __m128d
+#define vector_load(p)       _mm_loadu_pd(p)
+#define vector_store(p, v)   _mm_storeu_pd(p, v)
+#define vector_broadcast(x)  _mm_set1_pd(x)
+#define vector_add(a, b)     _mm_add_pd(a, b)
+#define vector_subtract(a, b) _mm_sub_pd(a, b)
+#define vector_multiply(a, b) _mm_mul_pd(a, b)
+#define vector_divide(a, b)  _mm_div_pd(a, b)
+#define vector_xor(a, b)     _mm_xor_pd(a, b)
+#endif
+
+#pragma region Declare
+
+static bool decode(Batch *batch, OpCodeChunk *chunk, int length);
+static inline void negate(double *dst, const double *src, size_t n);
+static inline void fill(double *dst, double value, size_t n);
+static void add(double *dst, BatchOperand left, BatchOperand right, size_t n);
+static void subtract(double *dst, BatchOperand left, BatchOperand right, size_t n);
+static void multiply(double *dst, BatchOperand left, BatchOperand right, size_t n);
+static void divide(double *dst, BatchOperand left, BatchOperand right, size_t n);
+
+#pragma endregion
+
+#pragma region Public
+
+// Verifies and decodes the chunk for columnar evaluation. The chunk is not referenced afterwards.
+BatchResult batch_init(Batch *batch, OpCodeChunk *chunk, Allocator *alloc) {
+    *batch = (Batch){ .alloc = alloc };
+    Verification verification;
+    if (verify_chunk(chunk, BATCH_MAX_STACK_DEPTH, &verification) != VERIFY_OK) {
+        return verification.result == VERIFY_STACK_OVERFLOW ? BATCH_STACK_TOO_DEEP
+                                                            : BATCH_INVALID_CHUNK;
+    }
+
+    batch->length = verification.num_instructions;
+    batch->max_stack_depth = verification.max_stack_depth;
+    batch->code = (BatchInstruction *)allocator_alloc(alloc,
+                                                      sizeof(BatchInstruction) * batch->length);
+    if (!decode(batch, chunk, verification.code_length)) {
+        allocator_free(alloc, batch->code);
+        *batch = (Batch){ 0 };
+        return BATCH_NON_NUMBER_CONSTANT;
+    }
+    batch->stack = (BatchOperand *)allocator_alloc(alloc,
+                                                   sizeof(BatchOperand) * batch->max_stack_depth);
+    batch->blocks = (double *)allocator_alloc(alloc, sizeof(double) * BATCH_BLOCK_ROWS
+                                                         * batch->max_stack_depth);
+    return BATCH_OK;
+}
+
+// Evaluates the chunk for each of `num_rows` rows, writing the value it returns for row i to
+// out[i]. columns[c] must hold at least `num_rows` doubles for every column the chunk reads.
+BatchResult batch_run(Batch *batch, const double *const *columns, int num_columns, size_t num_rows,
+                      double *out) {
+    if (num_columns < batch->num_columns) {
+        return BATCH_MISSING_COLUMN;
+    }
+// Pops the right operand and replaces the left one with the result. Two scalars fold into a scalar;
+// otherwise the kernel writes the result to the left entry's block, which may be the left operand.
+#define BINARY(kernel, op)                                                                         \
+    do {                                                                                           \
+        BatchOperand *right = &stack[--depth];                                                     \
+        BatchOperand *left = &stack[depth - 1];                                                    \
+        if (left->vector == NULL && right->vector == NULL) {                                       \
+            left->scalar = left->scalar op right->scalar;                                          \
+        } else {                                                                                   \
+            double *dst = batch->blocks + (size_t)(depth - 1) * BATCH_BLOCK_ROWS;                  \
+            kernel(dst, *left, *right, n);                                                         \
+            left->vector = dst;                                                                    \
+        }                                                                                          \
+    } while (false)
+
+    BatchOperand *stack = batch->stack;
+    for (size_t start = 0; start < num_rows; start += BATCH_BLOCK_ROWS) {
+        size_t n = num_rows - start < BATCH_BLOCK_ROWS ? num_rows - start : BATCH_BLOCK_ROWS;
+        int depth = 0;
+        for (BatchInstruction *instruction = batch->code;; instruction++) {
+            switch (instruction->code) {
+            case OP_CONSTANT:
+                stack[depth++] = (BatchOperand){ .vector = NULL, .scalar = instruction->constant };
+                break;
+            case OP_COLUMN:
+                stack[depth++] = (BatchOperand){ .vector = columns[instruction->column] + start };
+                break;
+            case OP_ADD:
+                BINARY(add, +);
+                break;
+            case OP_SUBTRACT:
+                BINARY(subtract, -);
+                break;
+            case OP_MULTIPLY:
+                BINARY(multiply, *);
+                break;
+            case OP_DIVIDE:
+                BINARY(divide, /);
+                break;
+            case OP_NEGATE: {
+                BatchOperand *top = &stack[depth - 1];
+                if (top->vector == NULL) {
+                    top->scalar = -top->scalar;
+                } else {
+                    double *dst = batch->blocks + (size_t)(depth - 1) * BATCH_BLOCK_ROWS;
+                    negate(dst, top->vector, n);
+                    top->vector = dst;
+                }
+                break;
+            }
+            case OP_RETURN: {
+                // The result is the top of the stack, which needn't be its only value.
+                BatchOperand *top = &stack[depth - 1];
+                if (top->vector == NULL) {
+                    fill(out + start, top->scalar, n);
+                } else {
+                    memcpy(out + start, top->vector, sizeof(double) * n);
+                }
+                goto next_block;
+            }
+            default:
+                Unreachable();
+            }
+        }
+    next_block:;
+    }
+    return BATCH_OK;
+
+#undef BINARY
+}
+
+void batch_destroy(Batch *batch) {
+    allocator_free(batch->alloc, batch->code);
+    allocator_free(batch->alloc, batch->stack);
+    allocator_free(batch->alloc, batch->blocks);
+    *batch = (Batch){ 0 };
+}
+
+#pragma endregion
+
+#pragma region Private
+
+// Translates verified bytecode into batch instructions. Returns false if a constant is not a number.
+static bool decode(Batch *batch, OpCodeChunk *chunk, int length) {
+    uint8_t *code = chunk->codes.codes.data->data;
+    Value *constants = (Value *)chunk->constants.values.data->data;
+    BatchInstruction *instruction = batch->code;
+    for (int offset = 0; offset < length; offset += opcode_size(code[offset]), instruction++) {
+        *instruction = (BatchInstruction){ .code = code[offset] };
+        switch (code[offset]) {
+        case OP_CONSTANT:
+        case OP_CONSTANT_LONG: {
+            uint32_t index = code[offset] == OP_CONSTANT_LONG
+                                 ? (uint32_t)code[offset + 1] << 16 | code[offset + 2] << 8
+                                       | code[offset + 3]
+                                 : code[offset + 1];
+            if (!IS_NUMBER(constants[index])) {
+                return false;
+            }
+            instruction->code = OP_CONSTANT;
+            instruction->constant = AS_NUMBER(constants[index]);
+            break;
+        }
+        case OP_COLUMN:
+            instruction->column = code[offset + 1];
+            if (instruction->column >= batch->num_columns) {
+                batch->num_columns = instruction->column + 1;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+// Defines a kernel computing dst[i] = left[i] op right[i], where either side may be a scalar. The
+// main loop runs a vector at a time; the remaining rows of a short final block run one at a time.
+#ifdef VECTOR_WIDTH
+#define DEFINE_KERNEL(name, op)                                                                    \
+    static void name(double *dst, BatchOperand left, BatchOperand right, size_t n) {               \
+        size_t i = 0;                                                                              \
+        if (left.vector == NULL) {                                                                 \
+            VECTOR scalar = vector_broadcast(left.scalar);                                         \
+            for (; i + VECTOR_WIDTH <= n; i += VECTOR_WIDTH) {                                     \
+                vector_store(dst + i, vector_##name(scalar, vector_load(right.vector + i)));       \
+            }                                                                                      \
+            for (; i < n; i++) {                                                                   \
+                dst[i] = left.scalar op right.vector[i];                                           \
+            }                                                                                      \
+        } else if (right.vector == NULL) {                                                         \
+            VECTOR scalar = vector_broadcast(right.scalar);                                        \
+            for (; i + VECTOR_WIDTH <= n; i += VECTOR_WIDTH) {                                     \
+                vector_store(dst + i, vector_##name(vector_load(left.vector + i), scalar));        \
+            }                                                                                      \
+            for (; i < n; i++) {                                                                   \
+                dst[i] = left.vector[i] op right.scalar;                                           \
+            }                                                                                      \
+        } else {                                                                                   \
+            for (; i + VECTOR_WIDTH <= n; i += VECTOR_WIDTH) {                                     \
+                vector_store(dst + i, vector_##name(vector_load(left.vector + i),                  \
+                                                    vector_load(right.vector + i)));               \
+            }                                                                                      \
+            for (; i < n; i++) {                                                                   \
+                dst[i] = left.vector[i] op right.vector[i];                                        \
+            }                                                                                      \
+        }                                                                                          \
+    }
+#else
+#define DEFINE_KERNEL(name, op)                                                                    \
+    static void name(double *dst, BatchOperand left, BatchOperand right, size_t n) {               \
+        for (size_t i = 0; i < n; i++) {                                                           \
+            double a = left.vector == NULL ? left.scalar : left.vector[i];                         \
+            double b = right.vector == NULL ? right.scalar : right.vector[i];                      \
+            dst[i] = a op b;                                                                       \
+        }                                                                                          \
+    }
+#endif
+
+DEFINE_KERNEL(add, +)
+DEFINE_KERNEL(subtract, -)
+DEFINE_KERNEL(multiply, *)
+DEFINE_KERNEL(divide, /)
+
+#undef DEFINE_KERNEL
+
+static inline void negate(double *dst, const double *src, size_t n) {
+    size_t i = 0;
+#ifdef VECTOR_WIDTH
+    VECTOR sign = vector_broadcast(-0.0);
+    for (; i + VECTOR_WIDTH <= n; i += VECTOR_WIDTH) {
+        vector_store(dst + i, vector_xor(vector_load(src + i), sign));
+    }
+#endif
+    for (; i < n; i++) {
+        dst[i] = -src[i];
+    }
+}
+
+static inline void fill(double *dst, double value, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = value;
+    }
+}
+
+#pragma endregion
\ No newline at end of file
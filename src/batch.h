@@ -0,0 +1,78 @@
+#ifndef clox_batch_h
+#define clox_batch_h
+
+#include <stddef.h>
+
+#include "allocator.h"
+#include "assert.h"
+#include "common.h"
+#include "instruction.h"
+
+/**
+ * Columnar evaluation of one chunk over many input rows.
+ * Rows are processed in blocks of BATCH_BLOCK_ROWS: each instruction is dispatched once per block
+ * and applied to every row of it, so the interpretive overhead is amortised over the block and the
+ * arithmetic runs as SIMD loops over contiguous doubles. OP_COLUMN reads input column i of the
+ * current rows; columns are referenced in place rather than copied, and constants stay scalars
+ * until they meet a column.
+ *
+ * Only numeric chunks can be batched. The inputs are doubles and every constant must be a number,
+ * so no instruction can raise a type error and the output is one double per row.
+ */
+
+#define BATCH_BLOCK_ROWS      256
+#define BATCH_MAX_STACK_DEPTH 256 // each slot holds a block of rows
+
+typedef enum BatchResult {
+    BATCH_OK,
+    BATCH_INVALID_CHUNK,
+    BATCH_STACK_TOO_DEEP,
+    BATCH_NON_NUMBER_CONSTANT,
+    BATCH_MISSING_COLUMN,
+} BatchResult;
+
+typedef struct BatchInstruction {
+    OpCode code;
+    int column;      // for OP_COLUMN
+    double constant; // for OP_CONSTANT (OP_CONSTANT_LONG is folded into it)
+} BatchInstruction;
+
+// A stack entry: either a vector of the current block's rows or a single value shared by all rows.
+typedef struct BatchOperand {
+    const double *vector; // NULL when the operand is a scalar
+    double scalar;
+} BatchOperand;
+
+typedef struct Batch {
+    BatchInstruction *code;
+    int length;
+    int max_stack_depth;
+    int num_columns;       // one more than the largest column index the chunk reads
+    BatchOperand *stack;   // max_stack_depth entries
+    double *blocks;        // max_stack_depth blocks of BATCH_BLOCK_ROWS doubles
+    Allocator *alloc;
+} Batch;
+
+BatchResult batch_init(Batch *batch, OpCodeChunk *chunk, Allocator *alloc);
+BatchResult batch_run(Batch *batch, const double *const *columns, int num_columns, size_t num_rows,
+                      double *out);
+void batch_destroy(Batch *batch);
+
+static inline const char *batch_result_name(BatchResult result) {
+    switch (result) {
+    case BATCH_OK:
+        return "BATCH_OK";
+    case BATCH_INVALID_CHUNK:
+        return "BATCH_INVALID_CHUNK";
+    case BATCH_STACK_TOO_DEEP:
+        return "BATCH_STACK_TOO_DEEP";
+    case BATCH_NON_NUMBER_CONSTANT:
+        return "BATCH_NON_NUMBER_CONSTANT";
+    case BATCH_MISSING_COLUMN:
+        return "BATCH_MISSING_COLUMN";
+    default:
+        Panicf("Unknown batch result %d", result);
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <string.h>
+
+#include "chunk_cache.h"
+
+#define HASH_SEED    0x2d358dccaa6c78a5ULL
+#define HASH_PRIME_1 0x9e3779b97f4a7c15ULL
+#define HASH_PRIME_2 0xbf58476d1ce4e5b9ULL
+#define HASH_PRIME_3 0x94d049bb133111ebULL
+
+#pragma region Declare
+
+static inline uint64_t rotate_left(uint64_t x, int bits);
+static inline ChunkCacheEntry **find(ChunkCache *cache, uint64_t hash, const char *source,
+                                     size_t length);
+static size_t entry_size(ChunkCacheEntry *entry);
+static void entry_destroy(ChunkCache *cache, ChunkCacheEntry *entry);
+static void unlink_entry(ChunkCache *cache, ChunkCacheEntry *entry);
+static void link_newest(ChunkCache *cache, ChunkCacheEntry *entry);
+static void remove_entry(ChunkCache *cache, ChunkCacheEntry *entry);
+static void grow(ChunkCache *cache);
+
+#pragma endregion
+
+#pragma region Public
+
+void chunk_cache_init(ChunkCache *cache, Allocator *alloc, size_t max_size) {
+    *cache = (ChunkCache){
+        .num_buckets = CHUNK_CACHE_MIN_BUCKETS,
+        .max_size = max_size,
+        .alloc = alloc,
+    };
+    cache->buckets = (ChunkCacheEntry **)allocator_alloc(alloc, sizeof(ChunkCacheEntry *)
+                                                                    * cache->num_buckets);
+    memset(cache->buckets, 0, sizeof(ChunkCacheEntry *) * cache->num_buckets);
+}
+
+void chunk_cache_destroy(ChunkCache *cache) {
+    while (cache->oldest != NULL) {
+        remove_entry(cache, cache->oldest);
+    }
+    allocator_free(cache->alloc, cache->buckets);
+    *cache = (ChunkCache){ 0 };
+}
+
+// Returns the entry compiled from exactly this source, marking it most recently used, or NULL.
+ChunkCacheEntry *chunk_cache_get(ChunkCache *cache, const char *source, size_t length) {
+    ChunkCacheEntry *entry = *find(cache, chunk_cache_hash(source, length), source, length);
+    if (entry == NULL) {
+        cache->misses++;
+        return NULL;
+    }
+    cache->hits++;
+    if (entry != cache->newest) {
+        unlink_entry(cache, entry);
+        link_newest(cache, entry);
+    }
+    return entry;
+}
+
+// Takes ownership of a compiled chunk and the LoadedChunk built from it, evicting the least
+// recently used entries to make room. Returns NULL, leaving both with the caller, if the entry
+// alone would exceed the cache's bound. The source must not already be cached.
+ChunkCacheEntry *chunk_cache_put(ChunkCache *cache, const char *source, size_t length,
+                                 OpCodeChunk *chunk, LoadedChunk *loaded) {
+    uint64_t hash = chunk_cache_hash(source, length);
+    Assert(*find(cache, hash, source, length) == NULL);
+
+    ChunkCacheEntry *entry = (ChunkCacheEntry *)allocator_alloc(cache->alloc,
+                                                                sizeof(ChunkCacheEntry));
+    *entry = (ChunkCacheEntry){ .hash = hash, .length = length, .chunk = *chunk,
+                                .loaded = *loaded };
+    // The loaded chunk refers to its source chunk, which now lives in the entry.
+    entry->loaded.chunk = &entry->chunk;
+    entry->size = entry_size(entry);
+    if (entry->size > cache->max_size) {
+        allocator_free(cache->alloc, entry);
+        return NULL;
+    }
+    entry->source = (char *)allocator_alloc(cache->alloc, length + 1);
+    memcpy(entry->source, source, length);
+    entry->source[length] = '\0';
+
+    while (cache->size + entry->size > cache->max_size) {
+        remove_entry(cache, cache->oldest);
+        cache->evictions++;
+    }
+    if (cache->count + 1 > cache->num_buckets / 4 * 3) {
+        grow(cache);
+    }
+    ChunkCacheEntry **bucket = &cache->buckets[hash & (cache->num_buckets - 1)];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    link_newest(cache, entry);
+    cache->count++;
+    cache->size += entry->size;
+    return entry;
+}
+
+// A 64-bit hash that consumes the source eight bytes at a time: each word is folded in with a
+// multiply and rotate, and the result is finalised with the splitmix64 mixer so that all bits
+// affect the bucket index. It is not resistant to deliberately colliding inputs; a collision only
+// costs a source comparison.
+uint64_t chunk_cache_hash(const char *source, size_t length) {
+    uint64_t hash = HASH_SEED ^ (length * HASH_PRIME_1);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, source + i, sizeof(word));
+        hash = rotate_left((hash ^ word) * HASH_PRIME_1, 31);
+    }
+    if (i < length) {
+        uint64_t word = 0;
+        memcpy(&word, source + i, length - i);
+        hash = rotate_left((hash ^ word) * HASH_PRIME_1, 31);
+    }
+    hash ^= hash >> 30;
+    hash *= HASH_PRIME_2;
+    hash ^= hash >> 27;
+    hash *= HASH_PRIME_3;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static inline uint64_t rotate_left(uint64_t x, int bits) {
+    return x << bits | x >> (64 - bits);
+}
+
+// Returns the link pointing at the entry for this source (or the NULL link at the end of its
+// bucket), so callers can both test for and unlink an entry.
+static inline ChunkCacheEntry **find(ChunkCache *cache, uint64_t hash, const char *source,
+                                     size_t length) {
+    ChunkCacheEntry **link = &cache->buckets[hash & (cache->num_buckets - 1)];
+    for (; *link != NULL; link = &(*link)->bucket_next) {
+        ChunkCacheEntry *entry = *link;
+        if (entry->hash == hash && entry->length == length
+            && memcmp(entry->source, source, length) == 0) {
+            break;
+        }
+    }
+    return link;
+}
+
+// Approximates the memory held by an entry: its source, bytecode, constants, line table and the
+// decoded instruction stream (plus native code, if any).
+static size_t entry_size(ChunkCacheEntry *entry) {
+    OpCodeChunk *chunk = &entry->chunk;
+    return sizeof(ChunkCacheEntry) + entry->length + 1 + vector_len(&chunk->codes.codes)
+           + vector_len(&chunk->constants.values) * sizeof(Value)
+           + vector_len(&chunk->lines.encodings) * sizeof(LineNumberEncoding)
+           + (size_t)entry->loaded.length * (sizeof(Instruction) + sizeof(int))
+           + entry->loaded.jit.size;
+}
+
+static void entry_destroy(ChunkCache *cache, ChunkCacheEntry *entry) {
+    loaded_chunk_destroy(&entry->loaded, cache->alloc);
+    opcode_chunk_destroy(&entry->chunk);
+    allocator_free(cache->alloc, entry->source);
+    allocator_free(cache->alloc, entry);
+}
+
+static void unlink_entry(ChunkCache *cache, ChunkCacheEntry *entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        cache->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        cache->oldest = entry->newer;
+    }
+    entry->newer = entry->older = NULL;
+}
+
+static void link_newest(ChunkCache *cache, ChunkCacheEntry *entry) {
+    entry->older = cache->newest;
+    entry->newer = NULL;
+    if (cache->newest != NULL) {
+        cache->newest->newer = entry;
+    } else {
+        cache->oldest = entry;
+    }
+    cache->newest = entry;
+}
+
+static void remove_entry(ChunkCache *cache, ChunkCacheEntry *entry) {
+    ChunkCacheEntry **link = find(cache, entry->hash, entry->source, entry->length);
+    Assert(*link == entry);
+    *link = entry->bucket_next;
+    unlink_entry(cache, entry);
+    cache->count--;
+    cache->size -= entry->size;
+    entry_destroy(cache, entry);
+}
+
+// Doubles the number of buckets, rehashing from the stored hashes.
+static void grow(ChunkCache *cache) {
+    size_t num_buckets = cache->num_buckets * 2;
+    ChunkCacheEntry **buckets = (ChunkCacheEntry **)allocator_alloc(
+        cache->alloc, sizeof(ChunkCacheEntry *) * num_buckets);
+    memset(buckets, 0, sizeof(ChunkCacheEntry *) * num_buckets);
+    for (size_t i = 0; i < cache->num_buckets; i++) {
+        ChunkCacheEntry *entry = cache->buckets[i];
+        while (entry != NULL) {
+            ChunkCacheEntry *next = entry->bucket_next;
+            ChunkCacheEntry **bucket = &buckets[entry->hash & (num_buckets - 1)];
+            entry->bucket_next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+    allocator_free(cache->alloc, cache->buckets);
+    cache->buckets = buckets;
+    cache->num_buckets = num_buckets;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef clox_chunk_cache_h
+#define clox_chunk_cache_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "common.h"
+#include "instruction.h"
+#include "vm.h"
+
+/**
+ * A cache of compiled and loaded chunks keyed by their source text.
+ * Sources are hashed a word at a time and looked up in a chained hash table; a hit is confirmed by
+ * comparing the source bytes, so hash collisions never return the wrong chunk. Entries are kept in
+ * least-recently-used order and evicted from the cold end once their total size exceeds the bound.
+ *
+ * An entry owns its copy of the source, the compiled OpCodeChunk and the LoadedChunk built from it,
+ * so a hit skips the scanner, the compiler, the verifier and the decoder. Only chunks that compiled
+ * and verified are cached.
+ */
+
+#define CHUNK_CACHE_DEFAULT_SIZE (16 * 1024 * 1024) // bytes
+#define CHUNK_CACHE_MIN_BUCKETS  64
+
+typedef struct ChunkCacheEntry {
+    uint64_t hash;
+    char *source;
+    size_t length;
+    size_t size; // the bytes accounted to this entry
+    OpCodeChunk chunk;
+    LoadedChunk loaded;
+    struct ChunkCacheEntry *bucket_next; // the next entry in the same bucket
+    struct ChunkCacheEntry *newer;       // towards the most recently used entry
+    struct ChunkCacheEntry *older;       // towards the least recently used entry
+} ChunkCacheEntry;
+
+typedef struct ChunkCache {
+    ChunkCacheEntry **buckets;
+    size_t num_buckets; // a power of two
+    size_t count;
+    size_t size;     // total bytes of all entries
+    size_t max_size; // entries are evicted to stay within this many bytes
+    ChunkCacheEntry *newest;
+    ChunkCacheEntry *oldest;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    Allocator *alloc;
+} ChunkCache;
+
+void chunk_cache_init(ChunkCache *cache, Allocator *alloc, size_t max_size);
+void chunk_cache_destroy(ChunkCache *cache);
+ChunkCacheEntry *chunk_cache_get(ChunkCache *cache, const char *source, size_t length);
+ChunkCacheEntry *chunk_cache_put(ChunkCache *cache, const char *source, size_t length,
+                                 OpCodeChunk *chunk, LoadedChunk *loaded);
+uint64_t chunk_cache_hash(const char *source, size_t length);
+
+#endif
\ No newline at end of file
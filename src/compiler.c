@@ -1,78 +1,285 @@
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "array.h"
 #include "common.h"
 #include "compiler.h"
+#include "number.h"
 #include "parser.h"
 #include "scanner.h"
 
+#ifndef UINT24_MAX
+#define UINT24_MAX 16777215
+#endif
+
+// Grouping and unary operators recurse; this bounds the native stack used by hostile input.
+#define MAX_NESTING_DEPTH 1024
+// Number literals number_parse can't convert, up to this long, are copied to the stack to be
+// NUL-terminated for strtod.
+#define MAX_INLINE_NUMBER_LENGTH 64
+// Bounds the bytes presized for each of a chunk's code and constants, so that a large source
+// doesn't ask for more than one allocation can hold before anything is read. A chunk that needs
+// more grows as it is written.
+#define MAX_RESERVED_BYTES (16 * 1024 * 1024)
+
+typedef enum Precedence {
+    PREC_NONE,
+    PREC_ASSIGNMENT, // =
+    PREC_OR,         // or
+    PREC_AND,        // and
+    PREC_EQUALITY,   // == !=
+    PREC_COMPARISON, // < > <= >=
+    PREC_TERM,       // + -
+    PREC_FACTOR,     // * /
+    PREC_UNARY,      // ! -
+    PREC_CALL,       // . ()
+    PREC_PRIMARY,
+} Precedence;
+
+typedef struct Compiler {
+    Parser parser;
+    OpCodeChunk *chunk;
+    int depth; // current nesting of groupings and unary operators
+} Compiler;
+
+typedef void (*ParseFn)(Compiler *compiler);
+
+typedef struct ParseRule {
+    ParseFn prefix;
+    ParseFn infix;
+    Precedence precedence;
+} ParseRule;
+
 #pragma region Declare
 
-static void advance(Parser *parser);
-static void expression(Parser *parser);
-static void consume(Parser *parser, TokenType expected, const char *message);
-static ParseError parse_error(Parser *parser, Token token);
+static CompileResult compile_scanner(Allocator *alloc, Scanner *scanner, OpCodeChunk *chunk,
+                                     FILE *errors);
+static void expression(Compiler *compiler);
+static void parse_precedence(Compiler *compiler, Precedence precedence);
+static void number(Compiler *compiler);
+static void literal(Compiler *compiler);
+static void grouping(Compiler *compiler);
+static void unary(Compiler *compiler);
+static void binary(Compiler *compiler);
+static bool enter(Compiler *compiler);
+static void emit_code(Compiler *compiler, OpCode code);
+static void emit_constant(Compiler *compiler, Value value);
 
 #pragma endregion
 
-#pragma region Public
+// Operators the VM has no instructions for yet have no rules, so they are reported as syntax errors.
+static const ParseRule rules[TOKEN_EOF + 1] = {
+    [TOKEN_LEFT_PAREN] = { grouping, NULL, PREC_NONE },
+    [TOKEN_MINUS] = { unary, binary, PREC_TERM },
+    [TOKEN_PLUS] = { NULL, binary, PREC_TERM },
+    [TOKEN_SLASH] = { NULL, binary, PREC_FACTOR },
+    [TOKEN_STAR] = { NULL, binary, PREC_FACTOR },
+    [TOKEN_NUMBER] = { number, NULL, PREC_NONE },
+    [TOKEN_FALSE] = { literal, NULL, PREC_NONE },
+    [TOKEN_NIL] = { literal, NULL, PREC_NONE },
+    [TOKEN_TRUE] = { literal, NULL, PREC_NONE },
+};
 
-CompileResult compile(Allocator *alloc, const char *source) {
-    CompileResult result = COMPILE_OK;
+#pragma region Public
 
+// Compiles a single expression, optionally followed by a semicolon, into `chunk` in one pass:
+// each grammar rule emits its bytecode as soon as it has parsed its operands, so no syntax tree is
+// built. The chunk is presized from the length of the source, up to MAX_RESERVED_BYTES, and is left
+// partially written if compilation fails, having reported why to `errors`.
+CompileResult compile(Allocator *alloc, const char *source, OpCodeChunk *chunk, FILE *errors) {
     Scanner scanner;
     scanner_init(&scanner, alloc, source);
+    // Roughly one byte of bytecode per byte of source, and a constant every few bytes.
+    size_t length = scanner.end - scanner.start;
+    size_t code_bytes = length + 1;
+    size_t constants = length / 4 + 1;
+    opcode_chunk_reserve(chunk, code_bytes < MAX_RESERVED_BYTES ? code_bytes : MAX_RESERVED_BYTES,
+                         constants < MAX_RESERVED_BYTES / sizeof(Value)
+                             ? constants
+                             : MAX_RESERVED_BYTES / sizeof(Value));
+    return compile_scanner(alloc, &scanner, chunk, errors);
+}
 
-    Parser parser;
-    parser_init(&parser, alloc, &scanner);
+// Compiles like compile, reading the source from a stream a window at a time, so the source is
+// never held in memory whole. Returns COMPILE_READ_ERROR, having reported it, if reading failed.
+CompileResult compile_stream(Allocator *alloc, SourceStream *stream, OpCodeChunk *chunk,
+                             FILE *errors) {
+    Scanner scanner;
+    scanner_init_stream(&scanner, alloc, stream);
+    return compile_scanner(alloc, &scanner, chunk, errors);
+}
+
+#pragma endregion
 
-    advance(&parser);
-    expression(&parser);
-    consume(&parser, TOKEN_EOF, "Expected end of expression");
+#pragma region Private
 
-    if (parser.state == PARSER_ERROR) {
-        fputs(parser.error.reason, stderr);
-        result = COMPILE_PARSE_ERROR;
-    }
+static CompileResult compile_scanner(Allocator *alloc, Scanner *scanner, OpCodeChunk *chunk,
+                                     FILE *errors) {
+    Compiler compiler = { .chunk = chunk };
+    parser_init(&compiler.parser, alloc, scanner);
+    parser_advance(&compiler.parser);
+    expression(&compiler);
+    parser_match(&compiler.parser, TOKEN_SEMICOLON);
+    parser_consume(&compiler.parser, TOKEN_EOF, "Expect end of expression.");
+    emit_code(&compiler, OP_RETURN);
 
-    scanner_destroy(&scanner);
+    CompileResult result = COMPILE_OK;
+    SourceStream *stream = scanner->stream;
+    if (stream != NULL && stream->error == EFBIG) {
+        // The source was cut short, so any parse error is only a symptom.
+        fprintf(errors, "Error reading source: a line or string is longer than %zu bytes\n",
+                stream->max_capacity);
+        result = COMPILE_READ_ERROR;
+    } else if (stream != NULL && stream->error != 0) {
+        fprintf(errors, "Error reading source: %s\n", strerror(stream->error));
+        result = COMPILE_READ_ERROR;
+    } else if (compiler.parser.state == PARSER_ERROR) {
+        fputs(string_cstr(compiler.parser.error.message), errors);
+        result = compiler.parser.error.scan ? COMPILE_SCAN_ERROR : COMPILE_PARSE_ERROR;
+    }
+    parser_destroy(&compiler.parser);
+    scanner_destroy(scanner);
     return result;
 }
 
-#pragma endregion
+static void expression(Compiler *compiler) {
+    parse_precedence(compiler, PREC_ASSIGNMENT);
+}
 
-#pragma region Private
+// Parses an operand and then every infix operator binding at least as tightly as `precedence`.
+// Operators of equal precedence are consumed by the loop rather than by recursion, so long chains
+// like `1 + 2 + ... + n` use constant native stack.
+static void parse_precedence(Compiler *compiler, Precedence precedence) {
+    Parser *parser = &compiler->parser;
+    parser_advance(parser);
+    ParseFn prefix = rules[parser->previous.type].prefix;
+    if (prefix == NULL) {
+        parser_error_at(parser, &parser->previous, "Expect expression.");
+        return;
+    }
+    prefix(compiler);
 
-static void advance(Parser *parser) {
-    parser->previous = parser->current;
+    while (precedence <= rules[parser->current.type].precedence) {
+        parser_advance(parser);
+        rules[parser->previous.type].infix(compiler);
+    }
+}
 
-    for (;;) {
-        parser->current = scanner_scan(parser->scanner);
-        if (parser->current.type != TOKEN_ERROR)
-            break;
-        parser->error = parse_error(parser, parser->current);
+static void number(Compiler *compiler) {
+    Token *token = &compiler->parser.previous;
+    double value;
+    if (number_parse(token->start, token->length, &value)) {
+        emit_constant(compiler, NUMBER_VAL(value));
+        return;
     }
+    // The token is a slice of the source, so it is copied to be terminated where the token ends.
+    char inline_buffer[MAX_INLINE_NUMBER_LENGTH];
+    char *buffer = inline_buffer;
+    if (token->length >= MAX_INLINE_NUMBER_LENGTH) {
+        buffer = (char *)allocator_alloc(compiler->parser.alloc, token->length + 1);
+    }
+    memcpy(buffer, token->start, token->length);
+    buffer[token->length] = '\0';
+    value = strtod(buffer, NULL);
+    if (buffer != inline_buffer) {
+        allocator_free(compiler->parser.alloc, buffer);
+    }
+    emit_constant(compiler, NUMBER_VAL(value));
 }
 
-static void expression(Parser *parser) {
-    (void)parser;
-    // TODO
+static void literal(Compiler *compiler) {
+    switch (compiler->parser.previous.type) {
+    case TOKEN_FALSE:
+        emit_constant(compiler, BOOL_VAL(false));
+        break;
+    case TOKEN_NIL:
+        emit_constant(compiler, NIL_VAL);
+        break;
+    case TOKEN_TRUE:
+        emit_constant(compiler, BOOL_VAL(true));
+        break;
+    default:
+        Unreachable();
+    }
 }
 
-static void consume(Parser *parser, TokenType expected, const char *message) {
-    (void)parser;
-    (void)expected;
-    (void)message;
-    // TODO
+static void grouping(Compiler *compiler) {
+    if (!enter(compiler)) {
+        return;
+    }
+    expression(compiler);
+    parser_consume(&compiler->parser, TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
+    compiler->depth--;
 }
 
-static ParseError parse_error(Parser *parser, Token token) {
-    Assert(token.type == TOKEN_ERROR);
-    String *error = string_dup_cstr(parser->alloc, token.start);
-    return (ParseError){
-        .line = token.line,
-        .reason = error->data,
-    };
+static void unary(Compiler *compiler) {
+    Token operator = compiler->parser.previous;
+    int line = parser_line(&compiler->parser, &operator);
+    if (!enter(compiler)) {
+        return;
+    }
+    parse_precedence(compiler, PREC_UNARY);
+    compiler->depth--;
+
+    switch (operator.type) {
+    case TOKEN_MINUS:
+        OpCodeChunk_write_code(compiler->chunk, OP_NEGATE, line);
+        break;
+    default:
+        Unreachable();
+    }
 }
 
-#pragma endregion
+static void binary(Compiler *compiler) {
+    Token operator = compiler->parser.previous;
+    int line = parser_line(&compiler->parser, &operator);
+    // The right operand binds one level tighter, which makes these operators left-associative.
+    parse_precedence(compiler, rules[operator.type].precedence + 1);
+
+    switch (operator.type) {
+    case TOKEN_PLUS:
+        OpCodeChunk_write_code(compiler->chunk, OP_ADD, line);
+        break;
+    case TOKEN_MINUS:
+        OpCodeChunk_write_code(compiler->chunk, OP_SUBTRACT, line);
+        break;
+    case TOKEN_STAR:
+        OpCodeChunk_write_code(compiler->chunk, OP_MULTIPLY, line);
+        break;
+    case TOKEN_SLASH:
+        OpCodeChunk_write_code(compiler->chunk, OP_DIVIDE, line);
+        break;
+    default:
+        Unreachable();
+    }
+}
+
+// Enters a nested rule, reporting an error instead if that would nest too deeply.
+static bool enter(Compiler *compiler) {
+    if (compiler->depth == MAX_NESTING_DEPTH) {
+        parser_error_at(&compiler->parser, &compiler->parser.previous,
+                        "Expression nested too deeply.");
+        return false;
+    }
+    compiler->depth++;
+    return true;
+}
+
+static void emit_code(Compiler *compiler, OpCode code) {
+    OpCodeChunk_write_code(compiler->chunk, code,
+                           parser_line(&compiler->parser, &compiler->parser.previous));
+}
+
+static void emit_constant(Compiler *compiler, Value value) {
+    if (vector_len(&compiler->chunk->constants.values) >= UINT24_MAX) {
+        parser_error_at(&compiler->parser, &compiler->parser.previous,
+                        "Too many constants in one chunk.");
+        return;
+    }
+    OpCodeChunk_write_constant(compiler->chunk, value,
+                               parser_line(&compiler->parser, &compiler->parser.previous));
+}
+
+#pragma endregion
\ No newline at end of file
@@ -1,14 +1,21 @@
 #ifndef clox_compiler_h
 #define clox_compiler_h
 
+#include <stdio.h>
+
 #include "allocator.h"
+#include "instruction.h"
+#include "source_stream.h"
 
 typedef enum CompileResult {
     COMPILE_OK,
     COMPILE_SCAN_ERROR,
     COMPILE_PARSE_ERROR,
+    COMPILE_READ_ERROR,
 } CompileResult;
 
-CompileResult compile(Allocator *alloc, const char *source);
+CompileResult compile(Allocator *alloc, const char *source, OpCodeChunk *chunk, FILE *errors);
+CompileResult compile_stream(Allocator *alloc, SourceStream *stream, OpCodeChunk *chunk,
+                             FILE *errors);
 
 #endif
\ No newline at end of file
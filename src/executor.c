@@ -0,0 +1,226 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "executor.h"
+#include "source_file.h"
+
+#pragma region Declare
+
+static void *worker_main(void *arg);
+static bool take_local(Worker *worker, int *job);
+static bool steal(Worker *worker, int *job);
+static void run_job(Worker *worker, Job *job);
+static bool load_source(SourceFile *file, Allocator *alloc, const char *path, FILE *errors);
+
+#pragma endregion
+
+#pragma region Public
+
+void executor_init(Executor *executor, Allocator *alloc, Logger *logger, int num_workers) {
+    Assert(num_workers >= 1 && num_workers <= EXECUTOR_MAX_WORKERS);
+    *executor = (Executor){
+        .num_workers = num_workers,
+        .alloc = alloc,
+        .logger = logger,
+        .stack_limit = DEFAULT_STACK_LIMIT,
+        .jit = false,
+        .cache_size = 0,
+        .fuel = FUEL_UNLIMITED,
+    };
+    // Workers hold their allocator by address (in their VM), so the array is never reallocated.
+    executor->workers = (Worker *)allocator_alloc(alloc, sizeof(Worker) * num_workers);
+    for (int i = 0; i < num_workers; i++) {
+        Worker *worker = &executor->workers[i];
+        *worker = (Worker){ .executor = executor, .index = i, .seed = (unsigned)i * 2654435761u };
+        pthread_mutex_init(&worker->lock, NULL);
+        allocator_init(&worker->alloc, logger);
+        virtual_machine_init(&worker->vm, &worker->alloc);
+        worker->vm.output = NULL;
+    }
+}
+
+// Runs every job to completion and fills in its result. Returns false if the threads could not be
+// started, in which case no job has run.
+bool executor_run(Executor *executor, Job *jobs, int num_jobs) {
+    executor->jobs = jobs;
+    executor->num_jobs = num_jobs;
+    // Contiguous, near-equal ranges keep each worker's jobs adjacent in the caller's array.
+    for (int i = 0; i < executor->num_workers; i++) {
+        Worker *worker = &executor->workers[i];
+        worker->begin = (int)((long)num_jobs * i / executor->num_workers);
+        worker->end = (int)((long)num_jobs * (i + 1) / executor->num_workers);
+        worker->completed = 0;
+        worker->stolen = 0;
+        worker->vm.stack_limit = executor->stack_limit;
+        worker->vm.jit = executor->jit;
+        if (executor->cache_size > 0 && worker->vm.cache == NULL) {
+            chunk_cache_init(&worker->cache, &worker->alloc, executor->cache_size);
+            worker->vm.cache = &worker->cache;
+        }
+    }
+
+    int started = 0;
+    for (; started < executor->num_workers; started++) {
+        Worker *worker = &executor->workers[started];
+        if (pthread_create(&worker->thread, NULL, worker_main, worker) != 0) {
+            break;
+        }
+    }
+    if (started < executor->num_workers) {
+        // Empty every deque so the workers already running stop after their current job.
+        for (int i = 0; i < executor->num_workers; i++) {
+            Worker *worker = &executor->workers[i];
+            pthread_mutex_lock(&worker->lock);
+            worker->begin = worker->end;
+            pthread_mutex_unlock(&worker->lock);
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(executor->workers[i].thread, NULL);
+    }
+    return started == executor->num_workers;
+}
+
+// The number of workers to use when none is requested: one per online processor.
+int executor_default_workers(void) {
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    if (processors < 1) {
+        return 1;
+    }
+    return processors > EXECUTOR_MAX_WORKERS ? EXECUTOR_MAX_WORKERS : (int)processors;
+}
+
+void executor_destroy(Executor *executor) {
+    for (int i = 0; i < executor->num_workers; i++) {
+        Worker *worker = &executor->workers[i];
+        if (worker->vm.cache != NULL) {
+            chunk_cache_destroy(&worker->cache);
+        }
+        virtual_machine_destroy(&worker->vm);
+        allocator_destroy(&worker->alloc);
+        pthread_mutex_destroy(&worker->lock);
+    }
+    allocator_free(executor->alloc, executor->workers);
+    *executor = (Executor){ 0 };
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static void *worker_main(void *arg) {
+    Worker *worker = (Worker *)arg;
+    int job;
+    while (take_local(worker, &job) || steal(worker, &job)) {
+        run_job(worker, &worker->executor->jobs[job]);
+    }
+    DEBUG(worker->executor->logger, "worker %d finished (completed=%zu, stolen=%zu)", worker->index,
+          worker->completed, worker->stolen);
+    return NULL;
+}
+
+// Takes the most recently queued job from the back of the worker's own deque.
+static bool take_local(Worker *worker, int *job) {
+    pthread_mutex_lock(&worker->lock);
+    bool found = worker->begin < worker->end;
+    if (found) {
+        *job = --worker->end;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return found;
+}
+
+// Takes the front half of the first non-empty deque found, starting from a random victim. One of the
+// stolen jobs is returned to run and the rest become the worker's own deque. Jobs are never added
+// once the executor starts, so finding every deque empty means there is no work left.
+static bool steal(Worker *worker, int *job) {
+    Executor *executor = worker->executor;
+    int start = (int)(rand_r(&worker->seed) % (unsigned)executor->num_workers);
+    for (int i = 0; i < executor->num_workers; i++) {
+        Worker *victim = &executor->workers[(start + i) % executor->num_workers];
+        if (victim == worker) {
+            continue;
+        }
+        pthread_mutex_lock(&victim->lock);
+        int available = victim->end - victim->begin;
+        int begin = victim->begin;
+        int count = (available + 1) / 2;
+        victim->begin += count;
+        pthread_mutex_unlock(&victim->lock);
+        if (count == 0) {
+            continue;
+        }
+
+        worker->stolen += count;
+        *job = begin;
+        pthread_mutex_lock(&worker->lock);
+        worker->begin = begin + 1;
+        worker->end = begin + count;
+        pthread_mutex_unlock(&worker->lock);
+        return true;
+    }
+    return false;
+}
+
+// Runs the job with its reports going to a buffer of its own, which is kept in the job if anything
+// was reported.
+static void run_job(Worker *worker, Job *job) {
+    job->worker = worker->index;
+    char *reported = NULL;
+    size_t reported_length = 0;
+    FILE *errors = open_memstream(&reported, &reported_length);
+    if (errors == NULL) {
+        errors = stderr; // reported as it happens, unattributed, rather than lost
+    }
+    const char *source = job->source;
+    SourceFile file = { 0 };
+    if (source == NULL) {
+        if (load_source(&file, &worker->alloc, job->name, errors)) {
+            source = file.source;
+        } else {
+            job->read_failed = true;
+        }
+    }
+    if (source != NULL) {
+        worker->vm.fuel = worker->executor->fuel;
+        worker->vm.errors = errors;
+        job->result = interpret(&worker->vm, source);
+        job->value = job->result == INTERPRET_OK ? worker->vm.result : NIL_VAL;
+        worker->vm.errors = stderr;
+    }
+    source_file_destroy(&file);
+    if (errors != stderr) {
+        fclose(errors);
+        if (reported_length > 0) {
+            job->errors = string_dup_cstr(&worker->alloc, reported);
+        }
+        free(reported);
+    }
+    worker->completed++;
+}
+
+// Maps a whole file, or reads it if it can't be mapped, using the worker's allocator. Returns false
+// (having reported why to `errors`) if the file can't be loaded.
+static bool load_source(SourceFile *file, Allocator *alloc, const char *path, FILE *errors) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(errors, "failed to open: %s\n", strerror(errno));
+        return false;
+    }
+    bool loaded = source_file_map(file, alloc, fd)
+                  || (errno == ENODEV && source_file_read(file, alloc, fd));
+    int error = errno;
+    close(fd);
+    if (!loaded) {
+        fprintf(errors, "failed to read: %s\n", strerror(error));
+    }
+    return loaded;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef clox_executor_h
+#define clox_executor_h
+
+#include <pthread.h>
+#include <stddef.h>
+
+#include "allocator.h"
+#include "array.h"
+#include "chunk_cache.h"
+#include "common.h"
+#include "logging.h"
+#include "value.h"
+#include "vm.h"
+
+/**
+ * Runs independent scripts on a fixed-size pool of threads.
+ * Every worker owns an Allocator and a VirtualMachine, so scripts never share mutable state and
+ * workers only synchronise to take jobs. The jobs are split evenly between the workers' deques up
+ * front; a worker takes its own jobs from the back of its deque, and once it runs dry steals the
+ * front half of another worker's deque, so uneven scripts don't leave threads idle.
+ *
+ * Nothing process-wide (disassembly, profiling, sampling or tracing) is attached to the VMs, and
+ * what a job reports is buffered rather than written as it runs, so that jobs running at once don't
+ * interleave their errors.
+ */
+
+#define EXECUTOR_MAX_WORKERS 256
+
+typedef struct Job {
+    const char *name;   // for reporting; also the path read when `source` is NULL
+    const char *source; // the script, or NULL to read it from `name`
+    bool read_failed;   // the script could not be read (`result` is then meaningless)
+    InterpretResult result;
+    Value value;    // what the script returned when result is INTERPRET_OK
+    String *errors; // the read, compile or runtime errors the job reported, or NULL if none;
+                    // it belongs to the executor and lasts until executor_destroy
+    int worker;     // the index of the worker which ran the job
+} Job;
+
+struct Executor;
+
+typedef struct Worker {
+    struct Executor *executor;
+    int index;
+    pthread_t thread;
+    pthread_mutex_t lock; // guards begin and end
+    int begin;            // the deque of job indices [begin, end); thieves take from the front
+    int end;
+    Allocator alloc;
+    VirtualMachine vm;
+    ChunkCache cache; // used by vm when the executor has a cache size
+    size_t completed; // jobs run by this worker
+    size_t stolen;    // jobs taken from other workers
+    unsigned seed;    // picks victims to steal from
+} Worker;
+
+typedef struct Executor {
+    Worker *workers;
+    int num_workers;
+    Job *jobs;
+    int num_jobs;
+    Allocator *alloc;
+    Logger *logger;
+    int stack_limit; // applied to every worker's VM
+    bool jit;        // applied to every worker's VM
+    size_t cache_size; // the bound on each worker's chunk cache (0 to not cache chunks)
+    int64_t fuel;      // the instruction budget of each job (FUEL_UNLIMITED by default)
+} Executor;
+
+void executor_init(Executor *executor, Allocator *alloc, Logger *logger, int num_workers);
+bool executor_run(Executor *executor, Job *jobs, int num_jobs);
+int executor_default_workers(void);
+void executor_destroy(Executor *executor);
+
+#endif
\ No newline at end of file
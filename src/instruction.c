@@ -10,6 +10,7 @@
 
 #define DEFAULT_OPCODE_CAPACITY 32
 #define DEFAULT_VALUE_CAPACITY  32
+#define DISASSEMBLY_CAPACITY    4096
 
 #pragma region Declare
 
@@ -17,17 +18,18 @@ static int opcode_write(OpCodeArray *array, uint8_t *bytes, size_t count);
 static uint8_t *opcode_at(OpCodeArray *array, int index);
 static int line_number_write(LineNumberArray *array, int line, size_t size);
 static int line_number_for(OpCodeChunk *chunk, int offset);
-static inline int simple_instruction(OpCodeChunk *chunk, FILE *out, OpCode code, int offset);
-static inline int constant_instruction(OpCodeChunk *chunk, FILE *out, OpCode code, int offset);
+static String *instruction_repr(OpCodeChunk *chunk, String *out, int offset, int line,
+                               bool same_line);
+static inline int instruction_size(uint8_t code);
+static inline String *simple_instruction(OpCodeChunk *chunk, String *out, OpCode code);
+static inline String *constant_instruction(OpCodeChunk *chunk, String *out, OpCode code,
+                                           int offset);
+static inline String *column_instruction(OpCodeChunk *chunk, String *out, int offset);
 
 #pragma endregion
 
 #pragma region Public
 
-void value_write_repr(Value *value, FILE *out) {
-    fprintf(out, "Value(%g)", *value);
-}
-
 int value_write(ValueArray *array, Value value) {
     vector_append(&array->values, (void *)&value);
     return vector_len(&array->values) - 1;
@@ -39,41 +41,32 @@ Value *value_at(ValueArray *array, int index) {
     return ptr;
 }
 
-int opcode_chunk_instruction_write_repr(OpCodeChunk *chunk, FILE *out, int offset) {
-    fprintf(out, "%04d ", offset);
+String *opcode_chunk_instruction_repr(OpCodeChunk *chunk, String *out, int offset) {
     int prev_line = line_number_for(chunk, offset - 1);
     int cur_line = line_number_for(chunk, offset);
-    if (offset > 0 && prev_line == cur_line) {
-        fprintf(out, "   | ");
-    } else {
-        fprintf(out, "%4d ", cur_line);
-    }
-    uint8_t code = *opcode_at(&chunk->codes, offset);
-    switch (code) {
-    case OP_CONSTANT_LONG:
-    case OP_CONSTANT:
-        return constant_instruction(chunk, out, code, offset);
-    case OP_ADD:
-    case OP_SUBTRACT:
-    case OP_MULTIPLY:
-    case OP_DIVIDE:
-    case OP_NEGATE:
-    case OP_RETURN:
-        return simple_instruction(chunk, out, code, offset);
-    default:
-        Panicf("Unknown opcode %d", code);
-    }
+    return instruction_repr(chunk, out, offset, cur_line, offset > 0 && prev_line == cur_line);
+}
+
+int opcode_chunk_line_at(OpCodeChunk *chunk, int offset) {
+    return line_number_for(chunk, offset);
 }
 
 void opcode_chunk_init(OpCodeChunk *chunk, Allocator *alloc) {
     chunk->alloc = alloc;
     vector_init(&chunk->codes.codes, alloc, DEFAULT_OPCODE_CAPACITY, sizeof(uint8_t));
-    vector_init(&chunk->lines.encodings, alloc, DEFAULT_OPCODE_CAPACITY, sizeof(uint8_t));
+    vector_init(&chunk->lines.encodings, alloc, DEFAULT_LINE_NUMBER_ARRAY_CAPACITY,
+                sizeof(LineNumberEncoding));
     vector_init(&chunk->constants.values, alloc, DEFAULT_VALUE_CAPACITY, sizeof(Value));
     // Lazy initialize long_constants since its unlikely to be used
     chunk->long_constants = (ValueArray){ 0 };
 }
 
+// Presizes the chunk for the given number of bytecode bytes and constants.
+void opcode_chunk_reserve(OpCodeChunk *chunk, size_t code_bytes, size_t constants) {
+    vector_reserve(&chunk->codes.codes, code_bytes);
+    vector_reserve(&chunk->constants.values, constants);
+}
+
 int OpCodeChunk_write_code(OpCodeChunk *chunk, uint8_t code, int line) {
     line_number_write(&chunk->lines, line, opcode_size(code));
     return opcode_write(&chunk->codes, &code, 1);
@@ -108,12 +101,40 @@ int OpCodeChunk_write_constant(OpCodeChunk *chunk, Value value, int line) {
     Unreachable();
 }
 
+int OpCodeChunk_write_column(OpCodeChunk *chunk, uint8_t column, int line) {
+    uint8_t code[2] = { OP_COLUMN, column };
+    line_number_write(&chunk->lines, line, sizeof(code));
+    return opcode_write(&chunk->codes, code, sizeof(code));
+}
+
+// Disassembles the chunk into a single buffer which is written out all at once.
 void opcode_chunk_write_repr(OpCodeChunk *chunk, FILE *out, const char *name) {
-    fprintf(out, "== OpCodeChunk(%s) ==\n", name);
-    for (size_t offset = 0; offset < vector_len(&chunk->codes.codes);) {
-        offset = opcode_chunk_instruction_write_repr(chunk, out, offset);
-        fputc('\n', out);
+    String *repr = opcode_chunk_repr(chunk, string_create(chunk->alloc, DISASSEMBLY_CAPACITY), name);
+    fwrite(repr->data, sizeof(char), repr->length, out);
+    string_destroy(repr, chunk->alloc);
+}
+
+String *opcode_chunk_repr(OpCodeChunk *chunk, String *out, const char *name) {
+    out = string_appendf(out, chunk->alloc, "== OpCodeChunk(%s) ==\n", name);
+    int length = vector_len(&chunk->codes.codes);
+    int num_encodings = vector_len(&chunk->lines.encodings);
+    LineNumberEncoding *encodings = (LineNumberEncoding *)chunk->lines.encodings.data->data;
+
+    // Walk the run-length encoded line table in lockstep with the code rather than searching it
+    // for every instruction.
+    int encoding = 0, encoding_end = num_encodings > 0 ? encodings[0].size_count : length;
+    int prev_line = -1;
+    for (int offset = 0; offset < length;) {
+        while (encoding + 1 < num_encodings && offset >= encoding_end) {
+            encoding_end += encodings[++encoding].size_count;
+        }
+        int line = num_encodings > 0 ? encodings[encoding].line : -1;
+        out = instruction_repr(chunk, out, offset, line, offset > 0 && prev_line == line);
+        out = string_appendf(out, chunk->alloc, "\n");
+        offset += instruction_size(chunk->codes.codes.data->data[offset]);
+        prev_line = line;
     }
+    return out;
 }
 
 void opcode_chunk_destroy(OpCodeChunk *chunk) {
@@ -167,21 +188,78 @@ static int line_number_for(OpCodeChunk *chunk, int offset) {
     Unreachable();
 }
 
-static inline int simple_instruction(OpCodeChunk *chunk, FILE *out, OpCode code, int offset) {
-    (void)chunk;
-    fprintf(out, "%s", opcode_name(code));
-    return offset + 1;
+static String *instruction_repr(OpCodeChunk *chunk, String *out, int offset, int line,
+                               bool same_line) {
+    out = string_appendf(out, chunk->alloc, "%04d ", offset);
+    if (same_line) {
+        out = string_appendf(out, chunk->alloc, "   | ");
+    } else {
+        out = string_appendf(out, chunk->alloc, "%4d ", line);
+    }
+    uint8_t code = *opcode_at(&chunk->codes, offset);
+    switch (code) {
+    case OP_CONSTANT_LONG:
+    case OP_CONSTANT:
+        return constant_instruction(chunk, out, code, offset);
+    case OP_COLUMN:
+        return column_instruction(chunk, out, offset);
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_NEGATE:
+    case OP_RETURN:
+        return simple_instruction(chunk, out, code);
+    default:
+        // Disassembly runs before verification, so render unknown bytes instead of panicking.
+        return string_appendf(out, chunk->alloc, "<unknown opcode %d>", code);
+    }
+}
+
+static inline int instruction_size(uint8_t code) {
+    switch (code) {
+    case OP_CONSTANT:
+    case OP_CONSTANT_LONG:
+    case OP_COLUMN:
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_NEGATE:
+    case OP_RETURN:
+        return opcode_size(code);
+    default:
+        return 1;
+    }
 }
 
-static inline int constant_instruction(OpCodeChunk *chunk, FILE *out, OpCode code, int offset) {
+static inline String *simple_instruction(OpCodeChunk *chunk, String *out, OpCode code) {
+    return string_appendf(out, chunk->alloc, "%s", opcode_name(code));
+}
+
+static inline String *constant_instruction(OpCodeChunk *chunk, String *out, OpCode code,
+                                           int offset) {
+    int length = vector_len(&chunk->codes.codes);
+    if (offset + opcode_size(code) > length) {
+        return string_appendf(out, chunk->alloc, "%-16s <truncated>", opcode_name(code));
+    }
     uint32_t index = code == OP_CONSTANT_LONG ? *opcode_at(&chunk->codes, offset + 1) << 16
                                                     | *opcode_at(&chunk->codes, offset + 2) << 8
                                                     | *opcode_at(&chunk->codes, offset + 3)
                                               : *opcode_at(&chunk->codes, offset + 1);
-    fprintf(out, "%-16s %4d ", opcode_name(code), index);
-    Value value = *value_at(&chunk->constants, index);
-    value_write_repr(&value, out);
-    return offset + opcode_size(code);
+    out = string_appendf(out, chunk->alloc, "%-16s %4d ", opcode_name(code), index);
+    if (index >= vector_len(&chunk->constants.values)) {
+        return string_appendf(out, chunk->alloc, "<invalid constant>");
+    }
+    return value_repr(*value_at(&chunk->constants, index), out, chunk->alloc);
+}
+
+static inline String *column_instruction(OpCodeChunk *chunk, String *out, int offset) {
+    if (offset + opcode_size(OP_COLUMN) > (int)vector_len(&chunk->codes.codes)) {
+        return string_appendf(out, chunk->alloc, "%-16s <truncated>", opcode_name(OP_COLUMN));
+    }
+    return string_appendf(out, chunk->alloc, "%-16s %4d", opcode_name(OP_COLUMN),
+                          *opcode_at(&chunk->codes, offset + 1));
 }
 
 #pragma endregion
\ No newline at end of file
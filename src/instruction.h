@@ -5,6 +5,7 @@
 
 #include "assert.h"
 #include "common.h"
+#include "value.h"
 #include "vector.h"
 
 #define DEFAULT_LINE_NUMBER_ARRAY_CAPACITY 32
@@ -17,6 +18,9 @@ typedef enum {
     // Store a constant value in the constant pool.
     // The next 3 bytes are the index of the constant in the constant pool.
     OP_CONSTANT_LONG,
+    // Push the current row's value of an input column (see VirtualMachine.inputs and batch.h).
+    // The next byte is the index of the column.
+    OP_COLUMN,
     // Binary addition
     OP_ADD,
     // Binary subtraction
@@ -29,18 +33,24 @@ typedef enum {
     OP_NEGATE,
     // Pop the top value from the stack and print it.
     OP_RETURN,
+
+    // Quickened forms of the arithmetic instructions, specialised for number operands. They never
+    // appear in a chunk: the VM rewrites its decoded instructions into them once it has seen
+    // numbers, and back again if an operand is anything else (see vm.c).
+    OP_ADD_NUM,
+    OP_SUBTRACT_NUM,
+    OP_MULTIPLY_NUM,
+    OP_DIVIDE_NUM,
+    OP_NEGATE_NUM,
 } OpCode;
 
+// The number of opcodes, for tables indexed by opcode. Must follow the last opcode above.
+#define NUM_OPCODES (OP_NEGATE_NUM + 1)
+
 typedef struct OpCodeArray {
     Vector codes;
 } OpCodeArray;
 
-/**
- * Temporary typedef for the Value type.
- * (wip) This will be replaced with a more complex type.
- */
-typedef double Value;
-
 typedef struct ValueArray {
     Vector values;
 } ValueArray;
@@ -62,13 +72,18 @@ typedef struct OpCodeChunk {
     Allocator *alloc;
 } OpCodeChunk;
 
-void value_write_repr(Value *value, FILE *out);
 int value_write(ValueArray *array, Value value);
 Value *value_at(ValueArray *array, int index);
 
 void opcode_chunk_init(OpCodeChunk *chunk, Allocator *alloc);
+void opcode_chunk_reserve(OpCodeChunk *chunk, size_t code_bytes, size_t constants);
+int OpCodeChunk_write_code(OpCodeChunk *chunk, uint8_t code, int line);
+int OpCodeChunk_write_constant(OpCodeChunk *chunk, Value value, int line);
+int OpCodeChunk_write_column(OpCodeChunk *chunk, uint8_t column, int line);
 void opcode_chunk_write_repr(OpCodeChunk *chunk, FILE *out, const char *name);
-int opcode_chunk_instruction_write_repr(OpCodeChunk *chunk, FILE *out, int offset);
+String *opcode_chunk_repr(OpCodeChunk *chunk, String *out, const char *name);
+String *opcode_chunk_instruction_repr(OpCodeChunk *chunk, String *out, int offset);
+int opcode_chunk_line_at(OpCodeChunk *chunk, int offset);
 void opcode_chunk_destroy(OpCodeChunk *chunk);
 
 static inline const char *opcode_name(OpCode code) {
@@ -77,6 +92,8 @@ static inline const char *opcode_name(OpCode code) {
         return "OP_CONSTANT";
     case OP_CONSTANT_LONG:
         return "OP_CONSTANT_LONG";
+    case OP_COLUMN:
+        return "OP_COLUMN";
     case OP_ADD:
         return "OP_ADD";
     case OP_SUBTRACT:
@@ -89,6 +106,16 @@ static inline const char *opcode_name(OpCode code) {
         return "OP_NEGATE";
     case OP_RETURN:
         return "OP_RETURN";
+    case OP_ADD_NUM:
+        return "OP_ADD_NUM";
+    case OP_SUBTRACT_NUM:
+        return "OP_SUBTRACT_NUM";
+    case OP_MULTIPLY_NUM:
+        return "OP_MULTIPLY_NUM";
+    case OP_DIVIDE_NUM:
+        return "OP_DIVIDE_NUM";
+    case OP_NEGATE_NUM:
+        return "OP_NEGATE_NUM";
     default:
         Panicf("Unknown opcode %d", code);
     }
@@ -97,6 +124,7 @@ static inline const char *opcode_name(OpCode code) {
 static inline int opcode_size(OpCode code) {
     switch (code) {
     case OP_CONSTANT:
+    case OP_COLUMN:
         return 2;
     case OP_CONSTANT_LONG:
         return 4;
@@ -106,6 +134,60 @@ static inline int opcode_size(OpCode code) {
     case OP_DIVIDE:
     case OP_NEGATE:
     case OP_RETURN:
+    case OP_ADD_NUM:
+    case OP_SUBTRACT_NUM:
+    case OP_MULTIPLY_NUM:
+    case OP_DIVIDE_NUM:
+    case OP_NEGATE_NUM:
+        return 1;
+    default:
+        Panicf("Unknown opcode %d", code);
+    }
+}
+
+// The number of values an instruction pops off the stack before pushing its result.
+static inline int opcode_stack_pops(OpCode code) {
+    switch (code) {
+    case OP_CONSTANT:
+    case OP_CONSTANT_LONG:
+    case OP_COLUMN:
+        return 0;
+    case OP_NEGATE:
+    case OP_NEGATE_NUM:
+    case OP_RETURN:
+        return 1;
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_ADD_NUM:
+    case OP_SUBTRACT_NUM:
+    case OP_MULTIPLY_NUM:
+    case OP_DIVIDE_NUM:
+        return 2;
+    default:
+        Panicf("Unknown opcode %d", code);
+    }
+}
+
+// The number of values an instruction pushes onto the stack after popping its operands.
+static inline int opcode_stack_pushes(OpCode code) {
+    switch (code) {
+    case OP_RETURN:
+        return 0;
+    case OP_CONSTANT:
+    case OP_CONSTANT_LONG:
+    case OP_COLUMN:
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_NEGATE:
+    case OP_ADD_NUM:
+    case OP_SUBTRACT_NUM:
+    case OP_MULTIPLY_NUM:
+    case OP_DIVIDE_NUM:
+    case OP_NEGATE_NUM:
         return 1;
     default:
         Panicf("Unknown opcode %d", code);
@@ -0,0 +1,202 @@
+#define _DEFAULT_SOURCE
+
+#include <string.h>
+
+#include "jit.h"
+
+#ifdef JIT_SUPPORTED
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+// The longest template (OP_NEGATE) is 20 bytes for a single byte of bytecode, which bounds the size
+// of the generated code per byte of bytecode.
+#define MAX_TEMPLATE_SIZE 20
+
+#define SCRATCH_REGISTER 15
+#define SIGN_MASK        0x8000000000000000ULL
+
+// Second opcode bytes (after 0x0F) of the SSE2 instructions used by the templates.
+#define SSE_MOVAPD 0x28
+#define SSE_XORPD  0x57
+#define SSE_ADDSD  0x58
+#define SSE_MULSD  0x59
+#define SSE_SUBSD  0x5C
+#define SSE_DIVSD  0x5E
+#define SSE_MOVQ   0x6E
+
+typedef struct Emitter {
+    uint8_t *code;
+    size_t length;
+} Emitter;
+
+#pragma region Declare
+
+static JitResult translate(OpCodeChunk *chunk, int code_length, Emitter *emitter);
+static inline void emit(Emitter *emitter, uint8_t byte);
+static inline void emit_sse(Emitter *emitter, uint8_t prefix, uint8_t opcode, int dst, int src);
+static inline void emit_load_immediate(Emitter *emitter, int dst, uint64_t bits);
+static inline void emit_binary(Emitter *emitter, uint8_t opcode, int *depth);
+
+#pragma endregion
+
+#pragma region Public
+
+// Compiles the first `code_length` bytes of a verified chunk, which must end in OP_RETURN.
+JitResult jit_compile(OpCodeChunk *chunk, int code_length, int max_stack_depth, JitCode *code) {
+    *code = (JitCode){ 0 };
+    if (max_stack_depth > JIT_MAX_STACK_DEPTH) {
+        return JIT_STACK_TOO_DEEP;
+    }
+
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t size = (size_t)code_length * MAX_TEMPLATE_SIZE;
+    size = (size + page_size - 1) / page_size * page_size;
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return JIT_MAP_FAILED;
+    }
+
+    Emitter emitter = { .code = (uint8_t *)memory, .length = 0 };
+    JitResult result = translate(chunk, code_length, &emitter);
+    Assert(emitter.length <= size);
+    if (result == JIT_OK && mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        result = JIT_MAP_FAILED;
+    }
+    if (result != JIT_OK) {
+        munmap(memory, size);
+        return result;
+    }
+
+    code->memory = memory;
+    code->size = size;
+    // ISO C has no conversion from object to function pointers; copy the representation instead.
+    memcpy(&code->entry, &memory, sizeof(code->entry));
+    return JIT_OK;
+}
+
+void jit_release(JitCode *code) {
+    if (code->memory != NULL) {
+        munmap(code->memory, code->size);
+    }
+    *code = (JitCode){ 0 };
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static JitResult translate(OpCodeChunk *chunk, int code_length, Emitter *emitter) {
+    uint8_t *bytes = chunk->codes.codes.data->data;
+    Value *constants = (Value *)chunk->constants.values.data->data;
+    int depth = 0;
+
+    for (int offset = 0; offset < code_length; offset += opcode_size(bytes[offset])) {
+        switch (bytes[offset]) {
+        case OP_CONSTANT:
+        case OP_CONSTANT_LONG: {
+            uint32_t index = bytes[offset] == OP_CONSTANT_LONG
+                                 ? (uint32_t)(bytes[offset + 1] << 16 | bytes[offset + 2] << 8
+                                              | bytes[offset + 3])
+                                 : bytes[offset + 1];
+            Value value = constants[index];
+            if (!IS_NUMBER(value)) {
+                return JIT_UNSUPPORTED_CONSTANT;
+            }
+            double number = AS_NUMBER(value);
+            uint64_t bits;
+            memcpy(&bits, &number, sizeof(bits));
+            emit_load_immediate(emitter, depth++, bits);
+            break;
+        }
+        case OP_ADD:
+            emit_binary(emitter, SSE_ADDSD, &depth);
+            break;
+        case OP_SUBTRACT:
+            emit_binary(emitter, SSE_SUBSD, &depth);
+            break;
+        case OP_MULTIPLY:
+            emit_binary(emitter, SSE_MULSD, &depth);
+            break;
+        case OP_DIVIDE:
+            emit_binary(emitter, SSE_DIVSD, &depth);
+            break;
+        case OP_NEGATE:
+            // xorpd xmm<top>, xmm15 where xmm15 holds the sign bit
+            emit_load_immediate(emitter, SCRATCH_REGISTER, SIGN_MASK);
+            emit_sse(emitter, 0x66, SSE_XORPD, depth - 1, SCRATCH_REGISTER);
+            break;
+        case OP_RETURN:
+            // The result is returned in xmm0 per the System V calling convention.
+            if (depth - 1 != 0) {
+                emit_sse(emitter, 0x66, SSE_MOVAPD, 0, depth - 1);
+            }
+            emit(emitter, 0xC3); // ret
+            return JIT_OK;
+        default:
+            return JIT_UNSUPPORTED_OPCODE;
+        }
+    }
+    Unreachable(); // verified chunks end in OP_RETURN
+}
+
+static inline void emit(Emitter *emitter, uint8_t byte) {
+    emitter->code[emitter->length++] = byte;
+}
+
+// Emits `<prefix> [REX] 0F <opcode> /r` operating on registers xmm<dst> and xmm<src>.
+static inline void emit_sse(Emitter *emitter, uint8_t prefix, uint8_t opcode, int dst, int src) {
+    emit(emitter, prefix);
+    if (dst >= 8 || src >= 8) {
+        emit(emitter, 0x40 | (dst >= 8) << 2 | (src >= 8));
+    }
+    emit(emitter, 0x0F);
+    emit(emitter, opcode);
+    emit(emitter, 0xC0 | (dst & 7) << 3 | (src & 7));
+}
+
+// Loads a 64-bit pattern into xmm<dst> through rax: `mov rax, imm64; movq xmm<dst>, rax`.
+static inline void emit_load_immediate(Emitter *emitter, int dst, uint64_t bits) {
+    if (bits == 0) {
+        emit_sse(emitter, 0x66, SSE_XORPD, dst, dst);
+        return;
+    }
+    emit(emitter, 0x48);
+    emit(emitter, 0xB8);
+    for (int i = 0; i < 8; i++) {
+        emit(emitter, (bits >> (8 * i)) & 0xff);
+    }
+    emit(emitter, 0x66);
+    emit(emitter, 0x48 | (dst >= 8) << 2);
+    emit(emitter, 0x0F);
+    emit(emitter, SSE_MOVQ);
+    emit(emitter, 0xC0 | (dst & 7) << 3);
+}
+
+// Emits `<op>sd xmm<top-1>, xmm<top>` and pops the right operand.
+static inline void emit_binary(Emitter *emitter, uint8_t opcode, int *depth) {
+    emit_sse(emitter, 0xF2, opcode, *depth - 2, *depth - 1);
+    (*depth)--;
+}
+
+#pragma endregion
+
+#else
+
+JitResult jit_compile(OpCodeChunk *chunk, int code_length, int max_stack_depth, JitCode *code) {
+    (void)chunk;
+    (void)code_length;
+    (void)max_stack_depth;
+    *code = (JitCode){ 0 };
+    return JIT_UNSUPPORTED_PLATFORM;
+}
+
+void jit_release(JitCode *code) {
+    *code = (JitCode){ 0 };
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,68 @@
+#ifndef clox_jit_h
+#define clox_jit_h
+
+#include <stddef.h>
+
+#include "allocator.h"
+#include "common.h"
+#include "instruction.h"
+
+/**
+ * Baseline template JIT for straight-line numeric chunks on x86-64.
+ * Each instruction is translated into a fixed native template. Stack slots are assigned to SSE
+ * registers at compile time (slot i lives in xmm<i>), so the generated code never touches the
+ * value stack: constants are loaded as 64-bit immediates and arithmetic runs on scalar doubles in
+ * registers. The code is written into an anonymous mapping which is made executable (and no longer
+ * writable) before it runs.
+ *
+ * Only chunks whose constants are all numbers and whose stack fits in the available registers are
+ * compiled; for everything else jit_compile reports why and the caller keeps interpreting.
+ */
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_SUPPORTED
+#endif
+
+#define JIT_MAX_STACK_DEPTH 15 // xmm0-xmm14; xmm15 is scratch
+
+typedef enum JitResult {
+    JIT_OK,
+    JIT_UNSUPPORTED_PLATFORM,
+    JIT_UNSUPPORTED_OPCODE,
+    JIT_UNSUPPORTED_CONSTANT,
+    JIT_STACK_TOO_DEEP,
+    JIT_MAP_FAILED,
+} JitResult;
+
+// Native code returning the number the chunk's OP_RETURN would print.
+typedef double (*JitFunction)(void);
+
+typedef struct JitCode {
+    void *memory;
+    size_t size;
+    JitFunction entry;
+} JitCode;
+
+JitResult jit_compile(OpCodeChunk *chunk, int code_length, int max_stack_depth, JitCode *code);
+void jit_release(JitCode *code);
+
+static inline const char *jit_result_name(JitResult result) {
+    switch (result) {
+    case JIT_OK:
+        return "JIT_OK";
+    case JIT_UNSUPPORTED_PLATFORM:
+        return "JIT_UNSUPPORTED_PLATFORM";
+    case JIT_UNSUPPORTED_OPCODE:
+        return "JIT_UNSUPPORTED_OPCODE";
+    case JIT_UNSUPPORTED_CONSTANT:
+        return "JIT_UNSUPPORTED_CONSTANT";
+    case JIT_STACK_TOO_DEEP:
+        return "JIT_STACK_TOO_DEEP";
+    case JIT_MAP_FAILED:
+        return "JIT_MAP_FAILED";
+    default:
+        Panicf("Unknown jit result %d", result);
+    }
+}
+
+#endif
\ No newline at end of file
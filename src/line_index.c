@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "assert.h"
+#include "line_index.h"
+
+#define MIN_CAPACITY 64
+// Lines to a block: 512 KB of offsets.
+#define BLOCK_BITS 16
+#define BLOCK_LINES ((size_t)1 << BLOCK_BITS)
+
+#pragma region Declare
+
+static void build(LineIndex *index);
+static size_t **add_block(LineIndex *index, size_t **blocks, size_t *capacity);
+static inline size_t line_start(LineIndex *index, size_t line);
+static size_t find(LineIndex *index, size_t offset);
+
+#pragma endregion
+
+#pragma region Public
+
+// Indexes `source`, which must outlive the index, the first time a line is asked for.
+void line_index_init(LineIndex *index, Allocator *alloc, const char *source, size_t length) {
+    *index = (LineIndex){ .source = source, .length = length, .alloc = alloc };
+}
+
+void line_index_destroy(LineIndex *index) {
+    if (index->blocks != NULL) {
+        for (size_t i = 0; i < index->num_blocks; i++) {
+            allocator_free(index->alloc, index->blocks[i]);
+        }
+        allocator_free(index->alloc, index->blocks);
+    }
+    *index = (LineIndex){ .alloc = index->alloc };
+}
+
+// Like line_index_line, for lookups the inlined check of the last line didn't answer.
+int line_index_find(LineIndex *index, size_t offset) {
+    return (int)find(index, offset) + 1;
+}
+
+// Returns the column of the byte at `offset` within its line, counting from 1.
+int line_index_column(LineIndex *index, size_t offset) {
+    find(index, offset);
+    return (int)(offset - index->cursor_start) + 1;
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static void build(LineIndex *index) {
+    size_t blocks_capacity = 0;
+    size_t **blocks = add_block(index, NULL, &blocks_capacity);
+    size_t *block = blocks[0];
+    size_t capacity = MIN_CAPACITY; // of the last block
+    size_t used = 0;                // of the last block
+    block[used++] = 0;
+    const char *end = index->source + index->length;
+    for (const char *ch = index->source; (ch = memchr(ch, '\n', end - ch)) != NULL;) {
+        if (used == capacity && capacity < BLOCK_LINES) {
+            block = (size_t *)allocator_realloc(index->alloc, block, capacity * sizeof(size_t),
+                                                capacity * 2 * sizeof(size_t));
+            blocks[0] = block;
+            capacity *= 2;
+        } else if (used == capacity) {
+            blocks = add_block(index, blocks, &blocks_capacity);
+            block = blocks[index->num_blocks - 1];
+            used = 0;
+        }
+        block[used++] = (size_t)(++ch - index->source);
+    }
+    index->blocks = blocks;
+    index->count = (index->num_blocks - 1) * BLOCK_LINES + used;
+    index->cursor = 0;
+    index->cursor_start = 0;
+    index->cursor_end = line_start(index, 1);
+}
+
+// Appends a block to `blocks`, the first at MIN_CAPACITY lines and any after it at BLOCK_LINES,
+// growing the array of blocks if it is full. Returns the array.
+static size_t **add_block(LineIndex *index, size_t **blocks, size_t *capacity) {
+    if (index->num_blocks == *capacity) {
+        size_t grown = *capacity == 0 ? 4 : *capacity * 2;
+        blocks = blocks == NULL
+                     ? (size_t **)allocator_alloc(index->alloc, grown * sizeof(size_t *))
+                     : (size_t **)allocator_realloc(index->alloc, blocks,
+                                                    *capacity * sizeof(size_t *),
+                                                    grown * sizeof(size_t *));
+        *capacity = grown;
+    }
+    size_t lines = index->num_blocks == 0 ? MIN_CAPACITY : BLOCK_LINES;
+    blocks[index->num_blocks++] = (size_t *)allocator_alloc(index->alloc, lines * sizeof(size_t));
+    return blocks;
+}
+
+// Returns the offset of the first byte of `line`, or SIZE_MAX for the line after the last, so that
+// it never holds an offset.
+static inline size_t line_start(LineIndex *index, size_t line) {
+    if (line >= index->count) {
+        return SIZE_MAX;
+    }
+    return index->blocks[line >> BLOCK_BITS][line & (BLOCK_LINES - 1)];
+}
+
+// Returns the line holding `offset`, counting from 0, and remembers it and its bounds for the next
+// lookup.
+static size_t find(LineIndex *index, size_t offset) {
+    Assert(offset <= index->length);
+    if (index->blocks == NULL) {
+        build(index);
+    }
+    size_t line = index->cursor;
+    if (index->cursor_start <= offset && offset < index->cursor_end) {
+        return line;
+    }
+    if (index->cursor_end <= offset && offset < line_start(index, line + 2)) {
+        line++;
+    } else {
+        // the last line starting at or before the offset
+        size_t low = 0, high = index->count - 1;
+        while (low < high) {
+            size_t middle = low + (high - low + 1) / 2;
+            if (line_start(index, middle) <= offset) {
+                low = middle;
+            } else {
+                high = middle - 1;
+            }
+        }
+        line = low;
+    }
+    index->cursor = line;
+    index->cursor_start = line_start(index, line);
+    index->cursor_end = line_start(index, line + 1);
+    return line;
+}
+
+#pragma endregion
\ No newline at end of file
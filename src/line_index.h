@@ -0,0 +1,47 @@
+#ifndef clox_line_index_h
+#define clox_line_index_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+
+/**
+ * Finds the line and column of a byte offset into a source.
+ * Tokens only carry their position in the source, so the scanner doesn't look for newlines at
+ * all. The first lookup indexes the start of every line with memchr, which searches a vector at a
+ * time; later lookups check the line of the one before and the line after it, which is where a
+ * walk through the source in order finds them, and otherwise binary search the index.
+ *
+ * The line starts are kept in blocks of a fixed number of lines rather than in one array, so that
+ * no allocation grows with the number of lines past the largest the allocator can make. Only the
+ * first block grows, so a short source doesn't take a whole block.
+ */
+
+typedef struct LineIndex {
+    const char *source;
+    size_t length;       // of the source
+    size_t **blocks;     // the offset of each line's first byte, in blocks; built on first lookup
+    size_t num_blocks;
+    size_t count;        // of lines
+    size_t cursor;       // the line of the last lookup, counting from 0
+    size_t cursor_start; // the offsets [start, end) of the cursor's line; empty until built
+    size_t cursor_end;
+    Allocator *alloc;
+} LineIndex;
+
+void line_index_init(LineIndex *index, Allocator *alloc, const char *source, size_t length);
+void line_index_destroy(LineIndex *index);
+int line_index_find(LineIndex *index, size_t offset);
+int line_index_column(LineIndex *index, size_t offset);
+
+// Returns the line holding the byte at `offset`, counting from 1. The end of the source is on the
+// last line. Lookups on the line of the one before are inlined.
+static inline int line_index_line(LineIndex *index, size_t offset) {
+    if (index->cursor_start <= offset && offset < index->cursor_end) {
+        return (int)index->cursor + 1;
+    }
+    return line_index_find(index, offset);
+}
+
+#endif
\ No newline at end of file
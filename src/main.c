@@ -1,13 +1,25 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "allocator.h"
+#include "chunk_cache.h"
 #include "common.h"
+#include "executor.h"
 #include "instruction.h"
 #include "logging.h"
+#include "profile.h"
 #include "program.h"
+#include "sampler.h"
+#include "source_file.h"
+#include "source_stream.h"
+#include "tracer.h"
 #include "vm.h"
 
 #define MAJOR_VERSION 0
@@ -20,8 +32,6 @@
 // STRINGIFY(PATCH_VERSION)
 #define SEMANTIC_VERSION "0.1.0"
 
-#define MAX_INPUT_FILE_BYTES 1024 * 1024
-
 #pragma region Declare
 
 #define EXIT(STATUS)                                                                               \
@@ -33,15 +43,45 @@
 static struct {
     const char *program;
     const char *input;
-    enum { REPL, EXEC } mode;
+    char **inputs; // every positional argument, for JOBS mode
+    int num_inputs;
+    int workers; // 0 to use one per processor
+    size_t cache_size;
+    int64_t max_instructions; // per script (or REPL line), or FUEL_UNLIMITED
+    enum { REPL, EXEC, JOBS } mode;
     bool debug;
     bool trace;
+    bool disassemble;
+    const char *disassemble_path;
+    FILE *disassembly;
+    int stack_limit;
+    bool profile;
+    Profile profiler;
+    const char *sample_path;
+    const char *exec_trace_path;
+    bool exec_trace_always;
+    Tracer tracer;
+    bool jit;
 } config = {
     .program = NULL,
     .input = NULL,
+    .inputs = NULL,
+    .num_inputs = 0,
+    .workers = 0,
+    .cache_size = CHUNK_CACHE_DEFAULT_SIZE,
+    .max_instructions = FUEL_UNLIMITED,
     .mode = REPL,
     .debug = false,
     .trace = false,
+    .disassemble = false,
+    .disassemble_path = NULL,
+    .disassembly = NULL,
+    .stack_limit = DEFAULT_STACK_LIMIT,
+    .profile = false,
+    .sample_path = NULL,
+    .exec_trace_path = NULL,
+    .exec_trace_always = false,
+    .jit = false,
 };
 
 static void usage(FILE *out, const char *program);
@@ -50,7 +90,11 @@ static void setup(Program *program);
 static void teardown(Program *program);
 static int start_repl(Program *program);
 static int exec_file(Program *program);
-static const char *read_file(Allocator *alloc, FILE *file, size_t max_bytes);
+static int exec_jobs(Program *program);
+static Job *append_job(Allocator *alloc, Job *jobs, int *num_jobs, int *capacity, Job job);
+static void write_samples(Sampler *sampler, const char *path);
+static void report_job_errors(const char *name, String *errors);
+static void report_out_of_fuel(int64_t max_instructions);
 
 #pragma endregion
 
@@ -62,8 +106,13 @@ int main(int argc, char *argv[]) {
     setup(&program);
     if (config.mode == REPL) {
         exit_code = start_repl(&program);
-    } else {
+    } else if (config.mode == EXEC) {
         exit_code = exec_file(&program);
+    } else {
+        exit_code = exec_jobs(&program);
+    }
+    if (config.profile) {
+        profile_write_report(&config.profiler, stderr);
     }
     teardown(&program);
     return exit_code;
@@ -74,14 +123,36 @@ int main(int argc, char *argv[]) {
 #pragma region Private
 
 static void usage(FILE *out, const char *program) {
-    fprintf(out, "Usage: %s [OPTIONS]... <input_file>\n", program);
+    fprintf(out, "Usage: %s [OPTIONS]... <input_file>...\n", program);
     fprintf(out, "Interpreter for the lox programming language\n\n");
     fprintf(out, "Options:\n");
     fprintf(out, "  -h, --help      Display this help message and exit\n");
     fprintf(out, "  -v, --version   Output version information and exit\n");
     fprintf(out, "  --debug         Emit verbose debug information to stderr\n");
     fprintf(out, "  --trace         Emit very verbose debug information to stderr\n");
-    fprintf(out, "  <input_file>    The input file (positional argument)\n");
+    fprintf(out, "  --disassemble[=file]\n");
+    fprintf(out, "                  Disassemble each chunk before it runs (to stderr or file)\n");
+    fprintf(out, "  --stack-limit=N Report a stack overflow beyond N value stack slots (default %d)\n",
+            DEFAULT_STACK_LIMIT);
+    fprintf(out, "  --jit           Compile numeric chunks to native code where supported\n");
+    fprintf(out, "  --max-instructions=N\n");
+    fprintf(out, "                  Stop each script (or REPL line) after N instructions\n");
+    fprintf(out, "  --cache-size=N  Keep up to N bytes of compiled chunks for repeated REPL lines\n");
+    fprintf(out, "                  and jobs (default %d, 0 disables the cache)\n",
+            CHUNK_CACHE_DEFAULT_SIZE);
+    fprintf(out, "  --profile       Report per-opcode execution counts and timings at exit\n");
+    fprintf(out, "                  (requires a build with -DVM_PROFILE)\n");
+    fprintf(out, "  --sample=file   Sample the running script and write collapsed stacks for\n");
+    fprintf(out, "                  flamegraph.pl to file (requires a build with -DVM_SAMPLING)\n");
+    fprintf(out, "  --exec-trace=file\n");
+    fprintf(out, "                  Record recently executed instructions and write them to file\n");
+    fprintf(out, "                  when a run fails, for `lox trace` (requires -DVM_TRACE)\n");
+    fprintf(out, "  --exec-trace-always\n");
+    fprintf(out, "                  Write the execution trace after successful runs as well\n");
+    fprintf(out, "  --workers=N     Run the input files as independent jobs on N threads (default:\n");
+    fprintf(out, "                  one per processor when more than one file is given)\n");
+    fprintf(out, "  <input_file>    The input file (positional argument), or `-` for stdin; with\n");
+    fprintf(out, "                  several files, or --workers, `-` reads one script per line\n");
     fprintf(out, "");
     fprintf(out, "\nExamples\n");
     fprintf(out, "");
@@ -92,7 +163,7 @@ static void usage(FILE *out, const char *program) {
 static void parse(int argc, char *argv[]) {
     int optind;
 
-    for (optind = 1; optind < argc && argv[optind][0] == '-'; optind++) {
+    for (optind = 1; optind < argc && argv[optind][0] == '-' && argv[optind][1] != '\0'; optind++) {
         switch (argv[optind][1]) {
         case 'h':
             usage(stdout, argv[0]);
@@ -111,6 +182,65 @@ static void parse(int argc, char *argv[]) {
                 config.debug = true;
             } else if (strcmp(argv[optind], "--trace") == 0) {
                 config.trace = true;
+            } else if (strcmp(argv[optind], "--disassemble") == 0) {
+                config.disassemble = true;
+            } else if (strncmp(argv[optind], "--disassemble=", 14) == 0) {
+                config.disassemble = true;
+                config.disassemble_path = argv[optind] + 14;
+            } else if (strcmp(argv[optind], "--profile") == 0) {
+#ifndef VM_PROFILE
+                fprintf(stderr, "--profile requires a build with FEATURES=-DVM_PROFILE\n");
+                EXIT(EXIT_FAILURE);
+#endif
+                config.profile = true;
+            } else if (strncmp(argv[optind], "--sample=", 9) == 0) {
+#ifndef VM_SAMPLING
+                fprintf(stderr, "--sample requires a build with FEATURES=-DVM_SAMPLING\n");
+                EXIT(EXIT_FAILURE);
+#endif
+                config.sample_path = argv[optind] + 9;
+            } else if (strncmp(argv[optind], "--exec-trace=", 13) == 0) {
+#ifndef VM_TRACE
+                fprintf(stderr, "--exec-trace requires a build with FEATURES=-DVM_TRACE\n");
+                EXIT(EXIT_FAILURE);
+#endif
+                config.exec_trace_path = argv[optind] + 13;
+            } else if (strcmp(argv[optind], "--exec-trace-always") == 0) {
+                config.exec_trace_always = true;
+            } else if (strcmp(argv[optind], "--jit") == 0) {
+                config.jit = true;
+            } else if (strncmp(argv[optind], "--max-instructions=", 19) == 0) {
+                char *end;
+                long long limit = strtoll(argv[optind] + 19, &end, 10);
+                if (*end != '\0' || limit < 0) {
+                    fprintf(stderr, "--max-instructions must be a non-negative number\n");
+                    EXIT(EXIT_FAILURE);
+                }
+                config.max_instructions = limit;
+            } else if (strncmp(argv[optind], "--cache-size=", 13) == 0) {
+                char *end;
+                long long size = strtoll(argv[optind] + 13, &end, 10);
+                if (*end != '\0' || size < 0) {
+                    fprintf(stderr, "--cache-size must be a number of bytes\n");
+                    EXIT(EXIT_FAILURE);
+                }
+                config.cache_size = (size_t)size;
+            } else if (strncmp(argv[optind], "--workers=", 10) == 0) {
+                char *end;
+                long workers = strtol(argv[optind] + 10, &end, 10);
+                if (*end != '\0' || workers < 1 || workers > EXECUTOR_MAX_WORKERS) {
+                    fprintf(stderr, "--workers must be between 1 and %d\n", EXECUTOR_MAX_WORKERS);
+                    EXIT(EXIT_FAILURE);
+                }
+                config.workers = (int)workers;
+            } else if (strncmp(argv[optind], "--stack-limit=", 14) == 0) {
+                char *end;
+                long limit = strtol(argv[optind] + 14, &end, 10);
+                if (*end != '\0' || limit < 1 || limit > MAX_STACK_LIMIT) {
+                    fprintf(stderr, "--stack-limit must be between 1 and %d\n", MAX_STACK_LIMIT);
+                    EXIT(EXIT_FAILURE);
+                }
+                config.stack_limit = (int)limit;
             } else {
                 usage(stderr, argv[0]);
                 EXIT(EXIT_FAILURE);
@@ -123,19 +253,28 @@ static void parse(int argc, char *argv[]) {
     }
     size_t num_args = argc - optind;
     config.program = argv[0];
+    config.inputs = argv + optind;
+    config.num_inputs = (int)num_args;
 
-    switch (num_args) {
-    case 0:
+    if (num_args == 0) {
+        if (config.workers != 0) {
+            usage(stderr, argv[0]);
+            EXIT(EXIT_FAILURE);
+        }
         config.mode = REPL;
         config.input = NULL;
-        break;
-    case 1:
+    } else if (num_args == 1 && config.workers == 0) {
         config.mode = EXEC;
         config.input = argv[optind];
-        break;
-    default:
-        usage(stderr, argv[0]);
-        EXIT(EXIT_FAILURE);
+    } else {
+        config.mode = JOBS;
+        // These observe a single VM, so they can't be attached to the executor's workers.
+        if (config.disassemble || config.profile || config.sample_path != NULL
+            || config.exec_trace_path != NULL) {
+            fprintf(stderr, "--disassemble, --profile, --sample and --exec-trace can't be used "
+                            "with several jobs\n");
+            EXIT(EXIT_FAILURE);
+        }
     }
 }
 
@@ -147,9 +286,36 @@ static void setup(Program *program) {
         log_level = LOG_LEVEL_DEBUG;
     FILE *log_stream = stderr;
     program_init(program, log_level, log_stream);
+
+    if (config.disassemble) {
+        config.disassembly = stderr;
+        if (config.disassemble_path != NULL) {
+            config.disassembly = fopen(config.disassemble_path, "w");
+            if (config.disassembly == NULL) {
+                perror("failed to open disassembly file");
+                teardown(program);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    if (config.profile) {
+        profile_init(&config.profiler);
+    }
+    if (config.exec_trace_path != NULL) {
+        tracer_init(&config.tracer, program->alloc, TRACE_DEFAULT_CAPACITY);
+        config.tracer.path = config.exec_trace_path;
+        config.tracer.dump_always = config.exec_trace_always;
+    }
 }
 
 static void teardown(Program *program) {
+    if (config.tracer.records != NULL) {
+        tracer_destroy(&config.tracer);
+    }
+    if (config.disassembly != NULL && config.disassembly != stderr) {
+        fclose(config.disassembly);
+    }
+    config.disassembly = NULL;
     program_destroy(program);
 }
 
@@ -157,6 +323,16 @@ static int start_repl(Program *program) {
     int exit_code = EXIT_SUCCESS;
     VirtualMachine vm;
     virtual_machine_init(&vm, program->alloc);
+    vm.disassembly = config.disassembly;
+    vm.stack_limit = config.stack_limit;
+    vm.profile = config.profile ? &config.profiler : NULL;
+    vm.tracer = config.exec_trace_path != NULL ? &config.tracer : NULL;
+    vm.jit = config.jit;
+    ChunkCache cache;
+    if (config.cache_size > 0) {
+        chunk_cache_init(&cache, program->alloc, config.cache_size);
+        vm.cache = &cache;
+    }
     DEBUG(program->logger, "starting (vm=%p)", &vm);
 
     char line[1024] = { 0 };
@@ -168,13 +344,23 @@ static int start_repl(Program *program) {
         }
         line[strcspn(line, "\n")] = '\0';
 
+        vm.fuel = config.max_instructions;
         InterpretResult result = interpret(&vm, line);
+        if (result == INTERPRET_YIELD) {
+            report_out_of_fuel(config.max_instructions);
+        }
         if (result == INTERPRET_COMPILE_ERROR) {
             DEBUG(program->logger, "Compile Error");
             exit_code = EXIT_COMPILE_ERROR;
             break;
         }
     }
+    if (vm.cache != NULL) {
+        DEBUG(program->logger, "chunk cache: %zu hits, %zu misses, %zu evictions", cache.hits,
+              cache.misses, cache.evictions);
+        chunk_cache_destroy(&cache);
+    }
+    virtual_machine_destroy(&vm);
     return exit_code;
 }
 
@@ -182,17 +368,55 @@ static int exec_file(Program *program) {
     int exit_code = EXIT_SUCCESS;
     VirtualMachine vm = { 0 };
     virtual_machine_init(&vm, program->alloc);
+    vm.disassembly = config.disassembly;
+    vm.stack_limit = config.stack_limit;
+    vm.profile = config.profile ? &config.profiler : NULL;
+    vm.tracer = config.exec_trace_path != NULL ? &config.tracer : NULL;
+    vm.jit = config.jit;
     DEBUG(program->logger, "starting (vm=%p)", &vm);
 
+    // A file is mapped rather than copied, and a pipe, which can't be, is compiled as it is read,
+    // so the source can be any size. `-` reads it from stdin.
     Assert(config.input != NULL);
-    FILE *file = fopen(config.input, "r");
-    if (file == NULL) {
+    bool from_stdin = strcmp(config.input, "-") == 0;
+    int fd = from_stdin ? STDIN_FILENO : open(config.input, O_RDONLY);
+    if (fd < 0) {
         perror("failed to open input file");
+        virtual_machine_destroy(&vm);
         return EXIT_FAILURE;
     }
-    const char *contents = read_file(program->alloc, file, MAX_INPUT_FILE_BYTES);
+    SourceFile file;
+    SourceStream stream = { 0 };
+    bool streamed = false;
+    if (!source_file_map(&file, program->alloc, fd)) {
+        if (errno != ENODEV) {
+            perror("failed to read input file");
+            exit_code = EXIT_FAILURE;
+            goto cleanup;
+        }
+        source_stream_init(&stream, program->alloc, fd, SOURCE_STREAM_WINDOW);
+        streamed = true;
+    }
+
+    Sampler sampler;
+    if (config.sample_path != NULL) {
+        sampler_init(&sampler, &vm, program->alloc, config.input, SAMPLER_DEFAULT_INTERVAL_US);
+        if (!sampler_start(&sampler)) {
+            perror("failed to start sampler");
+            sampler_destroy(&sampler);
+            exit_code = EXIT_FAILURE;
+            goto cleanup;
+        }
+        vm.sampler = &sampler;
+    }
 
-    InterpretResult result = interpret(&vm, contents);
+    vm.fuel = config.max_instructions;
+    InterpretResult result = streamed ? interpret_stream(&vm, &stream)
+                                      : interpret(&vm, file.source);
+    if (stream.error != 0) {
+        exit_code = EXIT_FAILURE;
+        goto cleanup;
+    }
     if (result == INTERPRET_COMPILE_ERROR) {
         DEBUG(program->logger, "Compile Error");
         exit_code = EXIT_COMPILE_ERROR;
@@ -205,48 +429,147 @@ static int exec_file(Program *program) {
         goto cleanup;
     }
 
+    if (result == INTERPRET_YIELD) {
+        report_out_of_fuel(config.max_instructions);
+        exit_code = EXIT_RUNTIME_ERROR;
+        goto cleanup;
+    }
+
 cleanup:
-    if (fclose(file) != 0) {
+    if (vm.sampler != NULL) {
+        sampler_stop(&sampler);
+        write_samples(&sampler, config.sample_path);
+        sampler_destroy(&sampler);
+    }
+    virtual_machine_destroy(&vm);
+    if (streamed) {
+        source_stream_destroy(&stream);
+    }
+    source_file_destroy(&file);
+    if (!from_stdin && close(fd) != 0) {
         perror("failed to close input file");
         return EXIT_FAILURE;
     }
     return exit_code;
 }
 
-static const char *read_file(Allocator *alloc, FILE *file, size_t max_bytes) {
-    size_t cap = 1024;
-    char *buffer = (char *)allocator_alloc(alloc, cap);
-    char *current = buffer;
-
-    for (;;) {
-        size_t len = current - buffer;
-        size_t available = cap - len;
-        size_t bytes_read = fread(current, 1, available, file);
-        current += bytes_read;
-        len += bytes_read;
-        available = cap - len;
-        if (bytes_read < len) {
-            if (feof(file)) {
-                if (available == 0) {
-                    buffer = (char *)allocator_realloc(alloc, buffer, cap, cap + 1);
-                }
-                buffer[len] = '\0';
-                break;
-            }
-            if (ferror(file)) {
-                perror("failed to read input file");
-                EXIT(EXIT_FAILURE);
+// Runs every input as an independent job on the executor and reports the results in input order.
+// `-` stands for stdin, where each non-empty line is a separate script.
+static int exec_jobs(Program *program) {
+    int num_jobs = 0;
+    int capacity = config.num_inputs;
+    Job *jobs = (Job *)allocator_alloc(program->alloc, sizeof(Job) * capacity);
+    SourceFile records = { 0 };
+    for (int i = 0; i < config.num_inputs; i++) {
+        if (strcmp(config.inputs[i], "-") != 0) {
+            jobs = append_job(program->alloc, jobs, &num_jobs, &capacity,
+                              (Job){ .name = config.inputs[i] });
+            continue;
+        }
+        if (records.buffer != NULL) {
+            continue; // stdin can only be read once
+        }
+        // Each line is NUL-terminated in place, so stdin is read into a buffer even when it is a
+        // file that could be mapped.
+        if (!source_file_read(&records, program->alloc, STDIN_FILENO)) {
+            perror("failed to read stdin");
+            allocator_free(program->alloc, jobs);
+            return EXIT_FAILURE;
+        }
+        for (char *line = records.buffer; *line != '\0';) {
+            char *end = line + strcspn(line, "\n");
+            bool last = *end == '\0';
+            *end = '\0';
+            if (*line != '\0') {
+                jobs = append_job(program->alloc, jobs, &num_jobs, &capacity,
+                                  (Job){ .name = "<stdin>", .source = line });
             }
+            line = last ? end : end + 1;
         }
-        size_t new_cap = cap * 2;
-        if (new_cap > max_bytes) {
-            fprintf(stderr, "Error: input file exceeds maximum size of %zu bytes\n", max_bytes);
-            EXIT(EXIT_FAILURE);
+    }
+
+    Executor executor;
+    executor_init(&executor, program->alloc, program->logger,
+                  config.workers != 0 ? config.workers : executor_default_workers());
+    executor.stack_limit = config.stack_limit;
+    executor.jit = config.jit;
+    executor.cache_size = config.cache_size;
+    executor.fuel = config.max_instructions;
+    DEBUG(program->logger, "running %d jobs on %d workers", num_jobs, executor.num_workers);
+    int exit_code = EXIT_SUCCESS;
+    if (!executor_run(&executor, jobs, num_jobs)) {
+        perror("failed to start workers");
+        exit_code = EXIT_FAILURE;
+        goto cleanup;
+    }
+
+    for (int i = 0; i < num_jobs; i++) {
+        int job_exit_code = EXIT_SUCCESS;
+        if (jobs[i].errors != NULL) {
+            report_job_errors(jobs[i].name, jobs[i].errors);
+        }
+        if (jobs[i].read_failed) {
+            job_exit_code = EXIT_FAILURE;
+        } else if (jobs[i].result == INTERPRET_COMPILE_ERROR) {
+            job_exit_code = EXIT_COMPILE_ERROR;
+        } else if (jobs[i].result == INTERPRET_RUNTIME_ERROR) {
+            job_exit_code = EXIT_RUNTIME_ERROR;
+        } else if (jobs[i].result == INTERPRET_YIELD) {
+            fprintf(stderr, "%s: ", jobs[i].name);
+            report_out_of_fuel(config.max_instructions);
+            job_exit_code = EXIT_RUNTIME_ERROR;
+        } else {
+            fprintf(stderr, "%s: ", jobs[i].name);
+            value_write_repr(&jobs[i].value, stderr);
+            fputc('\n', stderr);
+        }
+        // The first failing job (in input order) decides the exit code.
+        if (exit_code == EXIT_SUCCESS) {
+            exit_code = job_exit_code;
         }
-        buffer = (char *)allocator_realloc(alloc, buffer, cap, new_cap);
-        cap = new_cap;
     }
-    return buffer;
+
+cleanup:
+    executor_destroy(&executor);
+    source_file_destroy(&records);
+    allocator_free(program->alloc, jobs);
+    return exit_code;
 }
 
-#pragma endregion
+static Job *append_job(Allocator *alloc, Job *jobs, int *num_jobs, int *capacity, Job job) {
+    if (*num_jobs == *capacity) {
+        jobs = (Job *)allocator_realloc(alloc, jobs, sizeof(Job) * *capacity,
+                                        sizeof(Job) * *capacity * 2);
+        *capacity *= 2;
+    }
+    jobs[(*num_jobs)++] = job;
+    return jobs;
+}
+
+static void write_samples(Sampler *sampler, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (out == NULL) {
+        perror("failed to open samples file");
+        return;
+    }
+    sampler_write_collapsed(sampler, out);
+    if (fclose(out) != 0) {
+        perror("failed to close samples file");
+    }
+}
+
+// Prints each line a job reported, prefixed with the job's name like the rest of its output.
+static void report_job_errors(const char *name, String *errors) {
+    const char *line = string_cstr(errors);
+    while (*line != '\0') {
+        size_t length = strcspn(line, "\n");
+        fprintf(stderr, "%s: %.*s\n", name, (int)length, line);
+        line += line[length] == '\n' ? length + 1 : length;
+    }
+}
+
+static void report_out_of_fuel(int64_t max_instructions) {
+    fprintf(stderr, "Stopped after the instruction limit of %lld\n", (long long)max_instructions);
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,10 @@
+#ifndef clox_number_h
+#define clox_number_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+bool number_parse(const char *start, size_t length, double *value);
+
+#endif
\ No newline at end of file
@@ -1,20 +1,99 @@
 #include "parser.h"
 #include "scanner.h"
 
-#define PARSER_ARENA_INITIAL_SIZE 1024
-
 #pragma region Declare
 #pragma endregion
 
 #pragma region Public
 
 void parser_init(Parser *parser, Allocator *alloc, Scanner *scanner) {
-    parser->alloc = alloc;
-    parser->scanner = scanner;
-    parser->state = PARSER_OK;
+    *parser = (Parser){
+        .scanner = scanner, .stream = scanner->stream, .state = PARSER_OK, .alloc = alloc
+    };
+    line_index_init(&parser->lines, alloc, scanner->start, scanner->end - scanner->start);
+}
+
+void parser_init_tokens(Parser *parser, Allocator *alloc, TokenBuffer *tokens) {
+    Assert(tokens->count > 0);
+    *parser = (Parser){ .tokens = tokens, .state = PARSER_OK, .alloc = alloc };
+    line_index_init(&parser->lines, alloc, tokens->source, tokens->length);
+}
+
+void parser_destroy(Parser *parser) {
+    if (parser->error.message != NULL) {
+        string_destroy(parser->error.message, parser->alloc);
+    }
+    parser->error = (ParseError){ 0 };
+    line_index_destroy(&parser->lines);
+}
+
+// Moves to the next token, skipping comments and reporting any the scanner could not read.
+void parser_advance(Parser *parser) {
+    parser->previous = parser->current;
+    for (;;) {
+        if (parser->tokens != NULL) {
+            // The buffer ends with TOKEN_EOF, which is returned again if the grammar asks for more.
+            size_t last = parser->tokens->count - 1;
+            parser->current = token_buffer_get(parser->tokens,
+                                               parser->next < last ? parser->next++ : last);
+        } else if (parser->stream != NULL) {
+            parser->current = scanner_scan_stream(parser->scanner, &parser->previous);
+        } else {
+            parser->current = scanner_scan(parser->scanner);
+        }
+        if (parser->current.type == TOKEN_ERROR) {
+            const char *message = parser->tokens != NULL ? parser->tokens->error
+                                                         : parser->scanner->error;
+            parser_error_at(parser, &parser->current, message);
+        } else if (parser->current.type != TOKEN_COMMENT) {
+            break;
+        }
+    }
+}
+
+bool parser_match(Parser *parser, TokenType type) {
+    if (parser->current.type != type) {
+        return false;
+    }
+    parser_advance(parser);
+    return true;
+}
+
+void parser_consume(Parser *parser, TokenType type, const char *message) {
+    if (parser->current.type == type) {
+        parser_advance(parser);
+        return;
+    }
+    parser_error_at(parser, &parser->current, message);
+}
+
+void parser_error_at(Parser *parser, Token *token, const char *message) {
+    if (parser->state == PARSER_ERROR) {
+        return;
+    }
+    parser->state = PARSER_ERROR;
+    int line = parser_line(parser, token);
+    String *formatted;
+    if (token->type == TOKEN_ERROR) {
+        formatted = string_sprintf(parser->alloc, "[line %d] Error: %s\n", line, message);
+    } else if (token->type == TOKEN_EOF) {
+        formatted = string_sprintf(parser->alloc, "[line %d] Error at end: %s\n", line, message);
+    } else if (token->type == TOKEN_STRING) {
+        // The token leaves out its quotes, but the source it is quoted from has them.
+        formatted = string_sprintf(parser->alloc, "[line %d] Error at '\"%.*s\"': %s\n", line,
+                                   token->length, token->start, message);
+    } else {
+        formatted = string_sprintf(parser->alloc, "[line %d] Error at '%.*s': %s\n", line,
+                                   token->length, token->start, message);
+    }
+    parser->error = (ParseError){
+        .message = formatted,
+        .line = line,
+        .scan = token->type == TOKEN_ERROR,
+    };
 }
 
 #pragma endregion
 
 #pragma region Private
-#pragma endregion
+#pragma endregion
\ No newline at end of file
@@ -4,11 +4,16 @@
 #include <stdbool.h>
 
 #include "allocator.h"
+#include "array.h"
+#include "line_index.h"
 #include "scanner.h"
+#include "source_stream.h"
+#include "token_buffer.h"
 
 typedef struct ParseError {
-    const char *reason;
+    String *message; // formatted for the user, including the line
     int line;
+    bool scan; // the error was reported by the scanner rather than the grammar
 } ParseError;
 
 typedef enum ParserState {
@@ -16,15 +21,41 @@ typedef enum ParserState {
     PARSER_ERROR,
 } ParserState;
 
+/**
+ * The token cursor shared by the compiler's grammar rules.
+ * Tokens come either straight from a scanner, which may be reading a SourceStream, or from a
+ * source tokenized beforehand into a TokenBuffer. They are slices of the source, so nothing is
+ * copied as they go by, and their lines are looked up in an index of the source only when bytecode
+ * or an error needs them. Only the first error is kept: once one is reported the parser stays in
+ * PARSER_ERROR and later errors, which are usually caused by the first, are ignored.
+ */
 typedef struct Parser {
     Token current;
     Token previous;
-    Scanner *scanner;
+    Scanner *scanner;     // or NULL when reading from `tokens`
+    SourceStream *stream; // the scanner's stream, if it has one
+    TokenBuffer *tokens;  // or NULL when reading from `scanner`
+    size_t next;          // the index in `tokens` of the token after `current`
     ParserState state;
     ParseError error;
+    LineIndex lines; // of the source, unless it is a stream
     Allocator *alloc;
 } Parser;
 
 void parser_init(Parser *parser, Allocator *alloc, Scanner *scanner);
+void parser_init_tokens(Parser *parser, Allocator *alloc, TokenBuffer *tokens);
+void parser_destroy(Parser *parser);
+void parser_advance(Parser *parser);
+bool parser_match(Parser *parser, TokenType type);
+void parser_consume(Parser *parser, TokenType type, const char *message);
+void parser_error_at(Parser *parser, Token *token, const char *message);
+
+// Returns the line a token of the source starts on.
+static inline int parser_line(Parser *parser, Token *token) {
+    if (parser->stream != NULL) {
+        return source_stream_line(parser->stream, token->start);
+    }
+    return line_index_line(&parser->lines, (size_t)(token->start - parser->lines.source));
+}
 
 #endif
\ No newline at end of file
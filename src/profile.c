@@ -0,0 +1,142 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <x86intrin.h>
+#define PROFILE_RDTSC
+#endif
+
+#include "profile.h"
+
+typedef struct PairCount {
+    int first;
+    int second;
+    uint64_t count;
+} PairCount;
+
+#pragma region Declare
+
+static int compare_opcodes(const void *a, const void *b);
+static int compare_pairs(const void *a, const void *b);
+static double percent(uint64_t count, uint64_t total);
+
+// The profile being sorted by compare_opcodes, since qsort takes no context argument.
+static Profile *sorting;
+
+#pragma endregion
+
+#pragma region Public
+
+void profile_init(Profile *profile) {
+    memset(profile, 0, sizeof(Profile));
+    profile->countdown = PROFILE_SAMPLE_PERIOD;
+    profile_begin(profile);
+}
+
+// Starts a run of the dispatch loop. Pairs are not counted across runs.
+void profile_begin(Profile *profile) {
+    profile->previous = PROFILE_NO_OPCODE;
+    profile->sampled = PROFILE_NO_OPCODE;
+}
+
+uint64_t profile_ticks(void) {
+#ifdef PROFILE_RDTSC
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + (uint64_t)now.tv_nsec;
+#endif
+}
+
+const char *profile_tick_unit(void) {
+#ifdef PROFILE_RDTSC
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+// Writes the opcodes sorted by execution count, followed by the most frequent opcode pairs.
+void profile_write_report(Profile *profile, FILE *out) {
+    uint64_t total = 0;
+    int opcodes[NUM_OPCODES];
+    for (int code = 0; code < NUM_OPCODES; code++) {
+        total += profile->counts[code];
+        opcodes[code] = code;
+    }
+    sorting = profile;
+    qsort(opcodes, NUM_OPCODES, sizeof(int), compare_opcodes);
+    sorting = NULL;
+
+    fprintf(out, "== Profile (%llu instructions) ==\n", (unsigned long long)total);
+    fprintf(out, "%-20s %14s %7s %10s\n", "opcode", "count", "%", profile_tick_unit());
+    for (int i = 0; i < NUM_OPCODES; i++) {
+        int code = opcodes[i];
+        if (profile->counts[code] == 0) {
+            break;
+        }
+        fprintf(out, "%-20s %14llu %6.2f%%", opcode_name(code),
+                (unsigned long long)profile->counts[code], percent(profile->counts[code], total));
+        if (profile->samples[code] > 0) {
+            fprintf(out, " %10.1f\n", (double)profile->ticks[code] / profile->samples[code]);
+        } else {
+            fprintf(out, " %10s\n", "-");
+        }
+    }
+
+    PairCount pairs[NUM_OPCODES * NUM_OPCODES];
+    int num_pairs = 0;
+    uint64_t total_pairs = 0;
+    for (int first = 0; first < NUM_OPCODES; first++) {
+        for (int second = 0; second < NUM_OPCODES; second++) {
+            uint64_t count = profile->pairs[first][second];
+            if (count > 0) {
+                pairs[num_pairs++] = (PairCount){ first, second, count };
+                total_pairs += count;
+            }
+        }
+    }
+    qsort(pairs, num_pairs, sizeof(PairCount), compare_pairs);
+
+    fprintf(out, "== Opcode pairs (%llu) ==\n", (unsigned long long)total_pairs);
+    for (int i = 0; i < num_pairs && i < PROFILE_REPORT_PAIRS; i++) {
+        fprintf(out, "%-20s %-20s %14llu %6.2f%%\n", opcode_name(pairs[i].first),
+                opcode_name(pairs[i].second), (unsigned long long)pairs[i].count,
+                percent(pairs[i].count, total_pairs));
+    }
+}
+
+#pragma endregion
+
+#pragma region Private
+
+// Orders by descending count, breaking ties by opcode so the report is deterministic.
+static int compare_opcodes(const void *a, const void *b) {
+    int left = *(const int *)a;
+    int right = *(const int *)b;
+    if (sorting->counts[left] != sorting->counts[right]) {
+        return sorting->counts[left] < sorting->counts[right] ? 1 : -1;
+    }
+    return left - right;
+}
+
+static int compare_pairs(const void *a, const void *b) {
+    const PairCount *left = (const PairCount *)a;
+    const PairCount *right = (const PairCount *)b;
+    if (left->count != right->count) {
+        return left->count < right->count ? 1 : -1;
+    }
+    if (left->first != right->first) {
+        return left->first - right->first;
+    }
+    return left->second - right->second;
+}
+
+static double percent(uint64_t count, uint64_t total) {
+    return total == 0 ? 0.0 : 100.0 * (double)count / (double)total;
+}
+
+#pragma endregion
\ No newline at end of file
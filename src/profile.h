@@ -0,0 +1,74 @@
+#ifndef clox_profile_h
+#define clox_profile_h
+
+#include <stdio.h>
+
+#include "allocator.h"
+#include "common.h"
+#include "instruction.h"
+
+/**
+ * Per-opcode execution profile of the VM.
+ * Counts every executed opcode and every pair of consecutively executed opcodes, and samples the
+ * time spent in one out of every PROFILE_SAMPLE_PERIOD instructions. Timing is in cycles (rdtsc)
+ * on x86-64 and in nanoseconds (clock_gettime) elsewhere.
+ *
+ * The VM only records into a profile when built with -DVM_PROFILE; otherwise the hooks compile away
+ * entirely and the dispatch loop is unchanged.
+ */
+
+#define PROFILE_SAMPLE_PERIOD 61 // prime, so sampling doesn't lock onto periodic code
+#define PROFILE_REPORT_PAIRS  20 // the number of opcode pairs listed in the report
+
+#define PROFILE_NO_OPCODE -1
+
+typedef struct Profile {
+    uint64_t counts[NUM_OPCODES];
+    uint64_t pairs[NUM_OPCODES][NUM_OPCODES];
+    uint64_t ticks[NUM_OPCODES];   // total sampled ticks per opcode
+    uint64_t samples[NUM_OPCODES]; // number of timing samples per opcode
+    int previous;                  // the last opcode executed, or PROFILE_NO_OPCODE
+    int sampled;                   // the opcode being timed, or PROFILE_NO_OPCODE
+    uint64_t sample_start;
+    int countdown;
+} Profile;
+
+void profile_init(Profile *profile);
+void profile_begin(Profile *profile);
+void profile_write_report(Profile *profile, FILE *out);
+uint64_t profile_ticks(void);
+const char *profile_tick_unit(void);
+
+// Records the execution of `code`. The timing sample for an instruction spans from its dispatch to
+// the dispatch of the next one, so it includes the dispatch branch and the cost of reading the
+// clock; timings are meaningful relative to each other rather than in absolute terms.
+static inline void profile_record(Profile *profile, OpCode code) {
+    profile->counts[code]++;
+    if (profile->previous != PROFILE_NO_OPCODE) {
+        profile->pairs[profile->previous][code]++;
+    }
+    profile->previous = code;
+
+    if (profile->sampled != PROFILE_NO_OPCODE) {
+        profile->ticks[profile->sampled] += profile_ticks() - profile->sample_start;
+        profile->samples[profile->sampled]++;
+        profile->sampled = PROFILE_NO_OPCODE;
+    }
+    if (--profile->countdown == 0) {
+        profile->countdown = PROFILE_SAMPLE_PERIOD;
+        profile->sampled = code;
+        profile->sample_start = profile_ticks();
+    }
+}
+
+// Ends the run started by profile_begin, closing any sample still in flight.
+static inline void profile_end(Profile *profile) {
+    if (profile->sampled != PROFILE_NO_OPCODE) {
+        profile->ticks[profile->sampled] += profile_ticks() - profile->sample_start;
+        profile->samples[profile->sampled]++;
+    }
+    profile->previous = PROFILE_NO_OPCODE;
+    profile->sampled = PROFILE_NO_OPCODE;
+}
+
+#endif
\ No newline at end of file
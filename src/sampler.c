@@ -0,0 +1,147 @@
+#define _XOPEN_SOURCE 700
+
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "sampler.h"
+
+#define DEFAULT_LINE_CAPACITY 64
+
+#pragma region Declare
+
+static void handle_sigprof(int signal);
+static void block_sigprof(sigset_t *previous);
+static void count_line(Sampler *sampler, int line);
+
+// The signal handler has no argument to carry state, so the running sampler is published here.
+static Sampler *volatile active_sampler = NULL;
+
+#pragma endregion
+
+#pragma region Public
+
+void sampler_init(Sampler *sampler, VirtualMachine *vm, Allocator *alloc, const char *script,
+                  int interval_us) {
+    Assert(interval_us > 0);
+    *sampler = (Sampler){
+        .vm = vm,
+        .alloc = alloc,
+        .script = script,
+        .interval_us = interval_us,
+        .line_capacity = DEFAULT_LINE_CAPACITY,
+    };
+    sampler->ips = (const Instruction **)allocator_alloc(
+        alloc, sizeof(const Instruction *) * SAMPLER_BUFFER_CAPACITY);
+    sampler->line_counts = (uint64_t *)allocator_alloc(alloc, sizeof(uint64_t) * DEFAULT_LINE_CAPACITY);
+    memset(sampler->line_counts, 0, sizeof(uint64_t) * DEFAULT_LINE_CAPACITY);
+}
+
+// Installs the SIGPROF handler and starts the profiling timer. Only one sampler can run at a time.
+// Returns false (with errno set) if the handler or timer could not be installed.
+bool sampler_start(Sampler *sampler) {
+    Assert(active_sampler == NULL);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_sigprof;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGPROF, &action, NULL) != 0) {
+        return false;
+    }
+    active_sampler = sampler;
+
+    struct itimerval timer = {
+        .it_interval = { .tv_sec = sampler->interval_us / 1000000,
+                         .tv_usec = sampler->interval_us % 1000000 },
+        .it_value = { .tv_sec = sampler->interval_us / 1000000,
+                      .tv_usec = sampler->interval_us % 1000000 },
+    };
+    if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+        active_sampler = NULL;
+        return false;
+    }
+    return true;
+}
+
+void sampler_stop(Sampler *sampler) {
+    Assert(active_sampler == sampler);
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    setitimer(ITIMER_PROF, &timer, NULL);
+    signal(SIGPROF, SIG_IGN);
+    active_sampler = NULL;
+}
+
+// Maps the buffered samples, which must all fall within `loaded`, to source lines and empties the
+// buffer. Called by the VM after each chunk finishes while the chunk's line table is still alive.
+void sampler_collect(Sampler *sampler, LoadedChunk *loaded) {
+    sigset_t previous;
+    block_sigprof(&previous);
+    for (int i = 0; i < sampler->num_ips; i++) {
+        int index = sampler->ips[i] - loaded->code;
+        if (index < 0 || index >= loaded->length) {
+            sampler->idle++;
+            continue;
+        }
+        count_line(sampler, opcode_chunk_line_at(loaded->chunk, loaded->offsets[index]));
+    }
+    sampler->num_ips = 0;
+    sigprocmask(SIG_SETMASK, &previous, NULL);
+}
+
+// Writes one line per sampled source line: the semicolon separated stack of frames, a space and
+// the number of samples. Call frames don't exist yet, so every stack is the top-level script.
+void sampler_write_collapsed(Sampler *sampler, FILE *out) {
+    for (int line = 0; line < sampler->line_capacity; line++) {
+        if (sampler->line_counts[line] > 0) {
+            fprintf(out, "%s;%s:%d %llu\n", SAMPLER_SCRIPT_FRAME, sampler->script, line,
+                    (unsigned long long)sampler->line_counts[line]);
+        }
+    }
+}
+
+void sampler_destroy(Sampler *sampler) {
+    Assert(active_sampler != sampler);
+    allocator_free(sampler->alloc, sampler->ips);
+    allocator_free(sampler->alloc, sampler->line_counts);
+    *sampler = (Sampler){ 0 };
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static void handle_sigprof(int signal) {
+    (void)signal;
+    Sampler *sampler = active_sampler;
+    if (sampler != NULL) {
+        sampler_record(sampler, *(Instruction *volatile *)&sampler->vm->ip);
+    }
+}
+
+static void block_sigprof(sigset_t *previous) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGPROF);
+    sigprocmask(SIG_BLOCK, &mask, previous);
+}
+
+static void count_line(Sampler *sampler, int line) {
+    if (line < 0) {
+        return;
+    }
+    if (line >= sampler->line_capacity) {
+        int capacity = sampler->line_capacity;
+        while (capacity <= line) {
+            capacity *= 2;
+        }
+        sampler->line_counts = (uint64_t *)allocator_realloc(
+            sampler->alloc, sampler->line_counts, sizeof(uint64_t) * sampler->line_capacity,
+            sizeof(uint64_t) * capacity);
+        sampler->line_capacity = capacity;
+    }
+    sampler->line_counts[line]++;
+}
+
+#pragma endregion
\ No newline at end of file
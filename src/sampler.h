@@ -0,0 +1,62 @@
+#ifndef clox_sampler_h
+#define clox_sampler_h
+
+#include <signal.h>
+#include <stdio.h>
+
+#include "allocator.h"
+#include "common.h"
+#include "vm.h"
+
+/**
+ * Statistical profiler attributing CPU time to Lox source lines.
+ * While started, a SIGPROF interval timer interrupts the process every `interval_us` microseconds
+ * of CPU time and the signal handler records the instruction the VM is about to execute. After
+ * each chunk finishes, the recorded instructions are mapped back to source lines through the
+ * chunk's line table. The aggregated samples are written in the collapsed-stack format read by
+ * flamegraph.pl.
+ *
+ * The VM only publishes its instruction pointer on every dispatch, and only hands its samples to
+ * the sampler, when built with -DVM_SAMPLING.
+ */
+
+#define SAMPLER_DEFAULT_INTERVAL_US 1000
+#define SAMPLER_BUFFER_CAPACITY     (1 << 16)
+#define SAMPLER_SCRIPT_FRAME        "<script>"
+
+typedef struct Sampler {
+    VirtualMachine *vm;
+    Allocator *alloc;
+    const char *script; // the name of the source file samples are attributed to
+    int interval_us;
+    // Written by the signal handler; only read while SIGPROF is blocked.
+    const Instruction **ips;
+    volatile sig_atomic_t num_ips;
+    volatile sig_atomic_t dropped; // samples lost because the buffer was full
+    volatile sig_atomic_t idle;    // samples taken while the VM was not executing
+    // Samples per source line, indexed by line number.
+    uint64_t *line_counts;
+    int line_capacity;
+} Sampler;
+
+void sampler_init(Sampler *sampler, VirtualMachine *vm, Allocator *alloc, const char *script,
+                  int interval_us);
+bool sampler_start(Sampler *sampler);
+void sampler_stop(Sampler *sampler);
+void sampler_collect(Sampler *sampler, LoadedChunk *loaded);
+void sampler_write_collapsed(Sampler *sampler, FILE *out);
+void sampler_destroy(Sampler *sampler);
+
+// Records one sample of `ip`. Async-signal-safe; called from the SIGPROF handler.
+static inline void sampler_record(Sampler *sampler, const Instruction *ip) {
+    if (ip == NULL) {
+        sampler->idle++;
+    } else if (sampler->num_ips < SAMPLER_BUFFER_CAPACITY) {
+        sampler->ips[sampler->num_ips] = ip;
+        sampler->num_ips++;
+    } else {
+        sampler->dropped++;
+    }
+}
+
+#endif
\ No newline at end of file
@@ -1,6 +1,5 @@
-#include <ctype.h>
-#include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "array.h"
@@ -8,131 +7,215 @@
 #include "scanner.h"
 
 #define SCANNER_ARENA_INITIAL_SIZE 1024
-#define DEFAULT_KEYWORDS_CAPACITY 64
 
-#define TOKEN(_type, _start, _length, _line)                                                       \
+// Runs of whitespace, identifier and digit characters, and the ends of comments and strings, are
+// found a vector at a time: each byte is classified with a few compares and the resulting bit mask
+// is searched with count-trailing-zeros. Compile with -mavx2 for 32-byte vectors; without SSE2 the
+// scanner steps one byte at a time. Vector loads never read past the end of the source, so the
+// last few bytes are always scanned one at a time.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SCAN_WIDTH                     32
+#define SCAN_VECTOR                    __m256i
+#define scan_load(p)                   _mm256_loadu_si256((const __m256i *)(p))
+#define scan_broadcast(ch)             _mm256_set1_epi8((char)(ch))
+#define scan_equal(a, b)               _mm256_cmpeq_epi8(a, b)
+#define scan_or(a, b)                  _mm256_or_si256(a, b)
+#define scan_subtract(a, b)            _mm256_sub_epi8(a, b)
+#define scan_min(a, b)                 _mm256_min_epu8(a, b)
+#define scan_mask(v)                   ((uint32_t)_mm256_movemask_epi8(v))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SCAN_WIDTH                     16
+#define SCAN_VECTOR                    __m128i
+#define scan_load(p)                   _mm_loadu_si128((const __m128i *)(p))
+#define scan_broadcast(ch)             _mm_set1_epi8((char)(ch))
+#define scan_equal(a, b)               _mm_cmpeq_epi8(a, b)
+#define scan_or(a, b)                  _mm_or_si128(a, b)
+#define scan_subtract(a, b)            _mm_sub_epi8(a, b)
+#define scan_min(a, b)                 _mm_min_epu8(a, b)
+#define scan_mask(v)                   ((uint32_t)_mm_movemask_epi8(v))
+#endif
+
+#define TOKEN(_type, _start, _length)                                                              \
     (Token) {                                                                                      \
-        .type = (_type), .start = (_start), .length = (_length), .line = (_line)                   \
+        .type = (_type), .start = (_start), .length = (_length)                                    \
     }
 
+#ifdef SCAN_WIDTH
+#define SCAN_ALL ((uint32_t)((1ULL << SCAN_WIDTH) - 1)) // a mask bit for every byte of a vector
+// Whitespace, identifier and digit runs in real code are mostly shorter than a vector, so their
+// first bytes are classified one at a time and the vector loop only takes over for long runs.
+// Identifier and digit runs stop at the NUL or newline that ends a source or range, so only
+// whitespace runs need a bounds check.
+#define SCAN_PREFIX 16
+#endif
+
+// Character classes, indexed by byte. Each entry holds a CharClass in its low byte and, for
+// operators, the one-character token type in its high byte, so the first byte of a token is
+// classified and, for most punctuation, typed with a single load. The classes are consecutive so
+// that dispatching on them compiles to a jump table. Bytes outside ASCII, and NUL, have no class.
+typedef enum CharClass {
+    CHAR_NONE,
+    CHAR_ALPHA, // letters and '_'
+    CHAR_DIGIT,
+    CHAR_WHITESPACE,
+    CHAR_OPERATOR,        // a one-character token
+    CHAR_OPERATOR_EQUALS, // followed by '=', the token type is the next one
+    CHAR_SLASH,           // followed by '/', starts a comment
+    CHAR_QUOTE,
+} CharClass;
+
+#define OPERATOR(type)        (CHAR_OPERATOR | (type) << 8)
+#define OPERATOR_EQUALS(type) (CHAR_OPERATOR_EQUALS | (type) << 8)
+#define CHAR_ENTRY(ch)        (char_classes[(unsigned char)(ch)])
+#define CHAR_CLASS(entry)     ((CharClass)((entry)&0xff))
+#define OPERATOR_TYPE(entry)  ((TokenType)((entry) >> 8))
+
+static const uint16_t char_classes[256] = {
+    [' '] = CHAR_WHITESPACE, ['\t'] = CHAR_WHITESPACE, ['\n'] = CHAR_WHITESPACE,
+    ['\v'] = CHAR_WHITESPACE, ['\f'] = CHAR_WHITESPACE, ['\r'] = CHAR_WHITESPACE,
+    ['0'] = CHAR_DIGIT, ['1'] = CHAR_DIGIT, ['2'] = CHAR_DIGIT, ['3'] = CHAR_DIGIT,
+    ['4'] = CHAR_DIGIT, ['5'] = CHAR_DIGIT, ['6'] = CHAR_DIGIT, ['7'] = CHAR_DIGIT,
+    ['8'] = CHAR_DIGIT, ['9'] = CHAR_DIGIT,
+    ['A'] = CHAR_ALPHA, ['B'] = CHAR_ALPHA, ['C'] = CHAR_ALPHA, ['D'] = CHAR_ALPHA,
+    ['E'] = CHAR_ALPHA, ['F'] = CHAR_ALPHA, ['G'] = CHAR_ALPHA, ['H'] = CHAR_ALPHA,
+    ['I'] = CHAR_ALPHA, ['J'] = CHAR_ALPHA, ['K'] = CHAR_ALPHA, ['L'] = CHAR_ALPHA,
+    ['M'] = CHAR_ALPHA, ['N'] = CHAR_ALPHA, ['O'] = CHAR_ALPHA, ['P'] = CHAR_ALPHA,
+    ['Q'] = CHAR_ALPHA, ['R'] = CHAR_ALPHA, ['S'] = CHAR_ALPHA, ['T'] = CHAR_ALPHA,
+    ['U'] = CHAR_ALPHA, ['V'] = CHAR_ALPHA, ['W'] = CHAR_ALPHA, ['X'] = CHAR_ALPHA,
+    ['Y'] = CHAR_ALPHA, ['Z'] = CHAR_ALPHA, ['a'] = CHAR_ALPHA, ['b'] = CHAR_ALPHA,
+    ['c'] = CHAR_ALPHA, ['d'] = CHAR_ALPHA, ['e'] = CHAR_ALPHA, ['f'] = CHAR_ALPHA,
+    ['g'] = CHAR_ALPHA, ['h'] = CHAR_ALPHA, ['i'] = CHAR_ALPHA, ['j'] = CHAR_ALPHA,
+    ['k'] = CHAR_ALPHA, ['l'] = CHAR_ALPHA, ['m'] = CHAR_ALPHA, ['n'] = CHAR_ALPHA,
+    ['o'] = CHAR_ALPHA, ['p'] = CHAR_ALPHA, ['q'] = CHAR_ALPHA, ['r'] = CHAR_ALPHA,
+    ['s'] = CHAR_ALPHA, ['t'] = CHAR_ALPHA, ['u'] = CHAR_ALPHA, ['v'] = CHAR_ALPHA,
+    ['w'] = CHAR_ALPHA, ['x'] = CHAR_ALPHA, ['y'] = CHAR_ALPHA, ['z'] = CHAR_ALPHA,
+    ['_'] = CHAR_ALPHA,
+    ['('] = OPERATOR(TOKEN_LEFT_PAREN), [')'] = OPERATOR(TOKEN_RIGHT_PAREN),
+    ['{'] = OPERATOR(TOKEN_LEFT_BRACE), ['}'] = OPERATOR(TOKEN_RIGHT_BRACE),
+    [','] = OPERATOR(TOKEN_COMMA), ['.'] = OPERATOR(TOKEN_DOT), ['+'] = OPERATOR(TOKEN_PLUS),
+    ['-'] = OPERATOR(TOKEN_MINUS), [';'] = OPERATOR(TOKEN_SEMICOLON), ['/'] = CHAR_SLASH,
+    ['*'] = OPERATOR(TOKEN_STAR), ['!'] = OPERATOR_EQUALS(TOKEN_BANG),
+    ['='] = OPERATOR_EQUALS(TOKEN_EQUAL), ['>'] = OPERATOR_EQUALS(TOKEN_GREATER),
+    ['<'] = OPERATOR_EQUALS(TOKEN_LESS), ['"'] = CHAR_QUOTE,
+};
+
 #pragma region Declare
 
 static inline const char *peek(Scanner *scanner);
-static inline const char *peekN(Scanner *scanner, size_t count);
 static inline bool match(Scanner *scanner, const char ch);
 static inline const char *advance(Scanner *scanner);
 static inline bool eof(Scanner *scanner);
-static KeywordTrieNode *build_keywords(Scanner *scanner);
-static void insert_keyword(Vector *vec, KeywordTrieNode *root, const char *keyword, TokenType type);
-static Token scan_error(Scanner *scanner, int line, const char *fmt, ...);
+static Token scan_error(Scanner *scanner, const char *at, String *message);
 static Token scan_string(Scanner *scanner);
 static Token scan_identifier(Scanner *scanner);
 static Token scan_number(Scanner *scanner);
 static Token scan_comment(Scanner *scanner);
-static KeywordTrieNode *is_keyword(Scanner *scanner, const char *word, int length);
+static TokenType identifier_type(const char *word, int length);
+static inline TokenType check_keyword(const char *word, int length, int offset, const char *rest,
+                                      TokenType type);
+static inline const char *skip_whitespace(const char *ch, const char *end);
+static inline const char *skip_identifier(const char *ch, const char *end);
+static inline const char *skip_digits(const char *ch, const char *end);
+static inline const char *find_newline(const char *ch, const char *end);
+static inline const char *find_quote(const char *ch, const char *end);
 static inline bool is_digit(char ch);
 static inline bool is_alpha(char ch);
+static inline bool is_alnum(char ch);
+static inline bool is_whitespace(char ch);
 
 #pragma endregion
 
 #pragma region Public
 
 void scanner_init(Scanner *scanner, Allocator *alloc, const char *source) {
-    scanner->start = source;
-    scanner->current = source;
-    scanner->line = 1;
-    scanner->alloc = alloc;
-    vector_init(&scanner->keywords_vec, alloc, DEFAULT_KEYWORDS_CAPACITY, sizeof(KeywordTrieNode));
-    scanner->keywords = build_keywords(scanner);
+    scanner_init_range(scanner, alloc, source, source + strlen(source));
+}
+
+// Scans [start, end) of a larger source. `end` must be the source's terminating NUL or follow a
+// newline outside any string, so that no token crosses it.
+void scanner_init_range(Scanner *scanner, Allocator *alloc, const char *start, const char *end) {
+    *scanner = (Scanner){ .start = start, .current = start, .end = end, .alloc = alloc };
+}
+
+// Scans a whole stream. The window starts out empty, so the first scan refills it.
+void scanner_init_stream(Scanner *scanner, Allocator *alloc, SourceStream *stream) {
+    scanner_init_range(scanner, alloc, stream->buffer, stream->buffer + stream->end);
+    scanner->stream = stream;
 }
 
+// A scanner holds no resources of its own; error messages belong to the caller's allocator.
 void scanner_destroy(Scanner *scanner) {
-    vector_destroy(&scanner->keywords_vec);
+    (void)scanner;
 }
 
 Token scanner_scan(Scanner *scanner) {
-    const char *start = scanner->current;
-
-    for (bool skip = true; skip;) {
-        start = peek(scanner);
-        if (eof(scanner))
-            return TOKEN(TOKEN_EOF, NULL, 0, scanner->line);
-        switch (*start) {
-        case '\n':
-            scanner->line++;
-        case ' ':
-        case '\t':
-        case '\v':
-        case '\f':
-        case '\r':
-            advance(scanner);
-            break;
-        default:
-            skip = false;
-            break;
-        }
+    // The class found here both skips whitespace and dispatches the token. The end of the source
+    // classifies as CHAR_NONE.
+    const char *start = peek(scanner);
+    uint16_t entry = start < scanner->end ? CHAR_ENTRY(*start) : CHAR_NONE;
+    if (CHAR_CLASS(entry) == CHAR_WHITESPACE) {
+        start = scanner->current = skip_whitespace(start, scanner->end);
+        entry = start < scanner->end ? CHAR_ENTRY(*start) : CHAR_NONE;
     }
-
-    switch (*start) {
-    case '(':
-        return TOKEN(TOKEN_LEFT_PAREN, advance(scanner), 1, scanner->line);
-    case ')':
-        return TOKEN(TOKEN_RIGHT_PAREN, advance(scanner), 1, scanner->line);
-    case '{':
-        return TOKEN(TOKEN_LEFT_BRACE, advance(scanner), 1, scanner->line);
-    case '}':
-        return TOKEN(TOKEN_RIGHT_BRACE, advance(scanner), 1, scanner->line);
-    case ',':
-        return TOKEN(TOKEN_COMMA, advance(scanner), 1, scanner->line);
-    case '.':
-        return TOKEN(TOKEN_DOT, advance(scanner), 1, scanner->line);
-    case '+':
-        return TOKEN(TOKEN_PLUS, advance(scanner), 1, scanner->line);
-    case '-':
-        return TOKEN(TOKEN_MINUS, advance(scanner), 1, scanner->line);
-    case ';':
-        return TOKEN(TOKEN_SEMICOLON, advance(scanner), 1, scanner->line);
-    case '*':
-        return TOKEN(TOKEN_STAR, advance(scanner), 1, scanner->line);
-    case '!':
-        advance(scanner);
-        return match(scanner, '=') ? TOKEN(TOKEN_BANG_EQUAL, start, 2, scanner->line)
-                                   : TOKEN(TOKEN_BANG, start, 1, scanner->line);
-    case '=':
-        advance(scanner);
-        return match(scanner, '=') ? TOKEN(TOKEN_EQUAL_EQUAL, start, 2, scanner->line)
-                                   : TOKEN(TOKEN_EQUAL, start, 1, scanner->line);
-    case '>':
-        advance(scanner);
-        return match(scanner, '=') ? TOKEN(TOKEN_GREATER_EQUAL, start, 2, scanner->line)
-                                   : TOKEN(TOKEN_GREATER, start, 1, scanner->line);
-    case '<':
+    switch (CHAR_CLASS(entry)) {
+    case CHAR_ALPHA:
+        return scan_identifier(scanner);
+    case CHAR_DIGIT:
+        return scan_number(scanner);
+    case CHAR_OPERATOR:
+        return TOKEN(OPERATOR_TYPE(entry), advance(scanner), 1);
+    case CHAR_OPERATOR_EQUALS:
         advance(scanner);
-        return match(scanner, '=') ? TOKEN(TOKEN_LESS_EQUAL, start, 2, scanner->line)
-                                   : TOKEN(TOKEN_LESS, start, 1, scanner->line);
-    case '/':
+        return match(scanner, '=') ? TOKEN(OPERATOR_TYPE(entry) + 1, start, 2)
+                                   : TOKEN(OPERATOR_TYPE(entry), start, 1);
+    case CHAR_SLASH:
         advance(scanner);
-        return match(scanner, '/') ? scan_comment(scanner)
-                                   : TOKEN(TOKEN_SLASH, start, 1, scanner->line);
-    case '"':
+        return match(scanner, '/') ? scan_comment(scanner) : TOKEN(TOKEN_SLASH, start, 1);
+    case CHAR_QUOTE:
         advance(scanner);
         return scan_string(scanner);
+    case CHAR_NONE:
+    case CHAR_WHITESPACE:
+        break;
     }
+    if (eof(scanner))
+        return TOKEN(TOKEN_EOF, scanner->end, 0);
 
-    if (is_alpha(*start))
-        return scan_identifier(scanner);
-    if (is_digit(*start))
-        return scan_number(scanner);
+    return scan_error(scanner, advance(scanner),
+                      string_sprintf(scanner->alloc, "Unexpected character '%c'", *start));
+}
 
-    String *error = string_sprintf(scanner->alloc, "Unexpected character '%c'", *peek(scanner));
-    Assert(error != NULL);
-    return TOKEN(TOKEN_ERROR, error->data, 0, scanner->line);
+// Scans the next token of the scanner's stream. A token that reaches the end of the window may
+// continue past it (only TOKEN_EOF and an unterminated string can), so the window is refilled and
+// the token scanned again. `held` is a token the caller still needs, such as the parser's previous
+// one, or NULL: a refill keeps its bytes and moves it along with them. Any other token scanned
+// before this one is invalidated by a refill.
+Token scanner_scan_stream(Scanner *scanner, Token *held) {
+    SourceStream *stream = scanner->stream;
+    bool holding = held != NULL && held->start != NULL;
+    for (;;) {
+        Token token = scanner_scan(scanner);
+        if (scanner->current < scanner->end || stream->done) {
+            return token;
+        }
+        const char *keep = holding && held->start < token.start ? held->start : token.start;
+        size_t current = (size_t)(token.start - keep);
+        size_t kept = holding ? (size_t)(held->start - keep) : 0;
+        source_stream_refill(stream, (size_t)(keep - stream->buffer));
+        scanner->start = stream->buffer;
+        scanner->current = stream->buffer + current;
+        scanner->end = stream->buffer + stream->end;
+        if (holding) {
+            held->start = stream->buffer + kept;
+        }
+    }
 }
 
 String *token_repr(Token *token, Allocator *alloc) {
-    return string_sprintf(alloc, "Token { type=%s, start=\"%.*s\", length=%d, line=%d }",
-                          token_type_name(token->type), token->length, token->start, token->length,
-                          token->line);
+    return string_sprintf(alloc, "Token { type=%s, start=\"%.*s\", length=%d }",
+                          token_type_name(token->type), token->length, token->start, token->length);
 }
 
 #pragma endregion
@@ -152,146 +235,257 @@ static inline bool match(Scanner *scanner, const char ch) {
     return true;
 }
 
-static inline const char *peekN(Scanner *scanner, size_t count) {
-    return scanner->current + count;
-}
-
 static inline const char *advance(Scanner *scanner) {
     return scanner->current++;
 }
 
 static inline bool eof(Scanner *scanner) {
-    return *scanner->current == '\0';
-}
-
-static KeywordTrieNode *build_keywords(Scanner *scanner) {
-    Vector *vec = &scanner->keywords_vec;
-    // KeywordTrieNode* root = (KeywordTrieNode*)vector_append(vec, &(KeywordTrieNode) {0});
-    KeywordTrieNode _root = { 0 };
-    _root.ch = '?';
-    KeywordTrieNode *root = (KeywordTrieNode *)vector_append(vec, &_root);
-    insert_keyword(vec, root, "and", TOKEN_AND);
-    insert_keyword(vec, root, "class", TOKEN_CLASS);
-    insert_keyword(vec, root, "else", TOKEN_ELSE);
-    insert_keyword(vec, root, "false", TOKEN_FALSE);
-    insert_keyword(vec, root, "for", TOKEN_FOR);
-    insert_keyword(vec, root, "fun", TOKEN_FUN);
-    insert_keyword(vec, root, "if", TOKEN_IF);
-    insert_keyword(vec, root, "nil", TOKEN_NIL);
-    insert_keyword(vec, root, "or", TOKEN_OR);
-    insert_keyword(vec, root, "print", TOKEN_PRINT);
-    insert_keyword(vec, root, "return", TOKEN_RETURN);
-    insert_keyword(vec, root, "super", TOKEN_SUPER);
-    insert_keyword(vec, root, "this", TOKEN_THIS);
-    insert_keyword(vec, root, "true", TOKEN_TRUE);
-    insert_keyword(vec, root, "var", TOKEN_VAR);
-    insert_keyword(vec, root, "while", TOKEN_WHILE);
-    return root;
-}
-
-static void insert_keyword(Vector *vec, KeywordTrieNode *root, const char *keyword,
-                           TokenType type) {
-    // TODO: fix bug here
-    KeywordTrieNode *iter = root;
-    while (*keyword) {
-        Assert(is_alpha(*keyword));
-        int index = *keyword >= 'a' ? *keyword - 'a' : *keyword - 'A';
-        KeywordTrieNode *next = iter->children[index];
-        if (next == NULL) {
-            next = (KeywordTrieNode *)vector_append(vec, &(KeywordTrieNode){ 0 });
-            Assert(next != NULL);
-            next->ch = *keyword;
-            iter->children[index] = next;
-        }
-        iter = next;
-        keyword++;
-    }
-    Assert(iter->end == false);
-    iter->end = true;
-    iter->type = type;
+    return scanner->current >= scanner->end;
 }
 
-static Token scan_error(Scanner *scanner, int line, const char *fmt, ...) {
-    va_list args;
-    va_start(args, fmt);
-    String *error = string_sprintf(scanner->alloc, fmt, args);
-    va_end(args);
-    Assert(error != NULL);
-    return TOKEN(TOKEN_ERROR, error->data, 0, line);
+// Returns an empty TOKEN_ERROR at `at`, keeping its message in the scanner.
+static Token scan_error(Scanner *scanner, const char *at, String *message) {
+    Assert(message != NULL);
+    scanner->error = message->data;
+    return TOKEN(TOKEN_ERROR, at, 0);
 }
 
+// Scans a string whose opening quote has been consumed. The token excludes the quotes, which
+// parser_error_at puts back when it reports the token.
 static Token scan_string(Scanner *scanner) {
-    int line = scanner->line;
-    const char *start = advance(scanner); // consume start quote
-    const char *ch = advance(scanner);
-    for (; !eof(scanner) && *ch != '"'; ch = peek(scanner)) {
-        if (*ch == '\n')
-            scanner->line++;
-        advance(scanner);
+    const char *start = peek(scanner);
+    const char *quote = find_quote(start, scanner->end);
+    if (quote == scanner->end) {
+        scanner->current = scanner->end;
+        return scan_error(scanner, start - 1,
+                          string_sprintf(scanner->alloc, "Unterminated string"));
     }
-    if (eof(scanner))
-        return scan_error(scanner, line, "Unterminated string");
-    advance(scanner); // consume end quote
-    return TOKEN(TOKEN_STRING, start, ch - start, line);
+    scanner->current = quote + 1; // consume end quote
+    return TOKEN(TOKEN_STRING, start, quote - start);
 }
 
 static Token scan_identifier(Scanner *scanner) {
     const char *start = advance(scanner);
     Assert(is_alpha(*start));
-    const char *ch = peek(scanner);
-    for (; !eof(scanner) && (is_digit(*ch) || is_alpha(*ch)); ch = peek(scanner)) {
-        advance(scanner);
-    }
-    KeywordTrieNode *node = is_keyword(scanner, start, ch - start);
-    TokenType type = node != NULL ? node->type : TOKEN_IDENTIFIER;
-    return TOKEN(type, start, ch - start, scanner->line);
+    const char *ch = skip_identifier(peek(scanner), scanner->end);
+    scanner->current = ch;
+    return TOKEN(identifier_type(start, ch - start), start, ch - start);
 }
 
 static Token scan_number(Scanner *scanner) {
-    int line = scanner->line;
     const char *start = advance(scanner);
     Assert(is_digit(*start));
-    const char *ch = peek(scanner);
-    for (; !eof(scanner) && is_digit(*ch); ch = peek(scanner))
-        advance(scanner);
-    if (*ch == '.' && is_digit(*peekN(scanner, 1))) {
-        advance(scanner); // consume dot
-        ch = advance(scanner);
-        for (; !eof(scanner) && is_digit(*ch); ch = peek(scanner))
-            advance(scanner);
+    const char *ch = skip_digits(peek(scanner), scanner->end);
+    if (scanner->end - ch > 1 && *ch == '.' && is_digit(ch[1])) {
+        ch = skip_digits(ch + 2, scanner->end); // the dot and the first fractional digit
     }
-    return TOKEN(TOKEN_NUMBER, start, ch - start, line);
+    scanner->current = ch;
+    return TOKEN(TOKEN_NUMBER, start, ch - start);
 }
 
+// Scans a comment whose `//` has been consumed, up to but excluding the end of the line.
 static Token scan_comment(Scanner *scanner) {
-    int line = scanner->line;
-    const char *start = advance(scanner);
-    const char *ch = peek(scanner);
-    for (; !eof(scanner) && *ch != '\n'; ch = peek(scanner)) {
-        advance(scanner);
+    const char *start = peek(scanner);
+    const char *ch = find_newline(start, scanner->end);
+    scanner->current = ch;
+    return TOKEN(TOKEN_COMMENT, start, ch - start);
+}
+
+// Recognises the keywords with a switch on the first character, and on the second where several
+// keywords share it, followed by a single comparison of the rest of the word. Keywords are fixed at
+// compile time, so there is nothing to build or look up per scanner.
+static TokenType identifier_type(const char *word, int length) {
+    switch (word[0]) {
+    case 'a':
+        return check_keyword(word, length, 1, "nd", TOKEN_AND);
+    case 'c':
+        return check_keyword(word, length, 1, "lass", TOKEN_CLASS);
+    case 'e':
+        return check_keyword(word, length, 1, "lse", TOKEN_ELSE);
+    case 'f':
+        if (length > 1) {
+            switch (word[1]) {
+            case 'a':
+                return check_keyword(word, length, 2, "lse", TOKEN_FALSE);
+            case 'o':
+                return check_keyword(word, length, 2, "r", TOKEN_FOR);
+            case 'u':
+                return check_keyword(word, length, 2, "n", TOKEN_FUN);
+            }
+        }
+        break;
+    case 'i':
+        return check_keyword(word, length, 1, "f", TOKEN_IF);
+    case 'n':
+        return check_keyword(word, length, 1, "il", TOKEN_NIL);
+    case 'o':
+        return check_keyword(word, length, 1, "r", TOKEN_OR);
+    case 'p':
+        return check_keyword(word, length, 1, "rint", TOKEN_PRINT);
+    case 'r':
+        return check_keyword(word, length, 1, "eturn", TOKEN_RETURN);
+    case 's':
+        return check_keyword(word, length, 1, "uper", TOKEN_SUPER);
+    case 't':
+        if (length > 1) {
+            switch (word[1]) {
+            case 'h':
+                return check_keyword(word, length, 2, "is", TOKEN_THIS);
+            case 'r':
+                return check_keyword(word, length, 2, "ue", TOKEN_TRUE);
+            }
+        }
+        break;
+    case 'v':
+        return check_keyword(word, length, 1, "ar", TOKEN_VAR);
+    case 'w':
+        return check_keyword(word, length, 1, "hile", TOKEN_WHILE);
     }
-    return TOKEN(TOKEN_COMMENT, start, ch - start, line);
+    return TOKEN_IDENTIFIER;
 }
 
-static KeywordTrieNode *is_keyword(Scanner *scanner, const char *word, int length) {
-    KeywordTrieNode *iter = scanner->keywords;
-    for (int i = 0; iter != NULL && i < length; i++) {
-        char ch = word[i];
-        if (ch == '\0')
-            return NULL;
-        Assert(is_alpha(ch));
-        int index = ch >= 'a' ? ch - 'a' : ch - 'A';
-        iter = iter->children[index];
+// `rest` is a literal, so its length folds to a constant once inlined.
+static inline TokenType check_keyword(const char *word, int length, int offset, const char *rest,
+                                      TokenType type) {
+    int rest_length = (int)strlen(rest);
+    if (length == offset + rest_length && memcmp(word + offset, rest, rest_length) == 0) {
+        return type;
     }
-    return iter && iter->end ? iter : NULL;
+    return TOKEN_IDENTIFIER;
+}
+
+#ifdef SCAN_WIDTH
+
+// Sets each byte of the result whose byte of `v` lies in [lo, hi], using a wrapping subtraction
+// and an unsigned minimum since SSE2 has no unsigned byte comparison.
+static inline SCAN_VECTOR in_range(SCAN_VECTOR v, char lo, char hi) {
+    SCAN_VECTOR offset = scan_subtract(v, scan_broadcast(lo));
+    return scan_equal(scan_min(offset, scan_broadcast(hi - lo)), offset);
+}
+
+static inline uint32_t whitespace_mask(SCAN_VECTOR v) {
+    // '\t', '\n', '\v', '\f' and '\r' are contiguous
+    return scan_mask(scan_or(scan_equal(v, scan_broadcast(' ')), in_range(v, '\t', '\r')));
+}
+
+static inline uint32_t identifier_mask(SCAN_VECTOR v) {
+    // Setting bit 5 folds upper case onto lower case without making any other byte a letter.
+    SCAN_VECTOR letters = in_range(scan_or(v, scan_broadcast(0x20)), 'a', 'z');
+    SCAN_VECTOR digits = in_range(v, '0', '9');
+    return scan_mask(scan_or(scan_or(letters, digits), scan_equal(v, scan_broadcast('_'))));
+}
+
+#endif
+
+// Returns the first byte that is not whitespace.
+static inline const char *skip_whitespace(const char *ch, const char *end) {
+#ifdef SCAN_WIDTH
+    for (int i = 0; i < SCAN_PREFIX; i++, ch++) {
+        if (ch == end || !is_whitespace(*ch))
+            return ch;
+    }
+    for (; end - ch >= SCAN_WIDTH; ch += SCAN_WIDTH) {
+        uint32_t stop = ~whitespace_mask(scan_load(ch)) & SCAN_ALL;
+        if (stop != 0) {
+            return ch + __builtin_ctz(stop);
+        }
+    }
+#endif
+    while (ch < end && is_whitespace(*ch)) {
+        ch++;
+    }
+    return ch;
+}
+
+// Returns the first byte that can't continue an identifier.
+static inline const char *skip_identifier(const char *ch, const char *end) {
+#ifdef SCAN_WIDTH
+    for (int i = 0; i < SCAN_PREFIX; i++, ch++) {
+        if (!is_alnum(*ch))
+            return ch;
+    }
+    for (; end - ch >= SCAN_WIDTH; ch += SCAN_WIDTH) {
+        uint32_t stop = ~identifier_mask(scan_load(ch)) & SCAN_ALL;
+        if (stop != 0) {
+            return ch + __builtin_ctz(stop);
+        }
+    }
+#else
+    (void)end; // the scalar loops stop at the NUL or newline before it
+#endif
+    while (is_alnum(*ch)) {
+        ch++;
+    }
+    return ch;
+}
+
+static inline const char *skip_digits(const char *ch, const char *end) {
+#ifdef SCAN_WIDTH
+    for (int i = 0; i < SCAN_PREFIX; i++, ch++) {
+        if (!is_digit(*ch))
+            return ch;
+    }
+    for (; end - ch >= SCAN_WIDTH; ch += SCAN_WIDTH) {
+        uint32_t stop = ~scan_mask(in_range(scan_load(ch), '0', '9')) & SCAN_ALL;
+        if (stop != 0) {
+            return ch + __builtin_ctz(stop);
+        }
+    }
+#else
+    (void)end; // the scalar loops stop at the NUL or newline before it
+#endif
+    while (is_digit(*ch)) {
+        ch++;
+    }
+    return ch;
+}
+
+// Returns the first newline, or `end`.
+static inline const char *find_newline(const char *ch, const char *end) {
+#ifdef SCAN_WIDTH
+    for (; end - ch >= SCAN_WIDTH; ch += SCAN_WIDTH) {
+        uint32_t found = scan_mask(scan_equal(scan_load(ch), scan_broadcast('\n')));
+        if (found != 0) {
+            return ch + __builtin_ctz(found);
+        }
+    }
+#endif
+    while (ch < end && *ch != '\n') {
+        ch++;
+    }
+    return ch;
+}
+
+// Returns the first double quote, or `end`.
+static inline const char *find_quote(const char *ch, const char *end) {
+#ifdef SCAN_WIDTH
+    for (; end - ch >= SCAN_WIDTH; ch += SCAN_WIDTH) {
+        uint32_t found = scan_mask(scan_equal(scan_load(ch), scan_broadcast('"')));
+        if (found != 0) {
+            return ch + __builtin_ctz(found);
+        }
+    }
+#endif
+    while (ch < end && *ch != '"') {
+        ch++;
+    }
+    return ch;
 }
 
 static inline bool is_digit(char ch) {
-    return ch >= '0' && ch <= '9';
+    return CHAR_CLASS(CHAR_ENTRY(ch)) == CHAR_DIGIT;
 }
 
 static inline bool is_alpha(char ch) {
-    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+    return CHAR_CLASS(CHAR_ENTRY(ch)) == CHAR_ALPHA;
 }
 
-#pragma endregion
+static inline bool is_alnum(char ch) {
+    return (unsigned)(CHAR_CLASS(CHAR_ENTRY(ch)) - CHAR_ALPHA) <= CHAR_DIGIT - CHAR_ALPHA;
+}
+
+static inline bool is_whitespace(char ch) {
+    return CHAR_CLASS(CHAR_ENTRY(ch)) == CHAR_WHITESPACE;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -5,9 +5,8 @@
 
 #include "array.h"
 #include "assert.h"
-#include "vector.h"
+#include "source_stream.h"
 
-#define ALPHABET_SIZE 26
 typedef enum TokenType {
     TOKEN_BYTE,
     // 1 character tokens
@@ -59,33 +58,30 @@ typedef enum TokenType {
     TOKEN_EOF,
 } TokenType;
 
+// A slice of the source. Lines aren't tracked while scanning; a LineIndex finds them from `start`
+// when they are needed. TOKEN_EOF is empty at the end of the source and TOKEN_ERROR is empty where
+// the error was found, with its message kept by the scanner.
 typedef struct Token {
     TokenType type;
     const char *start;
     int length;
-    int line;
 } Token;
 
-typedef struct KeywordTrieNode {
-    char ch;
-    TokenType type;
-    bool end;
-    int num_children;
-    struct KeywordTrieNode *children[ALPHABET_SIZE];
-} KeywordTrieNode;
-
 typedef struct Scanner {
     const char *start;
     const char *current;
-    int line;
-    KeywordTrieNode *keywords;
-    Vector keywords_vec;
+    const char *end;      // the terminating NUL, or just after a newline; never read past
+    const char *error;    // the message of the last TOKEN_ERROR
+    SourceStream *stream; // refilled by scanner_scan_stream, or NULL
     Allocator *alloc;
 } Scanner;
 
 void scanner_init(Scanner *scan, Allocator *alloc, const char *source);
+void scanner_init_range(Scanner *scanner, Allocator *alloc, const char *start, const char *end);
+void scanner_init_stream(Scanner *scanner, Allocator *alloc, SourceStream *stream);
 void scanner_destroy(Scanner *scanner);
 Token scanner_scan(Scanner *scan);
+Token scanner_scan_stream(Scanner *scanner, Token *held);
 
 String *token_repr(Token *token, Allocator *alloc);
 
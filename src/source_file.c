@@ -0,0 +1,137 @@
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "source_file.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+#define MIN_CAPACITY 4096
+
+#pragma region Declare
+
+static char *map_terminated(int fd, size_t length);
+static bool read_whole(SourceFile *file, int fd, size_t capacity, bool sized);
+
+#pragma endregion
+
+#pragma region Public
+
+// Maps the regular file open on `fd`, which stays owned by the caller. Returns false with errno
+// set if it can't be loaded; ENODEV means `fd` isn't a regular file, which can be read or streamed
+// instead.
+bool source_file_map(SourceFile *file, Allocator *alloc, int fd) {
+    *file = (SourceFile){ .source = "", .alloc = alloc };
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return false;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        errno = ENODEV;
+        return false;
+    }
+    size_t length = (size_t)info.st_size;
+    if (length == 0) {
+        return true;
+    }
+    if (length < SOURCE_FILE_MIN_MAPPED) {
+        return read_whole(file, fd, length, true);
+    }
+    char *mapping = map_terminated(fd, length);
+    if (mapping == NULL) {
+        return false;
+    }
+    posix_madvise(mapping, length, POSIX_MADV_SEQUENTIAL); // the scanner reads it once, in order
+    file->mapping = mapping;
+    file->source = (const char *)mapping;
+    file->length = length;
+    return true;
+}
+
+// Reads all of `fd`, which stays owned by the caller, into a writable buffer: at once if it is a
+// regular file, and otherwise until it ends. Returns false with errno set if reading failed.
+bool source_file_read(SourceFile *file, Allocator *alloc, int fd) {
+    *file = (SourceFile){ .source = "", .alloc = alloc };
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        return false;
+    }
+    if (S_ISREG(info.st_mode)) {
+        return read_whole(file, fd, (size_t)info.st_size, true);
+    }
+    return read_whole(file, fd, MIN_CAPACITY, false);
+}
+
+void source_file_destroy(SourceFile *file) {
+    if (file->mapping != NULL) {
+        munmap(file->mapping, file->length + 1);
+    }
+    if (file->buffer != NULL) {
+        allocator_free(file->alloc, file->buffer);
+    }
+    *file = (SourceFile){ 0 };
+}
+
+#pragma endregion
+
+#pragma region Private
+
+// Maps `length` bytes of `fd` followed by a NUL, or returns NULL with errno set. The file is
+// mapped over the start of a reservation of anonymous zero pages one byte longer than it. If the
+// file ends partway through a page, the kernel zero-fills the rest of that page. If the file fills
+// its last page, the NUL is the first byte of the reserved page after it.
+static char *map_terminated(int fd, size_t length) {
+    void *reserved = mmap(NULL, length + 1, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        return NULL;
+    }
+    if (mmap(reserved, length, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int error = errno;
+        munmap(reserved, length + 1);
+        errno = error;
+        return NULL;
+    }
+    return (char *)reserved;
+}
+
+// Reads until the input ends or, if it is `sized`, `capacity` bytes have been read; otherwise the
+// buffer doubles whenever it fills.
+static bool read_whole(SourceFile *file, int fd, size_t capacity, bool sized) {
+    char *buffer = (char *)allocator_alloc(file->alloc, capacity + 1);
+    size_t length = 0;
+    for (;;) {
+        if (length == capacity) {
+            if (sized) {
+                break;
+            }
+            buffer = (char *)allocator_realloc(file->alloc, buffer, capacity + 1, capacity * 2 + 1);
+            capacity *= 2;
+        }
+        ssize_t count = read(fd, buffer + length, capacity - length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            int error = errno;
+            allocator_free(file->alloc, buffer);
+            errno = error;
+            return false;
+        }
+        if (count == 0) {
+            break;
+        }
+        length += (size_t)count;
+    }
+    buffer[length] = '\0';
+    file->buffer = buffer;
+    file->source = buffer;
+    file->length = length;
+    return true;
+}
+
+#pragma endregion
\ No newline at end of file
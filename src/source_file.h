@@ -0,0 +1,33 @@
+#ifndef clox_source_file_h
+#define clox_source_file_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "allocator.h"
+
+/**
+ * A whole source loaded from a file descriptor as a NUL-terminated string.
+ * A regular file is mapped read-only rather than copied, over anonymous zero pages reserved one
+ * byte past its end, so the byte after the file is always a NUL: the kernel's zero fill of the
+ * file's last page, or the first byte of the reserved page after it when the file fills that page.
+ * A file smaller than SOURCE_FILE_MIN_MAPPED takes less time to copy than to map and unmap, and is
+ * read into a single buffer of the size fstat reports. Input whose size isn't known up front, like
+ * a pipe, is read into a buffer that doubles as it fills.
+ */
+
+#define SOURCE_FILE_MIN_MAPPED (64 * 1024)
+
+typedef struct SourceFile {
+    const char *source; // NUL-terminated
+    size_t length;
+    void *mapping;      // the mapped file and the NUL after it, or NULL
+    char *buffer;       // the bytes read, or NULL; writable, unlike a mapping
+    Allocator *alloc;
+} SourceFile;
+
+bool source_file_map(SourceFile *file, Allocator *alloc, int fd);
+bool source_file_read(SourceFile *file, Allocator *alloc, int fd);
+void source_file_destroy(SourceFile *file);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "assert.h"
+#include "source_stream.h"
+
+#pragma region Declare
+
+static bool grow(SourceStream *stream);
+static int count_newlines(const char *ch, const char *end);
+static const char *last_newline(const char *start, const char *end);
+
+#pragma endregion
+
+#pragma region Public
+
+// Reads `fd`, which stays owned by the caller, `window` bytes at a time. Nothing is read until the
+// first refill.
+void source_stream_init(SourceStream *stream, Allocator *alloc, int fd, size_t window) {
+    Assert(window > 0);
+    *stream = (SourceStream){
+        .fd = fd,
+        .capacity = window,
+        .max_capacity = window > SOURCE_STREAM_MAX_CAPACITY ? window : SOURCE_STREAM_MAX_CAPACITY,
+        .first_line = 1,
+        .alloc = alloc,
+    };
+    stream->buffer = (char *)allocator_alloc(alloc, window + 1);
+    stream->buffer[0] = '\0';
+    line_index_init(&stream->lines, alloc, stream->buffer, 0);
+}
+
+void source_stream_destroy(SourceStream *stream) {
+    line_index_destroy(&stream->lines);
+    allocator_free(stream->alloc, stream->buffer);
+    *stream = (SourceStream){ 0 };
+}
+
+// Drops the first `keep` bytes of the buffer, which must have been scanned, and reads until a
+// newline follows the bytes that could already be scanned, or the input ends. Returns false if
+// there was nothing more to read.
+bool source_stream_refill(SourceStream *stream, size_t keep) {
+    Assert(keep <= stream->end);
+    if (stream->done) {
+        return false;
+    }
+    stream->first_line += count_newlines(stream->buffer, stream->buffer + keep);
+    memmove(stream->buffer, stream->buffer + keep, stream->length - keep);
+    stream->length -= keep;
+    size_t scanned = stream->end - keep;
+    for (;;) {
+        if (stream->length == stream->capacity && !grow(stream)) {
+            // A line or string too long to hold; what came before it can still be scanned.
+            stream->error = EFBIG;
+            stream->done = true;
+            stream->end = scanned;
+            break;
+        }
+        ssize_t count = read(stream->fd, stream->buffer + stream->length,
+                             stream->capacity - stream->length);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            stream->error = count < 0 ? errno : 0;
+            stream->done = true;
+            stream->end = stream->length;
+            break;
+        }
+        stream->length += (size_t)count;
+        const char *newline = last_newline(stream->buffer + scanned,
+                                           stream->buffer + stream->length);
+        if (newline != NULL) {
+            stream->end = (size_t)(newline + 1 - stream->buffer);
+            break;
+        }
+    }
+    stream->buffer[stream->length] = '\0';
+    line_index_destroy(&stream->lines);
+    line_index_init(&stream->lines, stream->alloc, stream->buffer, stream->length);
+    return stream->end > scanned;
+}
+
+#pragma endregion
+
+#pragma region Private
+
+// Doubles the buffer for a line or string longer than the window, up to the stream's maximum.
+static bool grow(SourceStream *stream) {
+    if (stream->capacity >= stream->max_capacity) {
+        return false;
+    }
+    size_t capacity = stream->capacity * 2;
+    if (capacity > stream->max_capacity) {
+        capacity = stream->max_capacity;
+    }
+    stream->buffer = (char *)allocator_realloc(stream->alloc, stream->buffer, stream->length,
+                                               capacity + 1);
+    stream->capacity = capacity;
+    return true;
+}
+
+static int count_newlines(const char *ch, const char *end) {
+    int count = 0;
+    for (; (ch = memchr(ch, '\n', end - ch)) != NULL; ch++) {
+        count++;
+    }
+    return count;
+}
+
+static const char *last_newline(const char *start, const char *end) {
+    for (const char *ch = end; ch > start;) {
+        if (*--ch == '\n') {
+            return ch;
+        }
+    }
+    return NULL;
+}
+
+#pragma endregion
\ No newline at end of file
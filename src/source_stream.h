@@ -0,0 +1,50 @@
+#ifndef clox_source_stream_h
+#define clox_source_stream_h
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "allocator.h"
+#include "line_index.h"
+
+/**
+ * A source read from a file descriptor, such as a pipe, a window at a time.
+ * The scanner works on [buffer, buffer + end), which always stops just after a newline, or at the
+ * end of the input where the buffer is NUL-terminated, so the only token that can run past it is
+ * a string holding a newline. When the scanner reaches `end` it asks for a refill: the bytes it
+ * has consumed are dropped from the front of the buffer, the rest moved down, and more is read
+ * behind them.
+ *
+ * The buffer holds a window of SOURCE_STREAM_WINDOW bytes, growing only while a single line or
+ * string doesn't fit in it, and never past SOURCE_STREAM_MAX_CAPACITY, so memory stays bounded
+ * however large the input. A line or string too long for that ends the stream with EFBIG. Lines are
+ * counted for the bytes dropped, and looked up in a LineIndex of the buffer for the rest.
+ */
+
+#define SOURCE_STREAM_WINDOW       (64 * 1024)
+#define SOURCE_STREAM_MAX_CAPACITY (16 * 1024 * 1024)
+
+typedef struct SourceStream {
+    int fd;
+    char *buffer;    // followed by a NUL
+    size_t capacity; // of the buffer, not counting the NUL
+    size_t max_capacity;
+    size_t length;   // bytes read into the buffer
+    size_t end;      // the bytes that can be scanned: up to the last newline, or all at the end
+    int first_line;  // the line of buffer[0]
+    bool done;       // the whole input has been read, or reading it failed
+    int error;       // the errno of a failed read, or 0
+    LineIndex lines; // of the buffer
+    Allocator *alloc;
+} SourceStream;
+
+void source_stream_init(SourceStream *stream, Allocator *alloc, int fd, size_t window);
+void source_stream_destroy(SourceStream *stream);
+bool source_stream_refill(SourceStream *stream, size_t keep);
+
+// Returns the line of a byte in the buffer, counting from 1.
+static inline int source_stream_line(SourceStream *stream, const char *at) {
+    return stream->first_line - 1 + line_index_line(&stream->lines, (size_t)(at - stream->buffer));
+}
+
+#endif
\ No newline at end of file
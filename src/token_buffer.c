@@ -0,0 +1,277 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "token_buffer.h"
+
+#define MIN_CAPACITY 64
+// Sources shorter than this per thread are scanned on the calling thread alone.
+#define MIN_SEGMENT_SIZE (64 * 1024)
+
+// A piece of the source tokenized by one thread into its own buffer.
+typedef struct Segment {
+    const char *start;
+    const char *end;
+    TokenBuffer tokens;
+    Allocator alloc;
+    pthread_t thread;
+    bool started; // on a thread of its own
+} Segment;
+
+#pragma region Declare
+
+static void reset(TokenBuffer *tokens, const char *source, size_t length, size_t reserved);
+static void tokenize_range(TokenBuffer *tokens, const char *start, const char *end);
+static int split(const char *source, const char *end, const char **bounds, int count);
+static void *segment_main(void *arg);
+static void stitch(TokenBuffer *tokens, Segment *segments, int count);
+static void reserve(TokenBuffer *tokens, size_t capacity);
+static inline void push(TokenBuffer *tokens, TokenType type, uint32_t offset, uint32_t length);
+
+#pragma endregion
+
+#pragma region Public
+
+void token_buffer_init(TokenBuffer *tokens, Allocator *alloc) {
+    *tokens = (TokenBuffer){ .alloc = alloc };
+    line_index_init(&tokens->lines, alloc, NULL, 0);
+}
+
+void token_buffer_destroy(TokenBuffer *tokens) {
+    if (tokens->capacity > 0) {
+        allocator_free(tokens->alloc, tokens->types);
+        allocator_free(tokens->alloc, tokens->offsets);
+        allocator_free(tokens->alloc, tokens->lengths);
+    }
+    line_index_destroy(&tokens->lines);
+    *tokens = (TokenBuffer){ .alloc = tokens->alloc, .lines = tokens->lines };
+}
+
+// Replaces the buffer's tokens with those of `source`, which must outlive the buffer.
+void token_buffer_tokenize(TokenBuffer *tokens, const char *source) {
+    size_t length = strlen(source);
+    // Code averages a token every four or five bytes.
+    reset(tokens, source, length, length / 4);
+    tokenize_range(tokens, source, source + length);
+}
+
+// Tokenizes like token_buffer_tokenize, splitting the source into up to `num_threads` segments at
+// newlines and scanning them in parallel. A pre-pass finds the newlines that aren't inside a
+// string (no newline is inside a comment), and each segment is scanned into its own buffer with
+// its own allocator. The segments' tokens are then copied into `tokens` in order; their offsets
+// already index the whole source.
+void token_buffer_tokenize_parallel(TokenBuffer *tokens, const char *source, int num_threads) {
+    size_t length = strlen(source);
+    int count = num_threads;
+    if ((size_t)count > length / MIN_SEGMENT_SIZE) {
+        count = (int)(length / MIN_SEGMENT_SIZE);
+    }
+    if (count <= 1) {
+        token_buffer_tokenize(tokens, source);
+        return;
+    }
+
+    const char **bounds = (const char **)allocator_alloc(tokens->alloc,
+                                                         (count + 1) * sizeof(const char *));
+    count = split(source, source + length, bounds, count);
+    Segment *segments = (Segment *)allocator_alloc(tokens->alloc, count * sizeof(Segment));
+    for (int i = 0; i < count; i++) {
+        Segment *segment = &segments[i];
+        *segment = (Segment){ .start = bounds[i], .end = bounds[i + 1] };
+        allocator_init(&segment->alloc, tokens->alloc->logger);
+        token_buffer_init(&segment->tokens, &segment->alloc);
+        segment->tokens.source = source;
+    }
+    // The calling thread scans the first segment, and any a thread couldn't be started for.
+    for (int i = 1; i < count; i++) {
+        segments[i].started = pthread_create(&segments[i].thread, NULL, segment_main,
+                                             &segments[i])
+                              == 0;
+    }
+    segment_main(&segments[0]);
+    for (int i = 1; i < count; i++) {
+        if (segments[i].started) {
+            pthread_join(segments[i].thread, NULL);
+        } else {
+            segment_main(&segments[i]);
+        }
+    }
+
+    reset(tokens, source, length, 0);
+    stitch(tokens, segments, count);
+    for (int i = 0; i < count; i++) {
+        token_buffer_destroy(&segments[i].tokens);
+        allocator_destroy(&segments[i].alloc);
+    }
+    allocator_free(tokens->alloc, segments);
+    allocator_free(tokens->alloc, bounds);
+}
+
+// Returns the token at `index` as the scanner would have.
+Token token_buffer_get(TokenBuffer *tokens, size_t index) {
+    Assert(index < tokens->count);
+    return (Token){
+        .type = (TokenType)tokens->types[index],
+        .start = tokens->source + tokens->offsets[index],
+        .length = (int)tokens->lengths[index],
+    };
+}
+
+int token_buffer_line(TokenBuffer *tokens, size_t index) {
+    Assert(index < tokens->count);
+    return line_index_line(&tokens->lines, tokens->offsets[index]);
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static void reset(TokenBuffer *tokens, const char *source, size_t length, size_t reserved) {
+    Assert(length < UINT32_MAX);
+    line_index_destroy(&tokens->lines);
+    line_index_init(&tokens->lines, tokens->alloc, source, length);
+    tokens->source = source;
+    tokens->length = (uint32_t)length;
+    tokens->count = 0;
+    tokens->error = NULL;
+    reserve(tokens, reserved + MIN_CAPACITY);
+}
+
+// Appends the tokens of [start, end) of the buffer's source, ending with TOKEN_EOF at `end`.
+static void tokenize_range(TokenBuffer *tokens, const char *start, const char *end) {
+    Scanner scanner;
+    scanner_init_range(&scanner, tokens->alloc, start, end);
+    uint32_t end_offset = (uint32_t)(end - tokens->source);
+    for (;;) {
+        Token token = scanner_scan(&scanner);
+        switch (token.type) {
+        case TOKEN_COMMENT:
+            continue;
+        case TOKEN_ERROR:
+            tokens->error = scanner.error;
+            push(tokens, TOKEN_ERROR, (uint32_t)(token.start - tokens->source), 0);
+            push(tokens, TOKEN_EOF, end_offset, 0);
+            break;
+        case TOKEN_EOF:
+            push(tokens, TOKEN_EOF, end_offset, 0);
+            break;
+        default:
+            push(tokens, token.type, (uint32_t)(token.start - tokens->source),
+                 (uint32_t)token.length);
+            continue;
+        }
+        break;
+    }
+    scanner_destroy(&scanner);
+}
+
+// Fills `bounds` with the starts of up to `count` segments of about equal size, followed by `end`,
+// and returns how many there are. Every boundary but the last follows a newline outside a string.
+// Only quotes, slashes and the newlines near each target are looked at, so this costs a fraction
+// of scanning.
+static int split(const char *source, const char *end, const char **bounds, int count) {
+    size_t length = end - source;
+    int found = 1;
+    bounds[0] = source;
+    const char *target = source + length / count;
+    const char *ch = source;
+    while (ch < end && found < count) {
+        // [ch, special) is code, outside strings and comments
+        const char *special = ch + strcspn(ch, "\"/");
+        while (target < special && found < count) {
+            const char *from = target > ch ? target : ch;
+            const char *newline = memchr(from, '\n', special - from);
+            if (newline == NULL) {
+                break;
+            }
+            bounds[found++] = newline + 1;
+            ch = newline + 1;
+            target = source + length * found / count;
+        }
+        if (special >= end || found == count) {
+            break;
+        }
+        if (*special == '"') {
+            const char *quote = memchr(special + 1, '"', end - special - 1);
+            ch = quote != NULL ? quote + 1 : end;
+        } else if (special[1] == '/') {
+            const char *newline = memchr(special, '\n', end - special);
+            ch = newline != NULL ? newline : end;
+        } else {
+            ch = special + 1;
+        }
+    }
+    bounds[found] = end;
+    return found;
+}
+
+static void *segment_main(void *arg) {
+    Segment *segment = (Segment *)arg;
+    TokenBuffer *tokens = &segment->tokens;
+    reserve(tokens, (segment->end - segment->start) / 4 + MIN_CAPACITY);
+    tokenize_range(tokens, segment->start, segment->end);
+    return NULL;
+}
+
+// Concatenates the segments' tokens, dropping each one's TOKEN_EOF but the last and stopping at
+// the first error.
+static void stitch(TokenBuffer *tokens, Segment *segments, int count) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += segments[i].tokens.count - 1;
+        if (segments[i].tokens.error != NULL) {
+            count = i + 1;
+            break;
+        }
+    }
+    reserve(tokens, total + 1);
+    for (int i = 0; i < count; i++) {
+        TokenBuffer *segment = &segments[i].tokens;
+        size_t n = segment->count - 1;
+        memcpy(tokens->types + tokens->count, segment->types, n * sizeof(uint8_t));
+        memcpy(tokens->offsets + tokens->count, segment->offsets, n * sizeof(uint32_t));
+        memcpy(tokens->lengths + tokens->count, segment->lengths, n * sizeof(uint32_t));
+        tokens->count += n;
+        if (segment->error != NULL) {
+            // The message lives in the segment's allocator, which is about to be destroyed.
+            size_t size = strlen(segment->error) + 1;
+            tokens->error = (const char *)allocator_memcopy(tokens->alloc, (void *)segment->error,
+                                                            size);
+        }
+    }
+    push(tokens, TOKEN_EOF, tokens->length, 0);
+}
+
+static void reserve(TokenBuffer *tokens, size_t capacity) {
+    if (capacity <= tokens->capacity) {
+        return;
+    }
+    if (tokens->capacity == 0) {
+        tokens->types = (uint8_t *)allocator_alloc(tokens->alloc, capacity * sizeof(uint8_t));
+        tokens->offsets = (uint32_t *)allocator_alloc(tokens->alloc, capacity * sizeof(uint32_t));
+        tokens->lengths = (uint32_t *)allocator_alloc(tokens->alloc, capacity * sizeof(uint32_t));
+    } else {
+        size_t count = tokens->count;
+        tokens->types = (uint8_t *)allocator_realloc(tokens->alloc, tokens->types,
+                                                     count * sizeof(uint8_t),
+                                                     capacity * sizeof(uint8_t));
+        tokens->offsets = (uint32_t *)allocator_realloc(tokens->alloc, tokens->offsets,
+                                                        count * sizeof(uint32_t),
+                                                        capacity * sizeof(uint32_t));
+        tokens->lengths = (uint32_t *)allocator_realloc(tokens->alloc, tokens->lengths,
+                                                        count * sizeof(uint32_t),
+                                                        capacity * sizeof(uint32_t));
+    }
+    tokens->capacity = capacity;
+}
+
+static inline void push(TokenBuffer *tokens, TokenType type, uint32_t offset, uint32_t length) {
+    if (tokens->count == tokens->capacity) {
+        reserve(tokens, tokens->capacity * 2);
+    }
+    size_t index = tokens->count++;
+    tokens->types[index] = (uint8_t)type;
+    tokens->offsets[index] = offset;
+    tokens->lengths[index] = length;
+}
+
+#pragma endregion
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef clox_token_buffer_h
+#define clox_token_buffer_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "allocator.h"
+#include "line_index.h"
+#include "scanner.h"
+
+/**
+ * A whole source tokenized in a single pass into parallel arrays.
+ * Each token is a type byte plus the offset and length of its slice of the source, 9 bytes rather
+ * than a 24-byte Token, and a walk over the types touches nothing else. Comments are dropped since
+ * nothing after the scanner looks at them.
+ *
+ * Lines aren't stored; token_buffer_line looks them up in a LineIndex of the source, built the
+ * first time one is asked for.
+ *
+ * Tokenizing stops at the first scan error, which is followed only by TOKEN_EOF. Its message isn't
+ * a slice of the source, so it is kept aside.
+ */
+
+typedef struct TokenBuffer {
+    const char *source;
+    uint32_t length; // of the source
+    uint8_t *types;
+    uint32_t *offsets; // into the source
+    uint32_t *lengths;
+    size_t count;
+    size_t capacity;
+    const char *error; // the message of a TOKEN_ERROR, or NULL
+    LineIndex lines;
+    Allocator *alloc;
+} TokenBuffer;
+
+void token_buffer_init(TokenBuffer *tokens, Allocator *alloc);
+void token_buffer_destroy(TokenBuffer *tokens);
+void token_buffer_tokenize(TokenBuffer *tokens, const char *source);
+void token_buffer_tokenize_parallel(TokenBuffer *tokens, const char *source, int num_threads);
+Token token_buffer_get(TokenBuffer *tokens, size_t index);
+int token_buffer_line(TokenBuffer *tokens, size_t index);
+
+#endif
\ No newline at end of file
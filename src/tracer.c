@@ -0,0 +1,116 @@
+#include <string.h>
+
+#include "tracer.h"
+
+#define TRACE_RECORD_SIZE 16 // bytes per serialized record
+
+#pragma region Declare
+
+static bool write_bytes(FILE *out, const void *data, size_t size);
+static bool write_u8(FILE *out, uint8_t value);
+static bool write_u16(FILE *out, uint16_t value);
+static bool write_u32(FILE *out, uint32_t value);
+static bool write_u64(FILE *out, uint64_t value);
+
+#pragma endregion
+
+#pragma region Public
+
+void tracer_init(Tracer *tracer, Allocator *alloc, uint32_t capacity) {
+    Assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    *tracer = (Tracer){
+        .mask = capacity - 1,
+        .alloc = alloc,
+    };
+    tracer->records = (TraceRecord *)allocator_alloc(alloc, sizeof(TraceRecord) * capacity);
+}
+
+void tracer_destroy(Tracer *tracer) {
+    allocator_free(tracer->alloc, tracer->records);
+    *tracer = (Tracer){ 0 };
+}
+
+// Writes the buffered records, oldest first, along with everything needed to render them. All
+// integers are little-endian:
+//
+//   header:   char magic[8], u32 version, u32 record size, u64 total, u32 count, u32 num_opcodes
+//   opcodes:  num_opcodes x { u8 length, char name[length] }
+//   lines:    u32 num_encodings, num_encodings x { i32 line, i32 size_count }
+//   records:  count x { u32 offset, u8 opcode, u8 top_type, u16 depth, u64 top }
+//
+// `total` is the number of records written since the last reset; when it exceeds `count` the ring
+// buffer has wrapped and the oldest records were overwritten.
+bool tracer_dump(Tracer *tracer, OpCodeChunk *chunk, FILE *out) {
+    uint64_t capacity = (uint64_t)tracer->mask + 1;
+    uint32_t count = (uint32_t)(tracer->total < capacity ? tracer->total : capacity);
+    bool ok = write_bytes(out, TRACE_FORMAT_MAGIC, strlen(TRACE_FORMAT_MAGIC))
+              && write_u32(out, TRACE_FORMAT_VERSION) && write_u32(out, TRACE_RECORD_SIZE)
+              && write_u64(out, tracer->total) && write_u32(out, count)
+              && write_u32(out, NUM_OPCODES);
+
+    for (int code = 0; ok && code < NUM_OPCODES; code++) {
+        const char *name = opcode_name(code);
+        size_t length = strlen(name);
+        ok = write_u8(out, (uint8_t)length) && write_bytes(out, name, length);
+    }
+
+    uint32_t num_encodings = (uint32_t)vector_len(&chunk->lines.encodings);
+    LineNumberEncoding *encodings = (LineNumberEncoding *)chunk->lines.encodings.data->data;
+    ok = ok && write_u32(out, num_encodings);
+    for (uint32_t i = 0; ok && i < num_encodings; i++) {
+        ok = write_u32(out, (uint32_t)encodings[i].line)
+             && write_u32(out, (uint32_t)encodings[i].size_count);
+    }
+
+    for (uint64_t i = tracer->total - count; ok && i < tracer->total; i++) {
+        TraceRecord *record = &tracer->records[i & tracer->mask];
+        ok = write_u32(out, record->offset) && write_u8(out, record->opcode)
+             && write_u8(out, record->top_type) && write_u16(out, record->depth)
+             && write_u64(out, record->top);
+    }
+    return ok;
+}
+
+bool tracer_dump_file(Tracer *tracer, OpCodeChunk *chunk, const char *path) {
+    FILE *out = fopen(path, "wb");
+    if (out == NULL) {
+        return false;
+    }
+    bool ok = tracer_dump(tracer, chunk, out);
+    return fclose(out) == 0 && ok;
+}
+
+#pragma endregion
+
+#pragma region Private
+
+static bool write_bytes(FILE *out, const void *data, size_t size) {
+    return fwrite(data, 1, size, out) == size;
+}
+
+static bool write_u8(FILE *out, uint8_t value) {
+    return write_bytes(out, &value, 1);
+}
+
+static bool write_u16(FILE *out, uint16_t value) {
+    uint8_t bytes[2] = { value & 0xff, value >> 8 };
+    return write_bytes(out, bytes, sizeof(bytes));
+}
+
+static bool write_u32(FILE *out, uint32_t value) {
+    uint8_t bytes[4];
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = (value >> (8 * i)) & 0xff;
+    }
+    return write_bytes(out, bytes, sizeof(bytes));
+}
+
+static bool write_u64(FILE *out, uint64_t value) {
+    uint8_t bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (value >> (8 * i)) & 0xff;
+    }
+    return write_bytes(out, bytes, sizeof(bytes));
+}
+
+#pragma endregion
\ No newline at end of file
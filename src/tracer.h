@@ -0,0 +1,92 @@
+#ifndef clox_tracer_h
+#define clox_tracer_h
+
+#include <stdio.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "common.h"
+#include "instruction.h"
+#include "value.h"
+
+/**
+ * Binary execution tracer.
+ * Each executed instruction appends a fixed-size TraceRecord to an in-memory ring buffer, so only
+ * the most recent `capacity` instructions are kept and recording never allocates or does I/O.
+ * The buffer is dumped in a self-describing binary format (see tracer_dump) which is rendered
+ * offline by `lox trace`.
+ *
+ * The VM only records instructions when built with -DVM_TRACE.
+ */
+
+#define TRACE_DEFAULT_CAPACITY 4096
+#define TRACE_FORMAT_MAGIC     "LOXTRACE"
+#define TRACE_FORMAT_VERSION   1
+
+// The type of the value on top of the stack when an instruction was dispatched.
+typedef enum TraceValueType {
+    TRACE_STACK_EMPTY,
+    TRACE_NIL,
+    TRACE_BOOL,
+    TRACE_NUMBER,
+} TraceValueType;
+
+typedef struct TraceRecord {
+    uint32_t offset; // byte offset of the instruction in its chunk
+    uint8_t opcode;
+    uint8_t top_type; // a TraceValueType
+    uint16_t depth;   // stack depth, saturated at UINT16_MAX
+    uint64_t top;     // the bits of a number, 0 or 1 for a bool, otherwise 0
+} TraceRecord;
+
+typedef struct Tracer {
+    TraceRecord *records;
+    uint32_t mask;    // capacity - 1; the capacity is a power of two
+    uint64_t total;   // the number of records written since the last reset
+    Allocator *alloc;
+    const char *path; // where the trace is dumped after a failed run (or NULL)
+    bool dump_always; // also dump after runs that succeed
+} Tracer;
+
+void tracer_init(Tracer *tracer, Allocator *alloc, uint32_t capacity);
+void tracer_destroy(Tracer *tracer);
+bool tracer_dump(Tracer *tracer, OpCodeChunk *chunk, FILE *out);
+bool tracer_dump_file(Tracer *tracer, OpCodeChunk *chunk, const char *path);
+
+static inline void tracer_reset(Tracer *tracer) {
+    tracer->total = 0;
+}
+
+// Records the dispatch of `code` at `offset` with the stack spanning [base, top).
+static inline void tracer_record(Tracer *tracer, uint32_t offset, OpCode code, Value *base,
+                                 Value *top) {
+    TraceRecord *record = &tracer->records[tracer->total++ & tracer->mask];
+    ptrdiff_t depth = top - base;
+    record->offset = offset;
+    record->opcode = (uint8_t)code;
+    record->depth = depth > UINT16_MAX ? UINT16_MAX : (uint16_t)depth;
+    if (depth == 0) {
+        record->top_type = TRACE_STACK_EMPTY;
+        record->top = 0;
+        return;
+    }
+    Value value = top[-1];
+    switch (value_type(value)) {
+    case VAL_NIL:
+        record->top_type = TRACE_NIL;
+        record->top = 0;
+        break;
+    case VAL_BOOL:
+        record->top_type = TRACE_BOOL;
+        record->top = AS_BOOL(value);
+        break;
+    case VAL_NUMBER: {
+        double number = AS_NUMBER(value);
+        record->top_type = TRACE_NUMBER;
+        memcpy(&record->top, &number, sizeof(record->top));
+        break;
+    }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "assert.h"
+#include "value.h"
+
+#pragma region Public
+
+bool values_equal(Value a, Value b) {
+    if (value_type(a) != value_type(b)) {
+        return false;
+    }
+    switch (value_type(a)) {
+    case VAL_NIL:
+        return true;
+    case VAL_BOOL:
+        return AS_BOOL(a) == AS_BOOL(b);
+    case VAL_NUMBER:
+        // Compared as doubles rather than bit patterns so that NaN != NaN and 0 == -0.
+        return AS_NUMBER(a) == AS_NUMBER(b);
+    }
+    Unreachable();
+}
+
+const char *value_type_name(ValueType type) {
+    switch (type) {
+    case VAL_NIL:
+        return "nil";
+    case VAL_BOOL:
+        return "bool";
+    case VAL_NUMBER:
+        return "number";
+    }
+    Unreachable();
+}
+
+String *value_repr(Value value, String *out, Allocator *alloc) {
+    switch (value_type(value)) {
+    case VAL_NIL:
+        return string_appendf(out, alloc, "Value(nil)");
+    case VAL_BOOL:
+        return string_appendf(out, alloc, "Value(%s)", AS_BOOL(value) ? "true" : "false");
+    case VAL_NUMBER:
+        return string_appendf(out, alloc, "Value(%g)", AS_NUMBER(value));
+    }
+    Unreachable();
+}
+
+void value_write_repr(Value *value, FILE *out) {
+    switch (value_type(*value)) {
+    case VAL_NIL:
+        fputs("Value(nil)", out);
+        return;
+    case VAL_BOOL:
+        fprintf(out, "Value(%s)", AS_BOOL(*value) ? "true" : "false");
+        return;
+    case VAL_NUMBER:
+        fprintf(out, "Value(%g)", AS_NUMBER(*value));
+        return;
+    }
+    Unreachable();
+}
+
+#pragma endregion
\ No newline at end of file
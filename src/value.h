@@ -0,0 +1,104 @@
+#ifndef clox_value_h
+#define clox_value_h
+
+#include <stdio.h>
+#include <string.h>
+
+#include "allocator.h"
+#include "array.h"
+#include "common.h"
+
+typedef enum {
+    VAL_NIL,
+    VAL_BOOL,
+    VAL_NUMBER,
+} ValueType;
+
+#ifndef VALUE_TAGGED_UNION
+
+/**
+ * Values are NaN-boxed into a single 64-bit word.
+ * Any double that is not a quiet NaN is a number and is stored as-is. Every other type lives in
+ * the payload of a quiet NaN (the exponent and quiet bits set) and is identified by the low tag
+ * bits. The sign bit is left free for heap object pointers.
+ *
+ * Build with -DVALUE_TAGGED_UNION to use a plain tagged union instead, which is easier to inspect
+ * in a debugger at the cost of doubling the size of every value.
+ */
+typedef uint64_t Value;
+
+#define VALUE_QNAN      ((uint64_t)0x7ffc000000000000)
+#define VALUE_TAG_NIL   1
+#define VALUE_TAG_FALSE 2
+#define VALUE_TAG_TRUE  3
+
+#define NIL_VAL         ((Value)(VALUE_QNAN | VALUE_TAG_NIL))
+#define FALSE_VAL       ((Value)(VALUE_QNAN | VALUE_TAG_FALSE))
+#define TRUE_VAL        ((Value)(VALUE_QNAN | VALUE_TAG_TRUE))
+#define BOOL_VAL(b)     ((b) ? TRUE_VAL : FALSE_VAL)
+#define NUMBER_VAL(num) number_to_value(num)
+
+#define IS_NIL(value)    ((value) == NIL_VAL)
+#define IS_BOOL(value)   (((value) | 1) == TRUE_VAL)
+#define IS_NUMBER(value) (((value) & VALUE_QNAN) != VALUE_QNAN)
+// Combines both checks without short-circuiting so binary operators take a single branch.
+#define ARE_NUMBERS(a, b) (IS_NUMBER(a) & IS_NUMBER(b))
+
+#define AS_BOOL(value)   ((value) == TRUE_VAL)
+#define AS_NUMBER(value) value_to_number(value)
+
+static inline Value number_to_value(double num) {
+    Value value;
+    memcpy(&value, &num, sizeof(value));
+    return value;
+}
+
+static inline double value_to_number(Value value) {
+    double num;
+    memcpy(&num, &value, sizeof(num));
+    return num;
+}
+
+static inline ValueType value_type(Value value) {
+    if (IS_NUMBER(value)) {
+        return VAL_NUMBER;
+    }
+    return IS_BOOL(value) ? VAL_BOOL : VAL_NIL;
+}
+
+#else
+
+typedef struct Value {
+    ValueType type;
+    union {
+        bool boolean;
+        double number;
+    } as;
+} Value;
+
+#define NIL_VAL         ((Value){ VAL_NIL, { .number = 0 } })
+#define FALSE_VAL       ((Value){ VAL_BOOL, { .boolean = false } })
+#define TRUE_VAL        ((Value){ VAL_BOOL, { .boolean = true } })
+#define BOOL_VAL(b)     ((Value){ VAL_BOOL, { .boolean = (b) } })
+#define NUMBER_VAL(num) ((Value){ VAL_NUMBER, { .number = (num) } })
+
+#define IS_NIL(value)     ((value).type == VAL_NIL)
+#define IS_BOOL(value)    ((value).type == VAL_BOOL)
+#define IS_NUMBER(value)  ((value).type == VAL_NUMBER)
+#define ARE_NUMBERS(a, b) (IS_NUMBER(a) & IS_NUMBER(b))
+
+#define AS_BOOL(value)   ((value).as.boolean)
+#define AS_NUMBER(value) ((value).as.number)
+
+static inline ValueType value_type(Value value) {
+    return value.type;
+}
+
+#endif
+
+bool values_equal(Value a, Value b);
+const char *value_type_name(ValueType type);
+String *value_repr(Value value, String *out, Allocator *alloc);
+void value_write_repr(Value *value, FILE *out);
+
+#endif
\ No newline at end of file
@@ -39,13 +39,21 @@ void *vector_extend(Vector *vec, void *data, size_t count) {
         .length = count,
     };
     uint8_t *target = vec->data->data + (vec->count * vec->data->unit_size);
-    for (size_t i = 0; i <= source.unit_size * source.length; i++) {
+    for (size_t i = 0; i < source.unit_size * source.length; i++) {
         target[i] = source.data[i];
     }
     vec->count += count;
     return (void *)target;
 }
 
+// Grows the storage to hold at least `capacity` elements, so that many can be appended without
+// reallocating.
+void vector_reserve(Vector *vec, size_t capacity) {
+    if (capacity > vec->data->length) {
+        vec_realloc(vec, capacity);
+    }
+}
+
 #pragma endregion
 
 #pragma region Private
@@ -17,6 +17,7 @@ void vector_init(Vector *vec, Allocator *alloc, size_t capacity, size_t unit_siz
 void vector_destroy(Vector *vec);
 void *vector_append(Vector *vec, void *data);
 void *vector_extend(Vector *vec, void *data, size_t count);
+void vector_reserve(Vector *vec, size_t capacity);
 
 static inline void *vector_at(Vector *vec, int index) {
     Assert(index >= 0 && index < (int)vec->count);
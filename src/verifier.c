@@ -0,0 +1,95 @@
+#include "verifier.h"
+
+#pragma region Declare
+
+static inline bool is_known_opcode(uint8_t code);
+static inline uint32_t read_constant_index(uint8_t *code, int offset);
+static inline VerifyResult fail(Verification *verification, VerifyResult result, int offset);
+
+#pragma endregion
+
+#pragma region Public
+
+VerifyResult verify_chunk(OpCodeChunk *chunk, int stack_limit, Verification *verification) {
+    Assert(chunk != NULL);
+    Assert(verification != NULL);
+    *verification = (Verification){ .result = VERIFY_OK, .offset = -1 };
+
+    uint8_t *code = chunk->codes.codes.data->data;
+    int length = (int)vector_len(&chunk->codes.codes);
+    int num_constants = (int)vector_len(&chunk->constants.values);
+    int depth = 0;
+
+    for (int offset = 0; offset < length;) {
+        if (!is_known_opcode(code[offset])) {
+            return fail(verification, VERIFY_UNKNOWN_OPCODE, offset);
+        }
+        OpCode op = code[offset];
+        int size = opcode_size(op);
+        if (offset + size > length) {
+            return fail(verification, VERIFY_TRUNCATED_INSTRUCTION, offset);
+        }
+        if (op == OP_CONSTANT || op == OP_CONSTANT_LONG) {
+            if ((int)read_constant_index(code, offset) >= num_constants) {
+                return fail(verification, VERIFY_INVALID_CONSTANT, offset);
+            }
+        }
+
+        depth -= opcode_stack_pops(op);
+        if (depth < 0) {
+            return fail(verification, VERIFY_STACK_UNDERFLOW, offset);
+        }
+        depth += opcode_stack_pushes(op);
+        if (depth > verification->max_stack_depth) {
+            verification->max_stack_depth = depth;
+        }
+        if (depth > stack_limit) {
+            return fail(verification, VERIFY_STACK_OVERFLOW, offset);
+        }
+
+        offset += size;
+        verification->num_instructions++;
+        if (op == OP_RETURN) {
+            // Execution never continues past a return, so the remainder is unreachable.
+            verification->code_length = offset;
+            return VERIFY_OK;
+        }
+    }
+    return fail(verification, VERIFY_MISSING_RETURN, length);
+}
+
+#pragma endregion
+
+#pragma region Private
+
+// Quickened opcodes are only ever produced by the VM, so they are unknown in a chunk.
+static inline bool is_known_opcode(uint8_t code) {
+    switch (code) {
+    case OP_CONSTANT:
+    case OP_CONSTANT_LONG:
+    case OP_COLUMN:
+    case OP_ADD:
+    case OP_SUBTRACT:
+    case OP_MULTIPLY:
+    case OP_DIVIDE:
+    case OP_NEGATE:
+    case OP_RETURN:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static inline uint32_t read_constant_index(uint8_t *code, int offset) {
+    return code[offset] == OP_CONSTANT_LONG
+               ? (uint32_t)code[offset + 1] << 16 | code[offset + 2] << 8 | code[offset + 3]
+               : code[offset + 1];
+}
+
+static inline VerifyResult fail(Verification *verification, VerifyResult result, int offset) {
+    verification->result = result;
+    verification->offset = offset;
+    return result;
+}
+
+#pragma endregion
\ No newline at end of file
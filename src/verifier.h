@@ -0,0 +1,57 @@
+#ifndef clox_verifier_h
+#define clox_verifier_h
+
+#include "allocator.h"
+#include "assert.h"
+#include "common.h"
+#include "instruction.h"
+
+/**
+ * Static verification of an OpCodeChunk.
+ * The verifier walks a chunk once before it is executed, checking that every instruction is
+ * well-formed and computing the maximum depth the value stack reaches. A chunk that passes
+ * verification can be executed without any bounds checks on the stack or the code.
+ */
+
+typedef enum VerifyResult {
+    VERIFY_OK,
+    VERIFY_UNKNOWN_OPCODE,
+    VERIFY_TRUNCATED_INSTRUCTION,
+    VERIFY_INVALID_CONSTANT,
+    VERIFY_STACK_UNDERFLOW,
+    VERIFY_STACK_OVERFLOW,
+    VERIFY_MISSING_RETURN,
+} VerifyResult;
+
+typedef struct Verification {
+    VerifyResult result;
+    int offset;           // offset of the offending instruction (or -1)
+    int max_stack_depth;  // the maximum number of stack slots used by the chunk
+    int code_length;      // the number of bytes up to and including the first OP_RETURN
+    int num_instructions; // the number of instructions within code_length
+} Verification;
+
+VerifyResult verify_chunk(OpCodeChunk *chunk, int stack_limit, Verification *verification);
+
+static inline const char *verify_result_name(VerifyResult result) {
+    switch (result) {
+    case VERIFY_OK:
+        return "VERIFY_OK";
+    case VERIFY_UNKNOWN_OPCODE:
+        return "VERIFY_UNKNOWN_OPCODE";
+    case VERIFY_TRUNCATED_INSTRUCTION:
+        return "VERIFY_TRUNCATED_INSTRUCTION";
+    case VERIFY_INVALID_CONSTANT:
+        return "VERIFY_INVALID_CONSTANT";
+    case VERIFY_STACK_UNDERFLOW:
+        return "VERIFY_STACK_UNDERFLOW";
+    case VERIFY_STACK_OVERFLOW:
+        return "VERIFY_STACK_OVERFLOW";
+    case VERIFY_MISSING_RETURN:
+        return "VERIFY_MISSING_RETURN";
+    default:
+        Panicf("Unknown verify result %d", result);
+    }
+}
+
+#endif
\ No newline at end of file
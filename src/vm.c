@@ -1,129 +1,654 @@
+#include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 
+#include "chunk_cache.h"
 #include "compiler.h"
+#include "sampler.h"
+#include "verifier.h"
 #include "vm.h"
 
+// Dispatched like an opcode, but only ever patched over an instruction for the length of a run, to
+// yield there when the run's fuel runs out.
+#define YIELD_CODE ((OpCode)NUM_OPCODES)
+
 #pragma region Declare
 
 static inline void stack_reset(ValueStack *stack);
-static inline void stack_push(ValueStack *stack, Value value);
-static inline Value stack_pop(ValueStack *stack);
-// static void stack_write_repr(ValueStack *stack, FILE *out);
-static InterpretResult virtual_machine_exec(VirtualMachine *vm);
+static inline void stack_init(ValueStack *stack, Allocator *alloc, int capacity);
+static inline bool stack_reserve(ValueStack *stack, Allocator *alloc, int slots, int limit);
+static inline void stack_destroy(ValueStack *stack, Allocator *alloc);
+static InterpretResult virtual_machine_exec(VirtualMachine *vm, const void *const **table);
+static void decode(LoadedChunk *loaded, uint8_t *code, int length);
+static inline void rewrite(Instruction *instruction, const void *const *table, OpCode code);
+static InterpretResult verify_error(VirtualMachine *vm, Verification *verification);
+static InterpretResult runtime_error(VirtualMachine *vm, const char *format, ...);
+static void print_result(VirtualMachine *vm);
+static InterpretResult interpret_cached(VirtualMachine *vm, const char *source);
+static InterpretResult run_compiled(VirtualMachine *vm, OpCodeChunk *chunk,
+                                   CompileResult compiled);
+static InterpretResult run(VirtualMachine *vm);
 
 #pragma endregion
 
 #pragma region Public
 
 InterpretResult interpret(VirtualMachine *vm, const char *source) {
-    InterpretResult result = INTERPRET_OK;
-
+    if (vm->cache != NULL) {
+        return interpret_cached(vm, source);
+    }
     OpCodeChunk chunk;
     opcode_chunk_init(&chunk, vm->alloc);
-    if (compile(vm->alloc, source) != COMPILE_OK) {
-        result = INTERPRET_COMPILE_ERROR;
-        goto cleanup;
-    }
-    vm->chunk = &chunk;
-    vm->ip = vm->chunk->codes.codes.data->data;
-    opcode_chunk_write_repr(vm->chunk, stderr, "main");
-    result = virtual_machine_exec(vm);
+    InterpretResult result =
+        run_compiled(vm, &chunk, compile(vm->alloc, source, &chunk, vm->errors));
+    opcode_chunk_destroy(&chunk);
+    return result;
+}
 
-cleanup:
+// Interprets a source read from a stream while it is compiled. Such sources bypass the VM's chunk
+// cache, since keying it would mean keeping the whole source.
+InterpretResult interpret_stream(VirtualMachine *vm, SourceStream *stream) {
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, vm->alloc);
+    InterpretResult result =
+        run_compiled(vm, &chunk, compile_stream(vm->alloc, stream, &chunk, vm->errors));
     opcode_chunk_destroy(&chunk);
     return result;
 }
 
+// Loads and executes the chunk. The loaded chunk doesn't outlive the call, so a run that exhausts
+// the VM's fuel is abandoned, as it is by interpret(). Only a run started by
+// virtual_machine_exec_loaded, on a loaded chunk the caller keeps, can be resumed.
+InterpretResult virtual_machine_run(VirtualMachine *vm, OpCodeChunk *chunk) {
+    LoadedChunk loaded;
+    InterpretResult result = virtual_machine_load(vm, chunk, &loaded);
+    if (result != INTERPRET_OK) {
+        return result;
+    }
+    result = virtual_machine_exec_loaded(vm, &loaded);
+    if (result == INTERPRET_YIELD) {
+        virtual_machine_abandon(vm);
+    }
+    loaded_chunk_destroy(&loaded, vm->alloc);
+    return result;
+}
+
+// Verifies the chunk and translates it into the instruction stream executed by the VM.
+// A loaded chunk can be executed any number of times without being verified or decoded again.
+InterpretResult virtual_machine_load(VirtualMachine *vm, OpCodeChunk *chunk, LoadedChunk *loaded) {
+    Verification verification;
+    if (verify_chunk(chunk, vm->stack_limit, &verification) != VERIFY_OK) {
+        return verify_error(vm, &verification);
+    }
+
+    *loaded = (LoadedChunk){
+        .chunk = chunk,
+        .length = verification.num_instructions,
+        .max_stack_depth = verification.max_stack_depth,
+    };
+    loaded->code = (Instruction *)allocator_alloc(vm->alloc, sizeof(Instruction) * loaded->length);
+    loaded->offsets = (int *)allocator_alloc(vm->alloc, sizeof(int) * loaded->length);
+    decode(loaded, chunk->codes.codes.data->data, verification.code_length);
+    // Native code can't be traced, profiled or sampled, so those take precedence over the JIT.
+    if (vm->jit && vm->tracer == NULL && vm->profile == NULL && vm->sampler == NULL) {
+        loaded->jit_result = jit_compile(chunk, verification.code_length,
+                                         verification.max_stack_depth, &loaded->jit);
+    }
+    return INTERPRET_OK;
+}
+
+// Starts executing a loaded chunk. If the VM's fuel runs out first, INTERPRET_YIELD is returned with
+// the run suspended: the loaded chunk must then stay alive until the run is resumed or abandoned.
+InterpretResult virtual_machine_exec_loaded(VirtualMachine *vm, LoadedChunk *loaded) {
+    Assert(vm->loaded == NULL); // a suspended run must be resumed or abandoned first
+    // Native code can't be suspended, so it only runs when the budget covers the whole chunk (which
+    // is straight-line, so that is exactly its number of instructions).
+    if (loaded->jit.entry != NULL && (vm->fuel == FUEL_UNLIMITED || vm->fuel >= loaded->length)) {
+        if (vm->fuel != FUEL_UNLIMITED) {
+            vm->fuel -= loaded->length;
+        }
+        vm->result = NUMBER_VAL(loaded->jit.entry());
+        print_result(vm);
+        return INTERPRET_OK;
+    }
+    stack_reset(&vm->stack);
+    // The limit may have been lowered since the chunk was loaded, so this can still fail.
+    if (!stack_reserve(&vm->stack, vm->alloc, loaded->max_stack_depth, vm->stack_limit)) {
+        fprintf(vm->errors, "Stack overflow: chunk requires %d stack slots, limit is %d\n",
+                loaded->max_stack_depth, vm->stack_limit);
+        return INTERPRET_RUNTIME_ERROR;
+    }
+    vm->chunk = loaded->chunk;
+    vm->loaded = loaded;
+    vm->ip = loaded->code;
+#ifdef VM_TRACE
+    if (vm->tracer != NULL) {
+        tracer_reset(vm->tracer);
+    }
+#endif
+    return run(vm);
+}
+
+// Continues a run of virtual_machine_exec_loaded suspended by INTERPRET_YIELD, once the VM has been
+// given more fuel. The loaded chunk must not have been destroyed in between.
+InterpretResult virtual_machine_resume(VirtualMachine *vm) {
+    Assert(vm->loaded != NULL);
+    return run(vm);
+}
+
+// Discards a run suspended by INTERPRET_YIELD, leaving the VM ready to execute another chunk.
+void virtual_machine_abandon(VirtualMachine *vm) {
+    stack_reset(&vm->stack);
+    vm->chunk = NULL;
+    vm->loaded = NULL;
+    vm->ip = NULL;
+}
+
+// Returns the opcode an instruction of `loaded` currently executes as, which may be a quickened
+// form of the opcode it was decoded from. While a run has a yield patched over the instruction,
+// that is the opcode of the instruction it saved.
+OpCode instruction_opcode(const LoadedChunk *loaded, const Instruction *instruction) {
+    if (instruction == loaded->stop) {
+        instruction = &loaded->stopped;
+    }
+#if !defined(VM_COMPUTED_GOTO) || defined(VM_PROFILE) || defined(VM_TRACE)
+    Assert(instruction->code != YIELD_CODE);
+    return instruction->code;
+#else
+    const void *const *table;
+    virtual_machine_exec(NULL, &table);
+    for (int code = 0; code < NUM_OPCODES; code++) {
+        if (table[code] == instruction->handler) {
+            return code;
+        }
+    }
+    Unreachable();
+#endif
+}
+
+void loaded_chunk_destroy(LoadedChunk *loaded, Allocator *alloc) {
+    jit_release(&loaded->jit);
+    allocator_free(alloc, loaded->code);
+    allocator_free(alloc, loaded->offsets);
+    *loaded = (LoadedChunk){ 0 };
+}
+
 void virtual_machine_init(VirtualMachine *vm, Allocator *alloc) {
     vm->alloc = alloc;
-    stack_reset(&vm->stack);
+    vm->chunk = NULL;
+    vm->loaded = NULL;
+    vm->ip = NULL;
+    vm->disassembly = NULL;
+    vm->stack_limit = DEFAULT_STACK_LIMIT;
+    vm->profile = NULL;
+    vm->sampler = NULL;
+    vm->tracer = NULL;
+    vm->jit = false;
+    vm->result = NIL_VAL;
+    vm->output = stderr;
+    vm->errors = stderr;
+    vm->inputs = NULL;
+    vm->num_inputs = 0;
+    vm->cache = NULL;
+    vm->fuel = FUEL_UNLIMITED;
+    stack_init(&vm->stack, alloc, STACK_INITIAL_CAPACITY);
 }
 
-static inline void stack_reset(ValueStack *stack) {
-    stack->top = stack->values;
+void virtual_machine_destroy(VirtualMachine *vm) {
+    stack_destroy(&vm->stack, vm->alloc);
 }
 
 #pragma endregion
 
 #pragma region Private
 
-static inline void stack_push(ValueStack *stack, Value value) {
-    *stack->top = value;
-    stack->top++;
+// Runs the dispatch loop from vm->ip until the chunk returns, fails or runs out of fuel. A run that
+// runs out of fuel stays attached to the VM so it can be resumed.
+static InterpretResult run(VirtualMachine *vm) {
+#ifdef VM_PROFILE
+    if (vm->profile != NULL) {
+        profile_begin(vm->profile);
+    }
+#endif
+    InterpretResult result = virtual_machine_exec(vm, NULL);
+#ifdef VM_PROFILE
+    if (vm->profile != NULL) {
+        profile_end(vm->profile);
+    }
+#endif
+#ifdef VM_SAMPLING
+    if (vm->sampler != NULL) {
+        sampler_collect(vm->sampler, vm->loaded);
+    }
+#endif
+    if (result == INTERPRET_YIELD) {
+        return result;
+    }
+#ifdef VM_TRACE
+    if (vm->tracer != NULL && vm->tracer->path != NULL
+        && (result != INTERPRET_OK || vm->tracer->dump_always)) {
+        if (!tracer_dump_file(vm->tracer, vm->chunk, vm->tracer->path)) {
+            perror("failed to write execution trace");
+        }
+    }
+#endif
+    virtual_machine_abandon(vm);
+    return result;
 }
 
-static inline Value stack_pop(ValueStack *stack) {
-    stack->top--;
-    Assert(stack->top >= stack->values);
-    return *stack->top;
+static inline void stack_init(ValueStack *stack, Allocator *alloc, int capacity) {
+    Assert(capacity > 0);
+    stack->values = (Value *)allocator_alloc(alloc, sizeof(Value) * capacity);
+    stack->capacity = capacity;
+    stack_reset(stack);
 }
 
-// static void stack_write_repr(ValueStack *stack, FILE *out) {
-//     fputs("          [", out);
-//     for (Value *slot = stack->values; slot < stack->top; slot++) {
-//         value_write_repr(slot, out);
-//         fputc(' ', out);
-//     }
-//     fputs("]\n", out);
-// }
+// Ensures at least `slots` free slots above the top of the stack, growing it geometrically and
+// relocating the top pointer. Returns false if that would exceed `limit` slots in total.
+static inline bool stack_reserve(ValueStack *stack, Allocator *alloc, int slots, int limit) {
+    int depth = stack->top - stack->values;
+    if (slots > limit - depth) {
+        return false;
+    }
+    if (depth + slots <= stack->capacity) {
+        return true;
+    }
+    int capacity = stack->capacity;
+    while (capacity < depth + slots) {
+        capacity = capacity > limit / 2 ? limit : capacity * 2;
+    }
+    stack->values = (Value *)allocator_realloc(alloc, stack->values, sizeof(Value) * depth,
+                                               sizeof(Value) * capacity);
+    stack->top = stack->values + depth;
+    stack->capacity = capacity;
+    return true;
+}
+
+static inline void stack_destroy(ValueStack *stack, Allocator *alloc) {
+    allocator_free(alloc, stack->values);
+    *stack = (ValueStack){ 0 };
+}
+
+static inline void stack_reset(ValueStack *stack) {
+    stack->top = stack->values;
+}
+
+// Executes the loaded chunk at vm->ip. When `table` is non-NULL nothing is executed; the dispatch
+// table is published through it instead, since label addresses are only visible in this function.
+static InterpretResult virtual_machine_exec(VirtualMachine *vm, const void *const **table) {
+// The instruction and stack pointers live in locals so they can stay in registers; they are
+// written back to the VM whenever something outside this function may observe them. The verifier
+// guarantees the stack never under- or overflows, so PUSH and POP are unchecked.
+#define OPERAND()   (ip[-1].operand)
+#define OFFSET()    (vm->loaded->offsets[ip - vm->loaded->code])
+#define PUSH(value) (*sp++ = (value))
+#define POP()       (*--sp)
+#define SYNC()                                                                                     \
+    do {                                                                                           \
+        vm->ip = ip;                                                                               \
+        vm->stack.top = sp;                                                                        \
+        if (vm->fuel != FUEL_UNLIMITED) {                                                          \
+            vm->fuel -= ip - start;                                                                \
+        }                                                                                          \
+        if (vm->loaded->stop != NULL) {                                                            \
+            *vm->loaded->stop = vm->loaded->stopped;                                               \
+            vm->loaded->stop = NULL;                                                               \
+        }                                                                                          \
+    } while (false)
+
+// Quickening: a generic instruction that sees operands of the types a specialised form handles
+// rewrites itself into that form, in place in the instruction stream, so later executions skip the
+// generic type dispatch. The specialised form guards its assumption; if it ever fails, the
+// instruction is rewritten back and re-dispatched so the generic form handles (or reports) the
+// operands. A deoptimised instruction is seen twice by the profiler and tracer but charged once.
+#define QUICKEN(code) rewrite(ip - 1, dispatch_table, code)
+#define DEOPTIMIZE(code)                                                                           \
+    do {                                                                                           \
+        generic_code = (code);                                                                     \
+        goto deoptimize;                                                                           \
+    } while (false)
+
+#define BINARY_OP(op, quickened)                                                                   \
+    do {                                                                                           \
+        Value right = POP();                                                                       \
+        Value left = sp[-1];                                                                       \
+        if (!ARE_NUMBERS(left, right)) {                                                           \
+            SYNC();                                                                                \
+            return runtime_error(vm, "Operands must be numbers.");                                 \
+        }                                                                                          \
+        QUICKEN(quickened);                                                                        \
+        sp[-1] = NUMBER_VAL(AS_NUMBER(left) op AS_NUMBER(right));                                  \
+    } while (false)
+#define NUMBER_OP(op, generic)                                                                     \
+    do {                                                                                           \
+        Value right = sp[-1];                                                                      \
+        Value left = sp[-2];                                                                       \
+        if (!ARE_NUMBERS(left, right)) {                                                           \
+            DEOPTIMIZE(generic);                                                                   \
+        }                                                                                          \
+        sp--;                                                                                      \
+        sp[-1] = NUMBER_VAL(AS_NUMBER(left) op AS_NUMBER(right));                                  \
+    } while (false)
+
+#ifdef VM_TRACE
+#define TRACE_INSTRUCTION()                                                                        \
+    do {                                                                                           \
+        if (tracer != NULL && ip->code != YIELD_CODE) {                                            \
+            tracer_record(tracer, OFFSET(), ip->code, vm->stack.values, sp);                       \
+        }                                                                                          \
+    } while (false)
+#else
+#define TRACE_INSTRUCTION() ((void)0)
+#endif
+
+// The sampler's signal handler reads vm->ip at arbitrary points, so it is kept current.
+#ifdef VM_SAMPLING
+#define PUBLISH_IP() (*(Instruction *volatile *)&vm->ip = ip)
+#else
+#define PUBLISH_IP() ((void)0)
+#endif
 
-static InterpretResult virtual_machine_exec(VirtualMachine *vm) {
-#define READ_BYTE()          (*vm->ip++)
-#define READ_CONSTANT(index) (((Value *)vm->chunk->constants.values.data)[(index)])
-#define OFFSET()             ((int)(vm->ip - vm->chunk->codes.codes.data->data))
-#define BINARY_OP(op)                                                                              \
+#ifdef VM_PROFILE
+#define PROFILE_INSTRUCTION()                                                                      \
     do {                                                                                           \
-        Value right = stack_pop(&vm->stack);                                                       \
-        Value left = stack_pop(&vm->stack);                                                        \
-        stack_push(&vm->stack, left op right);                                                     \
+        if (profile != NULL && ip->code != YIELD_CODE) {                                           \
+            profile_record(profile, ip->code);                                                     \
+        }                                                                                          \
     } while (false)
+#else
+#define PROFILE_INSTRUCTION() ((void)0)
+#endif
 
-    for (;;) {
-#ifdef DEBUG_TRACE_EXECUTION
-        stack_write_repr(&vm->stack, stderr);
-        opcode_chunk_instruction_write_repr(vm->chunk, stderr, OFFSET());
-        fputc('\n', stderr);
-#endif
-        uint8_t code;
-        switch (code = READ_BYTE()) {
-        default:
-            Panicf("Unknown opcode %d", code);
-        case OP_CONSTANT:
-        case OP_CONSTANT_LONG: {
-            uint32_t index = code == OP_CONSTANT_LONG
-                                 ? READ_BYTE() << 16 | READ_BYTE() << 8 | READ_BYTE()
-                                 : READ_BYTE();
-            Value constant = READ_CONSTANT(index);
-            stack_push(&vm->stack, constant);
-            break;
+#ifdef VM_COMPUTED_GOTO
+    // Direct-threaded dispatch: every handler jumps straight to the next one through the address
+    // stored in the instruction stream, giving each instruction its own indirect branch.
+    static const void *const dispatch_table[] = {
+        [OP_CONSTANT] = &&DO_OP_CONSTANT, [OP_CONSTANT_LONG] = &&DO_OP_CONSTANT,
+        [OP_COLUMN] = &&DO_OP_COLUMN,     [OP_ADD] = &&DO_OP_ADD,
+        [OP_SUBTRACT] = &&DO_OP_SUBTRACT, [OP_MULTIPLY] = &&DO_OP_MULTIPLY,
+        [OP_DIVIDE] = &&DO_OP_DIVIDE,     [OP_NEGATE] = &&DO_OP_NEGATE,
+        [OP_RETURN] = &&DO_OP_RETURN,     [OP_ADD_NUM] = &&DO_OP_ADD_NUM,
+        [OP_SUBTRACT_NUM] = &&DO_OP_SUBTRACT_NUM, [OP_MULTIPLY_NUM] = &&DO_OP_MULTIPLY_NUM,
+        [OP_DIVIDE_NUM] = &&DO_OP_DIVIDE_NUM,     [OP_NEGATE_NUM] = &&DO_OP_NEGATE_NUM,
+        [YIELD_CODE] = &&DO_YIELD_CODE,
+    };
+#else
+    static const void *const *const dispatch_table = NULL;
+#endif
+    if (table != NULL) {
+        *table = dispatch_table;
+        return INTERPRET_OK;
+    }
+    Instruction *ip = vm->ip;
+    Value *sp = vm->stack.top;
+    // Every instruction costs one unit of fuel. Chunks are straight-line, so a budget that covers
+    // the rest of the chunk can't run out, and is charged only once, for the instructions executed,
+    // by SYNC() on the way out. Otherwise a yield is patched over the instruction the budget runs
+    // out at, like a breakpoint, and SYNC() takes it out again. Either way, dispatch doesn't count.
+    Instruction *start = ip;
+    if (vm->fuel != FUEL_UNLIMITED && vm->fuel < vm->loaded->code + vm->loaded->length - ip) {
+        // Kept in the loaded chunk, so that instruction_opcode can see through the patch.
+        vm->loaded->stop = ip + vm->fuel;
+        vm->loaded->stopped = *vm->loaded->stop;
+        rewrite(vm->loaded->stop, dispatch_table, YIELD_CODE);
+    }
+    OpCode generic_code; // the form a failed guard rewrites the current instruction back to
+#ifdef VM_PROFILE
+    Profile *profile = vm->profile;
+#endif
+#ifdef VM_TRACE
+    Tracer *tracer = vm->tracer;
+#endif
+
+#ifdef VM_COMPUTED_GOTO
+#define DISPATCH()                                                                                 \
+    do {                                                                                           \
+        TRACE_INSTRUCTION();                                                                       \
+        PROFILE_INSTRUCTION();                                                                     \
+        PUBLISH_IP();                                                                              \
+        goto *(ip++)->handler;                                                                     \
+    } while (false)
+#define CASE(code) DO_##code:
+
+    DISPATCH();
+#else
+#define DISPATCH() goto dispatch
+#define CASE(code) case code:
+
+dispatch:
+    TRACE_INSTRUCTION();
+    PROFILE_INSTRUCTION();
+    PUBLISH_IP();
+    switch ((int)(ip++)->code) { // an int, since YIELD_CODE isn't one of the enum's opcodes
+    default:
+        Unreachable();
+#endif
+    CASE(OP_CONSTANT) {
+        PUSH(OPERAND());
+        DISPATCH();
+    }
+    CASE(OP_COLUMN) {
+        int column = (int)AS_NUMBER(OPERAND());
+        if (column >= vm->num_inputs) {
+            SYNC();
+            return runtime_error(vm, "Undefined input column %d.", column);
         }
-        case OP_ADD:
-            BINARY_OP(+);
-            break;
-        case OP_SUBTRACT:
-            BINARY_OP(-);
-            break;
-        case OP_MULTIPLY:
-            BINARY_OP(*);
-            break;
-        case OP_DIVIDE:
-            BINARY_OP(/);
-            break;
-        case OP_NEGATE:
-            stack_push(&vm->stack, -stack_pop(&vm->stack));
-            break;
-        case OP_RETURN: {
-            Value value = stack_pop(&vm->stack);
-            value_write_repr(&value, stderr);
-            fputc('\n', stderr);
-            return INTERPRET_OK;
+        PUSH(NUMBER_VAL(vm->inputs[column]));
+        DISPATCH();
+    }
+    CASE(OP_ADD) {
+        BINARY_OP(+, OP_ADD_NUM);
+        DISPATCH();
+    }
+    CASE(OP_SUBTRACT) {
+        BINARY_OP(-, OP_SUBTRACT_NUM);
+        DISPATCH();
+    }
+    CASE(OP_MULTIPLY) {
+        BINARY_OP(*, OP_MULTIPLY_NUM);
+        DISPATCH();
+    }
+    CASE(OP_DIVIDE) {
+        BINARY_OP(/, OP_DIVIDE_NUM);
+        DISPATCH();
+    }
+    CASE(OP_NEGATE) {
+        if (!IS_NUMBER(sp[-1])) {
+            SYNC();
+            return runtime_error(vm, "Operand must be a number.");
         }
+        QUICKEN(OP_NEGATE_NUM);
+        sp[-1] = NUMBER_VAL(-AS_NUMBER(sp[-1]));
+        DISPATCH();
+    }
+    CASE(OP_ADD_NUM) {
+        NUMBER_OP(+, OP_ADD);
+        DISPATCH();
+    }
+    CASE(OP_SUBTRACT_NUM) {
+        NUMBER_OP(-, OP_SUBTRACT);
+        DISPATCH();
+    }
+    CASE(OP_MULTIPLY_NUM) {
+        NUMBER_OP(*, OP_MULTIPLY);
+        DISPATCH();
+    }
+    CASE(OP_DIVIDE_NUM) {
+        NUMBER_OP(/, OP_DIVIDE);
+        DISPATCH();
+    }
+    CASE(OP_NEGATE_NUM) {
+        if (!IS_NUMBER(sp[-1])) {
+            DEOPTIMIZE(OP_NEGATE);
         }
+        sp[-1] = NUMBER_VAL(-AS_NUMBER(sp[-1]));
+        DISPATCH();
+    }
+    CASE(OP_RETURN) {
+        vm->result = POP();
+        SYNC();
+        print_result(vm);
+        return INTERPRET_OK;
+    }
+    CASE(YIELD_CODE) {
+        ip--; // resume at the instruction the yield was patched over
+        SYNC();
+        return INTERPRET_YIELD;
+    }
+#ifndef VM_COMPUTED_GOTO
     }
+#endif
+
+// A failed guard lands here; keeping this out of line leaves each guard a single branch.
+deoptimize:
+    rewrite(ip - 1, dispatch_table, generic_code);
+    ip--;
+    DISPATCH();
 
-#undef READ_BYTE
-#undef READ_CONSTANT
+#undef OPERAND
 #undef OFFSET
+#undef PUSH
+#undef POP
+#undef SYNC
+#undef QUICKEN
+#undef DEOPTIMIZE
+#undef BINARY_OP
+#undef NUMBER_OP
+#undef TRACE_INSTRUCTION
+#undef PROFILE_INSTRUCTION
+#undef PUBLISH_IP
+#undef DISPATCH
+#undef CASE
+}
+
+// Translates verified bytecode into the instruction stream. Constant operands are resolved to
+// their values, OP_CONSTANT_LONG is folded into OP_CONSTANT and column indices become numbers.
+static void decode(LoadedChunk *loaded, uint8_t *code, int length) {
+    const void *const *table;
+    virtual_machine_exec(NULL, &table);
+    Value *constants = (Value *)loaded->chunk->constants.values.data->data;
+
+    Instruction *instruction = loaded->code;
+    for (int offset = 0; offset < length; instruction++) {
+        OpCode op = code[offset];
+        Value operand = NIL_VAL;
+        if (op == OP_CONSTANT) {
+            operand = constants[code[offset + 1]];
+        } else if (op == OP_CONSTANT_LONG) {
+            operand = constants[code[offset + 1] << 16 | code[offset + 2] << 8 | code[offset + 3]];
+            op = OP_CONSTANT;
+        } else if (op == OP_COLUMN) {
+            operand = NUMBER_VAL(code[offset + 1]);
+        }
+        rewrite(instruction, table, op);
+        instruction->operand = operand;
+        loaded->offsets[instruction - loaded->code] = offset;
+        offset += opcode_size(code[offset]);
+    }
+    Assert(instruction - loaded->code == loaded->length);
+}
+
+// Sets the opcode an instruction executes as. `table` is the dispatch table (NULL with switch
+// dispatch, where the opcode itself is dispatched on).
+static inline void rewrite(Instruction *instruction, const void *const *table, OpCode code) {
+#ifdef VM_COMPUTED_GOTO
+    instruction->handler = table[code];
+#else
+    (void)table;
+#endif
+#if !defined(VM_COMPUTED_GOTO) || defined(VM_PROFILE) || defined(VM_TRACE)
+    instruction->code = code;
+#endif
+}
+
+static InterpretResult verify_error(VirtualMachine *vm, Verification *verification) {
+    if (verification->result == VERIFY_STACK_OVERFLOW) {
+        fprintf(vm->errors, "Stack overflow: chunk requires more than %d stack slots\n",
+                vm->stack_limit);
+        return INTERPRET_RUNTIME_ERROR;
+    }
+    fprintf(vm->errors, "Invalid chunk: %s at offset %d\n",
+            verify_result_name(verification->result), verification->offset);
+    return INTERPRET_COMPILE_ERROR;
+}
+
+// Reports an error raised by the instruction preceding vm->ip, which must have been synced.
+static InterpretResult runtime_error(VirtualMachine *vm, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(vm->errors, format, args);
+    va_end(args);
+    fputc('\n', vm->errors);
+
+    int offset = vm->loaded->offsets[vm->ip - vm->loaded->code - 1];
+    fprintf(vm->errors, "[line %d] in script\n", opcode_chunk_line_at(vm->chunk, offset));
+    stack_reset(&vm->stack);
+    return INTERPRET_RUNTIME_ERROR;
+}
+
+static void print_result(VirtualMachine *vm) {
+    if (vm->output != NULL) {
+        value_write_repr(&vm->result, vm->output);
+        fputc('\n', vm->output);
+    }
+}
+
+static InterpretResult run_compiled(VirtualMachine *vm, OpCodeChunk *chunk,
+                                   CompileResult compiled) {
+    if (compiled != COMPILE_OK) {
+        return INTERPRET_COMPILE_ERROR;
+    }
+    if (vm->disassembly != NULL) {
+        opcode_chunk_write_repr(chunk, vm->disassembly, "main");
+    }
+    return virtual_machine_run(vm, chunk);
+}
+
+// Runs the cached chunk for this source, compiling, loading and caching it on a miss. A chunk that
+// is too large to cache is run once and discarded. Chunks are disassembled only when compiled.
+static InterpretResult interpret_cached(VirtualMachine *vm, const char *source) {
+    InterpretResult result;
+    size_t length = strlen(source);
+    ChunkCacheEntry *entry = chunk_cache_get(vm->cache, source, length);
+    if (entry != NULL) {
+        result = virtual_machine_exec_loaded(vm, &entry->loaded);
+        goto done;
+    }
+
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, vm->alloc);
+    if (compile(vm->alloc, source, &chunk, vm->errors) != COMPILE_OK) {
+        opcode_chunk_destroy(&chunk);
+        return INTERPRET_COMPILE_ERROR;
+    }
+    if (vm->disassembly != NULL) {
+        opcode_chunk_write_repr(&chunk, vm->disassembly, "main");
+    }
+    LoadedChunk loaded;
+    result = virtual_machine_load(vm, &chunk, &loaded);
+    if (result != INTERPRET_OK) {
+        opcode_chunk_destroy(&chunk);
+        return result;
+    }
+    entry = chunk_cache_put(vm->cache, source, length, &chunk, &loaded);
+    if (entry != NULL) {
+        result = virtual_machine_exec_loaded(vm, &entry->loaded);
+        goto done;
+    }
+    result = virtual_machine_exec_loaded(vm, &loaded);
+    if (result == INTERPRET_YIELD) {
+        virtual_machine_abandon(vm);
+    }
+    loaded_chunk_destroy(&loaded, vm->alloc);
+    opcode_chunk_destroy(&chunk);
+    return result;
+
+done:
+    // The entry may be evicted by the next call, so an exhausted run can't stay suspended.
+    if (result == INTERPRET_YIELD) {
+        virtual_machine_abandon(vm);
+    }
+    return result;
 }
 
 #pragma endregion
\ No newline at end of file
@@ -5,38 +5,113 @@
 #include "assert.h"
 #include "common.h"
 #include "instruction.h"
+#include "jit.h"
+#include "profile.h"
+#include "source_stream.h"
+#include "tracer.h"
 
-#define STACK_MAX 256
+#define STACK_INITIAL_CAPACITY 16
+#define DEFAULT_STACK_LIMIT    (1 << 16)
+#define MAX_STACK_LIMIT        (1 << 24) // bounded by the allocator's largest block
+#define FUEL_UNLIMITED         (-1)
 
+// Labels-as-values (GCC/Clang) allow a direct-threaded dispatch loop. Define VM_SWITCH_DISPATCH
+// to build the portable switch-based loop instead.
+#if defined(__GNUC__) && !defined(VM_SWITCH_DISPATCH)
+#define VM_COMPUTED_GOTO
+#endif
+
+// The value stack starts small and grows geometrically up to the VM's stack limit. Room for the
+// verifier-computed depth of a chunk is reserved once when the chunk is entered, so the push and pop
+// hot paths never check bounds.
 typedef struct ValueStack {
-    Value values[STACK_MAX];
+    Value *values;
     Value *top;
+    int capacity;
 } ValueStack;
 
+/**
+ * A verified chunk translated into a word-aligned instruction stream.
+ * Each instruction carries its handler (a label address when dispatch is direct-threaded) and its
+ * operand already resolved, so the dispatch loop does no byte-level decoding. Executing an
+ * instruction may rewrite it into a quickened form (see OP_ADD_NUM), so a loaded chunk must not be
+ * run by two VMs at the same time.
+ */
+typedef struct Instruction {
+#ifdef VM_COMPUTED_GOTO
+    const void *handler;
+#endif
+#if !defined(VM_COMPUTED_GOTO) || defined(VM_PROFILE) || defined(VM_TRACE)
+    OpCode code;
+#endif
+    Value operand;
+} Instruction;
+
+typedef struct LoadedChunk {
+    OpCodeChunk *chunk;
+    Instruction *code;
+    int *offsets; // byte offset in the source chunk of each instruction (for diagnostics)
+    int length;
+    int max_stack_depth;
+    JitCode jit;          // native code for the chunk, if it was compiled
+    JitResult jit_result; // why the chunk was not compiled (JIT_OK if it was or JIT is off)
+    Instruction *stop;    // where a yield is patched in for the length of a run, or NULL
+    Instruction stopped;  // the instruction the yield is patched over
+} LoadedChunk;
+
+struct Sampler;
+struct ChunkCache;
+
 typedef struct VirtualMachine {
     OpCodeChunk *chunk;
-    uint8_t *ip;
+    LoadedChunk *loaded;
+    Instruction *ip;
     ValueStack stack;
     Allocator *alloc;
+    FILE *disassembly;       // when set, each chunk is disassembled to this stream before it runs
+    int stack_limit;         // maximum number of stack slots before a stack overflow is reported
+    Profile *profile;        // when set in a VM_PROFILE build, execution is recorded here
+    struct Sampler *sampler; // when set in a VM_SAMPLING build, samples are attributed to lines
+    Tracer *tracer;          // when set in a VM_TRACE build, each instruction is recorded here
+    bool jit;                // compile chunks to native code when possible
+    Value result;            // the value returned by the last successful run
+    FILE *output;            // where the returned value is printed (NULL to not print it)
+    FILE *errors;            // where compile and runtime errors are reported
+    const double *inputs;    // the current row's input columns, read by OP_COLUMN
+    int num_inputs;
+    struct ChunkCache *cache; // when set, interpret() reuses chunks compiled from the same source
+    int64_t fuel; // instructions left before the VM yields, or FUEL_UNLIMITED
 } VirtualMachine;
 
 typedef enum InterpretResult {
     INTERPRET_OK,
     INTERPRET_COMPILE_ERROR,
     INTERPRET_RUNTIME_ERROR,
+    INTERPRET_YIELD, // the instruction budget ran out; refuel and resume, or abandon the run
 } InterpretResult;
 
 void virtual_machine_init(VirtualMachine *vm, Allocator *alloc);
+void virtual_machine_destroy(VirtualMachine *vm);
 InterpretResult interpret(VirtualMachine *vm, const char *source);
+InterpretResult interpret_stream(VirtualMachine *vm, SourceStream *stream);
+InterpretResult virtual_machine_run(VirtualMachine *vm, OpCodeChunk *chunk);
+InterpretResult virtual_machine_load(VirtualMachine *vm, OpCodeChunk *chunk, LoadedChunk *loaded);
+InterpretResult virtual_machine_exec_loaded(VirtualMachine *vm, LoadedChunk *loaded);
+InterpretResult virtual_machine_resume(VirtualMachine *vm);
+void virtual_machine_abandon(VirtualMachine *vm);
+void loaded_chunk_destroy(LoadedChunk *loaded, Allocator *alloc);
+OpCode instruction_opcode(const LoadedChunk *loaded, const Instruction *instruction);
 
 static inline const char *InterpretResult_name(InterpretResult result) {
     switch (result) {
     case INTERPRET_OK:
-        return "OP_CONSTANT";
+        return "INTERPRET_OK";
     case INTERPRET_COMPILE_ERROR:
-        return "OP_CONSTANT_LONG";
+        return "INTERPRET_COMPILE_ERROR";
     case INTERPRET_RUNTIME_ERROR:
-        return "OP_RETURN";
+        return "INTERPRET_RUNTIME_ERROR";
+    case INTERPRET_YIELD:
+        return "INTERPRET_YIELD";
     default:
         Panicf("Unknown result %d", result);
     }
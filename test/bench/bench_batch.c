@@ -0,0 +1,113 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "batch.h"
+#include "instruction.h"
+#include "logging.h"
+#include "vm.h"
+
+// Evaluates one expression over many rows of input columns, once per row through the interpreter
+// and once with columnar batch evaluation. Build with OPTIMIZE="-O2 -mavx" for 4-wide kernels.
+
+#define NUM_ROWS    (1 << 20)
+#define NUM_COLUMNS 3
+#define NUM_RUNS    10
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Computes `-(c0 * 1.5 + c1) / (c2 - 0.25) + c0`.
+static int write_expression(OpCodeChunk *chunk) {
+    OpCodeChunk_write_column(chunk, 0, 1);
+    OpCodeChunk_write_constant(chunk, NUMBER_VAL(1.5), 1);
+    OpCodeChunk_write_code(chunk, OP_MULTIPLY, 1);
+    OpCodeChunk_write_column(chunk, 1, 1);
+    OpCodeChunk_write_code(chunk, OP_ADD, 1);
+    OpCodeChunk_write_code(chunk, OP_NEGATE, 1);
+    OpCodeChunk_write_column(chunk, 2, 1);
+    OpCodeChunk_write_constant(chunk, NUMBER_VAL(0.25), 1);
+    OpCodeChunk_write_code(chunk, OP_SUBTRACT, 1);
+    OpCodeChunk_write_code(chunk, OP_DIVIDE, 1);
+    OpCodeChunk_write_column(chunk, 0, 1);
+    OpCodeChunk_write_code(chunk, OP_ADD, 1);
+    OpCodeChunk_write_code(chunk, OP_RETURN, 1);
+    return 13;
+}
+
+static void report(const char *mode, double seconds, int instructions) {
+    double rows = (double)NUM_ROWS * NUM_RUNS;
+    printf("bench_batch (%s): %d rows x %d runs in %.3fs, %.2f ns/row, %.2f ns/instruction\n", mode,
+           NUM_ROWS, NUM_RUNS, seconds, seconds * 1e9 / rows, seconds * 1e9 / rows / instructions);
+}
+
+int main(void) {
+    Logger logger;
+    Allocator alloc;
+    logger_init(&logger, "bench", stderr, LOG_LEVEL_ERROR);
+    allocator_init(&alloc, &logger);
+
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &alloc);
+    int instructions = write_expression(&chunk);
+
+    static double data[NUM_COLUMNS][NUM_ROWS];
+    static double rows[NUM_ROWS][NUM_COLUMNS];
+    static double out[NUM_ROWS];
+    const double *columns[NUM_COLUMNS];
+    for (int column = 0; column < NUM_COLUMNS; column++) {
+        for (int row = 0; row < NUM_ROWS; row++) {
+            data[column][row] = (double)((row * 7 + column * 13) % 1000) / 8.0;
+            rows[row][column] = data[column][row];
+        }
+        columns[column] = data[column];
+    }
+
+    VirtualMachine vm;
+    LoadedChunk loaded;
+    virtual_machine_init(&vm, &alloc);
+    vm.output = NULL;
+    vm.num_inputs = NUM_COLUMNS;
+    InterpretResult result = virtual_machine_load(&vm, &chunk, &loaded);
+    Assert(result == INTERPRET_OK);
+    struct timespec start, end;
+    double checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int run = 0; run < NUM_RUNS; run++) {
+        for (int row = 0; row < NUM_ROWS; row++) {
+            vm.inputs = rows[row];
+            result = virtual_machine_exec_loaded(&vm, &loaded);
+            Assert(result == INTERPRET_OK);
+            checksum += AS_NUMBER(vm.result);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    report("per-row", elapsed_seconds(&start, &end), instructions);
+    loaded_chunk_destroy(&loaded, &alloc);
+    virtual_machine_destroy(&vm);
+
+    Batch batch;
+    BatchResult batch_result = batch_init(&batch, &chunk, &alloc);
+    Assert(batch_result == BATCH_OK);
+    double batch_checksum = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int run = 0; run < NUM_RUNS; run++) {
+        batch_result = batch_run(&batch, columns, NUM_COLUMNS, NUM_ROWS, out);
+        Assert(batch_result == BATCH_OK);
+        for (int row = 0; row < NUM_ROWS; row++) {
+            batch_checksum += out[row];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    report("batch", elapsed_seconds(&start, &end), instructions);
+    Assert(checksum == batch_checksum);
+    batch_destroy(&batch);
+
+    opcode_chunk_destroy(&chunk);
+    allocator_destroy(&alloc);
+    logger_destroy(&logger);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
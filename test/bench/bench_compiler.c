@@ -0,0 +1,121 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "compiler.h"
+#include "instruction.h"
+#include "logging.h"
+#include "token_buffer.h"
+
+// Measures compile throughput (scanning, parsing and emitting bytecode) on generated scripts of
+// growing size. Compilation is single-pass, so the time per byte should stay flat as the size
+// grows.
+// Then compares compiling the largest script with tokenizing it on 1 to MAX_THREADS threads, the
+// only part of compiling that splits across threads.
+
+#define MIN_SIZE (256 * 1024)
+#define MAX_SIZE (4 * 1024 * 1024)
+#define NUM_RUNS 5
+#define MAX_THREADS 8
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Writes one long expression of about `size` bytes, mixing literals, operators, groupings, unary
+// minus, line breaks and comments.
+static char *write_source(Allocator *alloc, size_t size) {
+    static const char *const terms[] = {
+        "(12.5 * 3 - 7) / 2", "-4", "1024", "(3.25 + -(8 / 16))", "0.5 * 0.25",
+    };
+    static const char operators[] = { '+', '-', '*', '/' };
+    char *source = (char *)allocator_alloc(alloc, size + 64);
+    size_t length = 0;
+    for (int i = 0; length < size; i++) {
+        length += (size_t)sprintf(source + length, "%s%s", i == 0 ? "" : " ",
+                                  terms[i % (sizeof(terms) / sizeof(terms[0]))]);
+        if (i % 16 == 15) {
+            length += (size_t)sprintf(source + length, i % 64 == 63 ? " // comment\n" : "\n");
+        }
+        length += (size_t)sprintf(source + length, " %c", operators[i % 4]);
+    }
+    length += (size_t)sprintf(source + length, " 1;");
+    return source;
+}
+
+// The best of NUM_RUNS compiles of the source when `num_threads` is 0, and otherwise of
+// tokenizing it on `num_threads` threads.
+static double time_phase(Allocator *alloc, const char *source, int num_threads) {
+    double best = 0;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, alloc);
+        TokenBuffer tokens;
+        token_buffer_init(&tokens, alloc);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (num_threads == 0) {
+            CompileResult result = compile(alloc, source, &chunk, stderr);
+            Assert(result == COMPILE_OK);
+        } else {
+            token_buffer_tokenize_parallel(&tokens, source, num_threads);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsed_seconds(&start, &end);
+        if (run == 0 || seconds < best) {
+            best = seconds;
+        }
+        token_buffer_destroy(&tokens);
+        opcode_chunk_destroy(&chunk);
+    }
+    return best;
+}
+
+int main(void) {
+    Logger logger;
+    Allocator alloc;
+    logger_init(&logger, "bench", stderr, LOG_LEVEL_ERROR);
+    allocator_init(&alloc, &logger);
+
+    for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 2) {
+        char *source = write_source(&alloc, size);
+        size_t length = strlen(source);
+        double best = 0;
+        size_t code_bytes = 0;
+        for (int run = 0; run < NUM_RUNS; run++) {
+            OpCodeChunk chunk;
+            opcode_chunk_init(&chunk, &alloc);
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            CompileResult result = compile(&alloc, source, &chunk, stderr);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            Assert(result == COMPILE_OK);
+            double seconds = elapsed_seconds(&start, &end);
+            if (run == 0 || seconds < best) {
+                best = seconds;
+            }
+            code_bytes = vector_len(&chunk.codes.codes);
+            opcode_chunk_destroy(&chunk);
+        }
+        printf("bench_compiler (%zu KB): %.2fms, %.2f ns/byte, %.0f MB/s, %zu bytes of bytecode\n",
+               length / 1024, best * 1e3, best * 1e9 / length, length / best / (1024 * 1024),
+               code_bytes);
+        allocator_free(&alloc, source);
+    }
+
+    char *source = write_source(&alloc, MAX_SIZE);
+    double compiling = time_phase(&alloc, source, 0);
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        double tokenizing = time_phase(&alloc, source, threads);
+        printf("bench_compiler (%zu KB, tokenized on %d threads): %.2fms, compiling %.2fms\n",
+               strlen(source) / 1024, threads, tokenizing * 1e3, compiling * 1e3);
+    }
+    allocator_free(&alloc, source);
+
+    allocator_destroy(&alloc);
+    logger_destroy(&logger);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "instruction.h"
+#include "logging.h"
+#include "vm.h"
+
+// Measures raw dispatch throughput on straight-line arithmetic chunks, and the same chunk compiled by
+// the JIT.
+// Build with FEATURES=-DVM_SWITCH_DISPATCH to compare against the portable switch loop, or with
+// FEATURES=-DVM_PROFILE to print the per-opcode profile of the benchmark (timings then include the
+// profiler's overhead).
+
+#define NUM_GROUPS     12000
+#define NUM_RUNS       200
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Each group computes `acc + -(a * b - c / d)`. Only the final OP_ADD depends on the running
+// accumulator, so the measurement is dominated by dispatch rather than floating point latency.
+static int write_arithmetic_loop(OpCodeChunk *chunk, int num_groups) {
+    static const double operands[] = { 3, 2, 1, 2 };
+    int instructions = 0;
+    OpCodeChunk_write_constant(chunk, NUMBER_VAL(1), 1);
+    instructions++;
+    for (int i = 0; i < num_groups; i++) {
+        OpCodeChunk_write_constant(chunk, NUMBER_VAL(operands[0]), 1);
+        OpCodeChunk_write_constant(chunk, NUMBER_VAL(operands[1]), 1);
+        OpCodeChunk_write_code(chunk, OP_MULTIPLY, 1);
+        OpCodeChunk_write_constant(chunk, NUMBER_VAL(operands[2]), 1);
+        OpCodeChunk_write_constant(chunk, NUMBER_VAL(operands[3]), 1);
+        OpCodeChunk_write_code(chunk, OP_DIVIDE, 1);
+        OpCodeChunk_write_code(chunk, OP_SUBTRACT, 1);
+        OpCodeChunk_write_code(chunk, OP_NEGATE, 1);
+        OpCodeChunk_write_code(chunk, OP_ADD, 1);
+        instructions += 9;
+    }
+    OpCodeChunk_write_code(chunk, OP_RETURN, 1);
+    return instructions + 1;
+}
+
+// Loads (verifies, decodes and optionally compiles) the chunk once, then times only its execution.
+static void run(Allocator *alloc, OpCodeChunk *chunk, int instructions, bool jit) {
+    VirtualMachine vm;
+    virtual_machine_init(&vm, alloc);
+    vm.jit = jit;
+#ifdef VM_PROFILE
+    Profile profile;
+    profile_init(&profile);
+    vm.profile = &profile;
+#endif
+
+    struct timespec start, end;
+    LoadedChunk loaded;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    InterpretResult result = virtual_machine_load(&vm, chunk, &loaded);
+    Assert(result == INTERPRET_OK);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double load_seconds = elapsed_seconds(&start, &end);
+
+#ifdef VM_COMPUTED_GOTO
+    const char *mode = "computed-goto";
+#else
+    const char *mode = "switch";
+#endif
+    if (jit) {
+        if (loaded.jit.entry == NULL) {
+            printf("bench_dispatch (jit): not compiled (%s)\n", jit_result_name(loaded.jit_result));
+            loaded_chunk_destroy(&loaded, alloc);
+            virtual_machine_destroy(&vm);
+            return;
+        }
+        mode = "jit";
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int run = 0; run < NUM_RUNS; run++) {
+        result = virtual_machine_exec_loaded(&vm, &loaded);
+        Assert(result == INTERPRET_OK);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = elapsed_seconds(&start, &end);
+    loaded_chunk_destroy(&loaded, alloc);
+    virtual_machine_destroy(&vm);
+
+    double total = (double)instructions * NUM_RUNS;
+    printf("bench_dispatch (%s): %d instructions x %d runs in %.3fs, %.2f ns/instruction "
+           "(load %.2fms)\n",
+           mode, instructions, NUM_RUNS, seconds, seconds * 1e9 / total, load_seconds * 1e3);
+#ifdef VM_PROFILE
+    profile_write_report(&profile, stdout);
+#endif
+}
+
+int main(void) {
+    Logger logger;
+    Allocator alloc;
+    logger_init(&logger, "bench", stderr, LOG_LEVEL_ERROR);
+    allocator_init(&alloc, &logger);
+
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &alloc);
+    int instructions = write_arithmetic_loop(&chunk, NUM_GROUPS);
+
+    run(&alloc, &chunk, instructions, false);
+    run(&alloc, &chunk, instructions, true);
+
+    opcode_chunk_destroy(&chunk);
+    allocator_destroy(&alloc);
+    logger_destroy(&logger);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "executor.h"
+#include "logging.h"
+
+// Measures aggregate throughput of independent scripts as the number of executor workers grows.
+// Ideally jobs/s scales with the worker count up to the number of cores.
+
+#define NUM_JOBS      4000
+#define NUM_TERMS     2000
+#define MAX_WORKERS   8
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Writes a long arithmetic expression `1 + 2 * 3 - 4 / 5 + ...` so each job does real work.
+static char *write_source(Allocator *alloc) {
+    static const char operators[] = { '+', '*', '-', '/' };
+    char *source = (char *)allocator_alloc(alloc, NUM_TERMS * 8 + 1);
+    size_t length = 0;
+    for (int i = 0; i < NUM_TERMS; i++) {
+        length += (size_t)sprintf(source + length, "%s%d", i == 0 ? "" : " ", i % 97 + 1);
+        if (i + 1 < NUM_TERMS) {
+            length += (size_t)sprintf(source + length, " %c", operators[i % 4]);
+        }
+    }
+    source[length] = '\0';
+    return source;
+}
+
+int main(void) {
+    Logger logger;
+    Allocator alloc;
+    logger_init(&logger, "bench", stderr, LOG_LEVEL_ERROR);
+    allocator_init(&alloc, &logger);
+
+    char *source = write_source(&alloc);
+    static Job jobs[NUM_JOBS];
+    double baseline = 0;
+    for (int workers = 1; workers <= MAX_WORKERS; workers *= 2) {
+        for (int i = 0; i < NUM_JOBS; i++) {
+            jobs[i] = (Job){ .name = "bench", .source = source };
+        }
+        Executor executor;
+        executor_init(&executor, &alloc, &logger, workers);
+
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        bool started = executor_run(&executor, jobs, NUM_JOBS);
+        Assert(started);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsed_seconds(&start, &end);
+        if (workers == 1) {
+            baseline = seconds;
+        }
+
+        size_t stolen = 0;
+        for (int i = 0; i < workers; i++) {
+            stolen += executor.workers[i].stolen;
+        }
+        executor_destroy(&executor);
+        printf("bench_executor (%d workers): %d jobs in %.3fs, %.0f jobs/s, speedup %.2fx, "
+               "%zu stolen\n",
+               workers, NUM_JOBS, seconds, NUM_JOBS / seconds, baseline / seconds, stolen);
+    }
+
+    allocator_free(&alloc, source);
+    allocator_destroy(&alloc);
+    logger_destroy(&logger);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
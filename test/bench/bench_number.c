@@ -0,0 +1,109 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "assert.h"
+#include "logging.h"
+#include "number.h"
+
+// Measures converting number literals to doubles: number_parse (falling back to strtod when it
+// cannot decide) against copying each literal into a terminated buffer for strtod, which is what
+// the compiler did before. The literals mix short decimals, as programs usually contain, with
+// 17-digit values that exercise the slow path of the fast conversion.
+
+#define NUM_LITERALS  (1000 * 1000)
+#define LITERAL_SIZE  32
+#define NUM_RUNS      5
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void write_literals(char *literals, size_t *lengths) {
+    srand(42);
+    for (int i = 0; i < NUM_LITERALS; i++) {
+        double value = (double)rand() / RAND_MAX * 100000;
+        int length = i % 4 == 0 ? snprintf(literals + i * LITERAL_SIZE, LITERAL_SIZE, "%.17g", value)
+                                : snprintf(literals + i * LITERAL_SIZE, LITERAL_SIZE, "%.*f",
+                                           i % 7, value);
+        // %.17g may pick an exponent for tiny values, which Lox literals never have
+        if (strchr(literals + i * LITERAL_SIZE, 'e') != NULL) {
+            length = snprintf(literals + i * LITERAL_SIZE, LITERAL_SIZE, "%d", i);
+        }
+        lengths[i] = (size_t)length;
+    }
+}
+
+static double parse_fast(const char *literal, size_t length) {
+    double value;
+    if (number_parse(literal, length, &value)) {
+        return value;
+    }
+    char buffer[LITERAL_SIZE + 1];
+    memcpy(buffer, literal, length);
+    buffer[length] = '\0';
+    return strtod(buffer, NULL);
+}
+
+static double parse_strtod(const char *literal, size_t length) {
+    char buffer[LITERAL_SIZE + 1];
+    memcpy(buffer, literal, length);
+    buffer[length] = '\0';
+    return strtod(buffer, NULL);
+}
+
+static double run(double (*parse)(const char *, size_t), const char *literals,
+                  const size_t *lengths, double *sum) {
+    double best = 0;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        double total = 0;
+        for (int i = 0; i < NUM_LITERALS; i++) {
+            total += parse(literals + i * LITERAL_SIZE, lengths[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = elapsed_seconds(&start, &end);
+        if (run == 0 || seconds < best) {
+            best = seconds;
+        }
+        *sum = total;
+    }
+    return best;
+}
+
+int main(void) {
+    Logger logger;
+    Allocator alloc;
+    logger_init(&logger, "bench", stderr, LOG_LEVEL_ERROR);
+    allocator_init(&alloc, &logger);
+
+    char *literals = (char *)allocator_alloc(&alloc, (size_t)NUM_LITERALS * LITERAL_SIZE);
+    size_t *lengths = (size_t *)allocator_alloc(&alloc, sizeof(size_t) * NUM_LITERALS);
+    write_literals(literals, lengths);
+
+    size_t fast = 0;
+    for (int i = 0; i < NUM_LITERALS; i++) {
+        double value;
+        fast += number_parse(literals + i * LITERAL_SIZE, lengths[i], &value);
+    }
+
+    double fast_sum, strtod_sum;
+    double fast_seconds = run(parse_fast, literals, lengths, &fast_sum);
+    double strtod_seconds = run(parse_strtod, literals, lengths, &strtod_sum);
+    Assert(fast_sum == strtod_sum);
+    printf("bench_number (%d literals): number_parse %.1f ns/literal, strtod %.1f ns/literal, "
+           "speedup %.2fx, %.1f%% without fallback\n",
+           NUM_LITERALS, fast_seconds * 1e9 / NUM_LITERALS, strtod_seconds * 1e9 / NUM_LITERALS,
+           strtod_seconds / fast_seconds, fast * 100.0 / NUM_LITERALS);
+
+    allocator_free(&alloc, lengths);
+    allocator_free(&alloc, literals);
+    allocator_destroy(&alloc);
+    logger_destroy(&logger);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
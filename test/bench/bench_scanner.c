@@ -0,0 +1,139 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "allocator.h"
+#include "logging.h"
+#include "scanner.h"
+#include "token_buffer.h"
+
+// Measures scanner throughput on a generated Lox program: indented statements with keywords,
+// identifiers of mixed lengths, numbers, strings and comments, as a source file would have. Also
+// measures tokenizing the same source into a TokenBuffer, walking the buffered tokens, and
+// tokenizing in parallel on 1 to MAX_THREADS threads.
+
+#define SOURCE_SIZE (8 * 1024 * 1024)
+#define NUM_RUNS    5
+#define MAX_THREADS 8
+
+static double elapsed_seconds(struct timespec *start, struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static char *write_source(Allocator *alloc, size_t size) {
+    static const char *const lines[] = {
+        "fun fibonacci_number(n) {",
+        "    // returns the n-th Fibonacci number, computed iteratively",
+        "    var previous = 0;",
+        "    var current_value = 1;",
+        "    for (var i = 0; i < n; i = i + 1) {",
+        "        var next = previous + current_value;",
+        "        previous = current_value;",
+        "        current_value = next;",
+        "    }",
+        "    if (current_value >= 1234567.875 and n != 0) print \"a rather large number\";",
+        "    return current_value;",
+        "}",
+        "",
+        "class ShoppingCart < Container {",
+        "    init(owner) { this.owner = owner; this.total = 0.0; }",
+        "    add(item, price) { this.total = this.total + price * 1.2; return !false; }",
+        "}",
+        "",
+    };
+    int num_lines = sizeof(lines) / sizeof(lines[0]);
+    char *source = (char *)allocator_alloc(alloc, size + 256);
+    size_t length = 0;
+    for (int i = 0; length < size; i++) {
+        length += (size_t)sprintf(source + length, "%s\n", lines[i % num_lines]);
+    }
+    return source;
+}
+
+int main(void) {
+    Logger logger;
+    Allocator alloc;
+    logger_init(&logger, "bench", stderr, LOG_LEVEL_ERROR);
+    allocator_init(&alloc, &logger);
+
+    char *source = write_source(&alloc, SOURCE_SIZE);
+    size_t length = strlen(source);
+    double best = 0;
+    size_t num_tokens = 0;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        Scanner scanner;
+        scanner_init(&scanner, &alloc, source);
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        size_t count = 0;
+        for (Token token = scanner_scan(&scanner); token.type != TOKEN_EOF;
+             token = scanner_scan(&scanner)) {
+            Assert(token.type != TOKEN_ERROR);
+            count++;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        scanner_destroy(&scanner);
+        double seconds = elapsed_seconds(&start, &end);
+        if (run == 0 || seconds < best) {
+            best = seconds;
+        }
+        num_tokens = count;
+    }
+    printf("bench_scanner (%zu KB): %.2fms, %.0f MB/s, %.1f ns/token, %zu tokens\n", length / 1024,
+           best * 1e3, length / best / (1024 * 1024), best * 1e9 / num_tokens, num_tokens);
+
+    TokenBuffer tokens;
+    token_buffer_init(&tokens, &alloc);
+    double best_walk = 0;
+    for (int run = 0; run < NUM_RUNS; run++) {
+        struct timespec start, middle, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        token_buffer_tokenize(&tokens, source);
+        clock_gettime(CLOCK_MONOTONIC, &middle);
+        size_t operators = 0;
+        for (size_t i = 0; i < tokens.count; i++) {
+            operators += tokens.types[i] < TOKEN_IDENTIFIER;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        Assert(operators > 0);
+        double seconds = elapsed_seconds(&start, &middle);
+        double walk = elapsed_seconds(&middle, &end);
+        if (run == 0 || seconds < best) {
+            best = seconds;
+        }
+        if (run == 0 || walk < best_walk) {
+            best_walk = walk;
+        }
+    }
+    printf("bench_scanner (token buffer): %.2fms, %.0f MB/s, %.1f ns/token, %zu tokens, "
+           "%.2f KB per MB of source; walking the types %.2fms\n",
+           best * 1e3, length / best / (1024 * 1024), best * 1e9 / tokens.count, tokens.count,
+           tokens.count * 9.0 / 1024 / (length / (1024.0 * 1024)), best_walk * 1e3);
+
+    double baseline = 0;
+    for (int threads = 1; threads <= MAX_THREADS; threads *= 2) {
+        for (int run = 0; run < NUM_RUNS; run++) {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            token_buffer_tokenize_parallel(&tokens, source, threads);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double seconds = elapsed_seconds(&start, &end);
+            if (run == 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+        if (threads == 1) {
+            baseline = best;
+        }
+        printf("bench_scanner (%d threads): %.2fms, %.0f MB/s, speedup %.2fx\n", threads,
+               best * 1e3, length / best / (1024 * 1024), baseline / best);
+    }
+    token_buffer_destroy(&tokens);
+
+    allocator_free(&alloc, source);
+    allocator_destroy(&alloc);
+    logger_destroy(&logger);
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
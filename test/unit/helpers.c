@@ -1,7 +1,10 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "helpers.h"
 #include "unity.h"
@@ -25,6 +28,19 @@ void teardown(T *t) {
     logger_destroy(&t->log);
 }
 
+// Returns a descriptor, for the caller to close, reading `length` bytes of `source` from a
+// temporary file.
+int source_fd(const char *source, size_t length) {
+    FILE *file = tmpfile();
+    TEST_ASSERT_NOT_NULL(file);
+    TEST_ASSERT_EQUAL_INT(length, fwrite(source, 1, length, file));
+    TEST_ASSERT_EQUAL_INT(0, fflush(file));
+    int fd = dup(fileno(file)); // the file is already unlinked, and lives as long as a descriptor
+    fclose(file);
+    TEST_ASSERT_TRUE(fd >= 0 && lseek(fd, 0, SEEK_SET) == 0);
+    return fd;
+}
+
 String *escape_string(T *t, const char *source) {
     int length = 0;
     for (int i = 0; source[i] != '\0'; i++) {
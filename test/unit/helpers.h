@@ -19,6 +19,7 @@ typedef struct T {
 void setup(T *t);
 void teardown(T *t);
 
+int source_fd(const char *source, size_t length);
 String *escape_string(T *t, const char *source);
 int random_int(int min, int max);
 
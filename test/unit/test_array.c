@@ -37,7 +37,7 @@ void test_array(void) {
 
         Array *array = array_create(&t.alloc, unit_size, length);
         for (int i = 0; i < (int)length; i++) {
-            array_set(array, i, (void *)&data[i]);
+            array_set(array, i, (uint8_t *)data + i * unit_size);
         }
 
         TEST_ASSERT_EQUAL_size_t(length, array_length(array));
@@ -51,9 +51,9 @@ void test_array(void) {
 
 void test_array_copy(void) {
     uint32_t values[] = {
-        (uint32_t)random_int(0, UINT32_MAX),
-        (uint32_t)random_int(0, UINT32_MAX),
-        (uint32_t)random_int(0, UINT32_MAX),
+        (uint32_t)random_int(0, 1 << 30),
+        (uint32_t)random_int(0, 1 << 30),
+        (uint32_t)random_int(0, 1 << 30),
     };
     size_t unit_size = sizeof(uint32_t);
     size_t num_values = sizeof(values) / sizeof(values[0]);
@@ -89,9 +89,9 @@ void test_array_copy(void) {
 
 void test_array_resize(void) {
     uint32_t values[] = {
-        (uint32_t)random_int(0, UINT32_MAX),
-        (uint32_t)random_int(0, UINT32_MAX),
-        (uint32_t)random_int(0, UINT32_MAX),
+        (uint32_t)random_int(0, 1 << 30),
+        (uint32_t)random_int(0, 1 << 30),
+        (uint32_t)random_int(0, 1 << 30),
     };
     size_t unit_size = sizeof(uint32_t);
     size_t num_values = sizeof(values) / sizeof(values[0]);
@@ -170,6 +170,20 @@ void test_string_sprintf(void) {
     string_destroy(formatted, &t.alloc);
 }
 
+void test_string_appendf(void) {
+    String *str = string_dup_cstr(&t.alloc, "");
+    char expected[4096] = { 0 };
+    size_t length = 0;
+    for (int i = 0; i < 256; i++) {
+        str = string_appendf(str, &t.alloc, "%04d|", i);
+        length += snprintf(expected + length, sizeof(expected) - length, "%04d|", i);
+        TEST_ASSERT_EQUAL_size_t(length, string_length(str));
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, string_cstr(str));
+
+    string_destroy(str, &t.alloc);
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_empty_array);
@@ -179,5 +193,6 @@ int main(void) {
     RUN_TEST(test_string);
     RUN_TEST(test_string_dup);
     RUN_TEST(test_string_sprintf);
+    RUN_TEST(test_string_appendf);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "batch.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "vm.h"
+
+#define NUM_RANDOM_CHUNKS 200
+#define NUM_COLUMNS       3
+#define NUM_ROWS          (BATCH_BLOCK_ROWS * 2 + 37) // includes a partial block
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+static bool same_number(double a, double b) {
+    if (isnan(a) || isnan(b)) {
+        return isnan(a) && isnan(b);
+    }
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+static double random_number(void) {
+    return (double)random_int(-1000, 1000) / (double)random_int(1, 64);
+}
+
+// Writes a random chunk mixing constants and column reads, keeping the stack within `max_depth`.
+// The chunk returns with one or more values left on the stack.
+static void write_random_chunk(OpCodeChunk *chunk, int num_operations, int max_depth) {
+    static const OpCode binary[] = { OP_ADD, OP_SUBTRACT, OP_MULTIPLY, OP_DIVIDE };
+    int depth = 0;
+    for (int i = 0; i < num_operations; i++) {
+        int choice = random_int(0, 2);
+        if (depth < 2 || (choice == 0 && depth < max_depth)) {
+            if (random_int(0, 1) == 0) {
+                OpCodeChunk_write_constant(chunk, NUMBER_VAL(random_number()), i);
+            } else {
+                OpCodeChunk_write_column(chunk, random_int(0, NUM_COLUMNS - 1), i);
+            }
+            depth++;
+        } else if (choice == 1) {
+            OpCodeChunk_write_code(chunk, OP_NEGATE, i);
+        } else {
+            OpCodeChunk_write_code(chunk, binary[random_int(0, 3)], i);
+            depth--;
+        }
+    }
+    for (int left = random_int(1, depth); depth > left; depth--) {
+        OpCodeChunk_write_code(chunk, binary[random_int(0, 3)], num_operations);
+    }
+    OpCodeChunk_write_code(chunk, OP_RETURN, num_operations);
+}
+
+void test_batch_matches_interpreter(void) {
+    double data[NUM_COLUMNS][NUM_ROWS];
+    const double *columns[NUM_COLUMNS];
+    for (int column = 0; column < NUM_COLUMNS; column++) {
+        for (int row = 0; row < NUM_ROWS; row++) {
+            data[column][row] = random_int(0, 9) == 0 ? 0.0 : random_number();
+        }
+        columns[column] = data[column];
+    }
+    static double out[NUM_ROWS];
+
+    VirtualMachine vm;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    for (int test = 0; test < NUM_RANDOM_CHUNKS; test++) {
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        write_random_chunk(&chunk, random_int(1, 60), random_int(2, 8));
+
+        Batch batch;
+        TEST_ASSERT_EQUAL_INT(BATCH_OK, batch_init(&batch, &chunk, &t.alloc));
+        TEST_ASSERT_EQUAL_INT(BATCH_OK, batch_run(&batch, columns, NUM_COLUMNS, NUM_ROWS, out));
+
+        LoadedChunk loaded;
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+        for (int row = 0; row < NUM_ROWS; row++) {
+            double inputs[NUM_COLUMNS] = { data[0][row], data[1][row], data[2][row] };
+            vm.inputs = inputs;
+            vm.num_inputs = NUM_COLUMNS;
+            TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &loaded));
+            TEST_ASSERT_TRUE(same_number(AS_NUMBER(vm.result), out[row]));
+        }
+
+        loaded_chunk_destroy(&loaded, &t.alloc);
+        batch_destroy(&batch);
+        opcode_chunk_destroy(&chunk);
+    }
+    virtual_machine_destroy(&vm);
+}
+
+void test_batch_errors(void) {
+    struct {
+        const char *name;
+        Value constant;
+        int column;
+        int num_columns;
+        bool missing_return;
+        BatchResult init_result;
+        BatchResult run_result;
+    } test_cases[] = {
+        { .name = "ok",
+          .constant = NUMBER_VAL(2),
+          .column = 1,
+          .num_columns = 2,
+          .init_result = BATCH_OK,
+          .run_result = BATCH_OK },
+        { .name = "missing column",
+          .constant = NUMBER_VAL(2),
+          .column = 2,
+          .num_columns = 2,
+          .init_result = BATCH_OK,
+          .run_result = BATCH_MISSING_COLUMN },
+        { .name = "non-number constant",
+          .constant = NIL_VAL,
+          .column = 0,
+          .num_columns = 2,
+          .init_result = BATCH_NON_NUMBER_CONSTANT },
+        { .name = "invalid chunk",
+          .constant = NUMBER_VAL(2),
+          .column = 0,
+          .num_columns = 2,
+          .missing_return = true,
+          .init_result = BATCH_INVALID_CHUNK },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    double column[] = { 1, 2, 3 };
+    const double *columns[] = { column, column };
+
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        OpCodeChunk_write_constant(&chunk, test_cases[test].constant, 1);
+        OpCodeChunk_write_column(&chunk, test_cases[test].column, 1);
+        OpCodeChunk_write_code(&chunk, OP_MULTIPLY, 1);
+        if (!test_cases[test].missing_return) {
+            OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+        }
+
+        Batch batch;
+        BatchResult result = batch_init(&batch, &chunk, &t.alloc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].init_result, result, name);
+        if (result == BATCH_OK) {
+            double out[3];
+            TEST_ASSERT_EQUAL_INT_MESSAGE(
+                test_cases[test].run_result,
+                batch_run(&batch, columns, test_cases[test].num_columns, 3, out), name);
+            if (test_cases[test].run_result == BATCH_OK) {
+                TEST_ASSERT_TRUE_MESSAGE(out[0] == 2 && out[1] == 4 && out[2] == 6, name);
+            }
+            batch_destroy(&batch);
+        }
+        opcode_chunk_destroy(&chunk);
+    }
+}
+
+void test_batch_constant_result(void) {
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(3), 1);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(4), 1);
+    OpCodeChunk_write_code(&chunk, OP_MULTIPLY, 1);
+    OpCodeChunk_write_code(&chunk, OP_NEGATE, 1);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+
+    Batch batch;
+    TEST_ASSERT_EQUAL_INT(BATCH_OK, batch_init(&batch, &chunk, &t.alloc));
+    TEST_ASSERT_EQUAL_INT(0, batch.num_columns);
+    double out[BATCH_BLOCK_ROWS + 1];
+    TEST_ASSERT_EQUAL_INT(BATCH_OK, batch_run(&batch, NULL, 0, BATCH_BLOCK_ROWS + 1, out));
+    for (int row = 0; row < BATCH_BLOCK_ROWS + 1; row++) {
+        TEST_ASSERT_TRUE(out[row] == -12);
+    }
+
+    batch_destroy(&batch);
+    opcode_chunk_destroy(&chunk);
+}
+
+// OP_RETURN returns the top of the stack, as the VM does, when other values are left under it.
+void test_batch_return_top(void) {
+    struct {
+        const char *name;
+        bool column_on_top;
+    } test_cases[] = {
+        { .name = "column over constant", .column_on_top = true },
+        { .name = "constant over column", .column_on_top = false },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    double column[] = { 1, 2, 3 };
+    const double *columns[] = { column };
+
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        if (test_cases[test].column_on_top) {
+            OpCodeChunk_write_constant(&chunk, NUMBER_VAL(7), 1);
+            OpCodeChunk_write_column(&chunk, 0, 1);
+        } else {
+            OpCodeChunk_write_column(&chunk, 0, 1);
+            OpCodeChunk_write_constant(&chunk, NUMBER_VAL(7), 1);
+        }
+        OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+
+        Batch batch;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(BATCH_OK, batch_init(&batch, &chunk, &t.alloc), name);
+        double out[3];
+        TEST_ASSERT_EQUAL_INT_MESSAGE(BATCH_OK, batch_run(&batch, columns, 1, 3, out), name);
+
+        VirtualMachine vm;
+        virtual_machine_init(&vm, &t.alloc);
+        vm.output = NULL;
+        LoadedChunk loaded;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded),
+                                      name);
+        for (int row = 0; row < 3; row++) {
+            vm.inputs = &column[row];
+            vm.num_inputs = 1;
+            TEST_ASSERT_EQUAL_INT_MESSAGE(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &loaded),
+                                          name);
+            TEST_ASSERT_TRUE_MESSAGE(same_number(AS_NUMBER(vm.result), out[row]), name);
+            TEST_ASSERT_TRUE_MESSAGE(out[row] == (test_cases[test].column_on_top ? column[row] : 7),
+                                     name);
+        }
+
+        loaded_chunk_destroy(&loaded, &t.alloc);
+        virtual_machine_destroy(&vm);
+        batch_destroy(&batch);
+        opcode_chunk_destroy(&chunk);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_batch_matches_interpreter);
+    RUN_TEST(test_batch_errors);
+    RUN_TEST(test_batch_constant_result);
+    RUN_TEST(test_batch_return_top);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "chunk_cache.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "vm.h"
+
+static T t;
+static VirtualMachine vm;
+
+void setUp(void) {
+    setup(&t);
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+}
+
+void tearDown(void) {
+    virtual_machine_destroy(&vm);
+    teardown(&t);
+}
+
+// Stands in for the compiler: caches a chunk returning `number` under `source`.
+static ChunkCacheEntry *put(ChunkCache *cache, const char *source, double number) {
+    OpCodeChunk chunk;
+    LoadedChunk loaded;
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(number), 1);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+    ChunkCacheEntry *entry = chunk_cache_put(cache, source, strlen(source), &chunk, &loaded);
+    if (entry == NULL) {
+        loaded_chunk_destroy(&loaded, &t.alloc);
+        opcode_chunk_destroy(&chunk);
+    }
+    return entry;
+}
+
+static double run(ChunkCacheEntry *entry) {
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &entry->loaded));
+    return AS_NUMBER(vm.result);
+}
+
+void test_chunk_cache_get(void) {
+    ChunkCache cache;
+    chunk_cache_init(&cache, &t.alloc, CHUNK_CACHE_DEFAULT_SIZE);
+
+    TEST_ASSERT_NULL(chunk_cache_get(&cache, "1 + 2", 5));
+    TEST_ASSERT_NOT_NULL(put(&cache, "1 + 2", 3));
+    TEST_ASSERT_NOT_NULL(put(&cache, "1 + 3", 4));
+
+    ChunkCacheEntry *entry = chunk_cache_get(&cache, "1 + 2", 5);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_TRUE(entry->loaded.chunk == &entry->chunk);
+    TEST_ASSERT_TRUE(run(entry) == 3);
+    TEST_ASSERT_TRUE(run(chunk_cache_get(&cache, "1 + 3", 5)) == 4);
+    // the lookup compares the whole source, not just a prefix
+    TEST_ASSERT_NULL(chunk_cache_get(&cache, "1 + 2", 4));
+    TEST_ASSERT_EQUAL_size_t(2, cache.hits);
+    TEST_ASSERT_EQUAL_size_t(2, cache.misses);
+
+    chunk_cache_destroy(&cache);
+}
+
+void test_chunk_cache_eviction(void) {
+    ChunkCache cache;
+    chunk_cache_init(&cache, &t.alloc, CHUNK_CACHE_DEFAULT_SIZE);
+    ChunkCacheEntry *entry = put(&cache, "a", 1);
+    size_t entry_size = entry->size;
+    chunk_cache_destroy(&cache);
+
+    // room for exactly three entries of the same size
+    chunk_cache_init(&cache, &t.alloc, entry_size * 3);
+    put(&cache, "a", 1);
+    put(&cache, "b", 2);
+    put(&cache, "c", 3);
+    TEST_ASSERT_NOT_NULL(chunk_cache_get(&cache, "a", 1)); // "b" is now least recently used
+    put(&cache, "d", 4);
+
+    TEST_ASSERT_EQUAL_size_t(3, cache.count);
+    TEST_ASSERT_EQUAL_size_t(1, cache.evictions);
+    TEST_ASSERT_TRUE(cache.size <= cache.max_size);
+    TEST_ASSERT_NULL(chunk_cache_get(&cache, "b", 1));
+    TEST_ASSERT_TRUE(run(chunk_cache_get(&cache, "a", 1)) == 1);
+    TEST_ASSERT_TRUE(run(chunk_cache_get(&cache, "c", 1)) == 3);
+    TEST_ASSERT_TRUE(run(chunk_cache_get(&cache, "d", 1)) == 4);
+
+    // an entry larger than the whole cache is not cached and evicts nothing
+    chunk_cache_destroy(&cache);
+    chunk_cache_init(&cache, &t.alloc, entry_size - 1);
+    TEST_ASSERT_NULL(put(&cache, "a", 1));
+    TEST_ASSERT_EQUAL_size_t(0, cache.count);
+    chunk_cache_destroy(&cache);
+}
+
+void test_chunk_cache_growth(void) {
+    ChunkCache cache;
+    chunk_cache_init(&cache, &t.alloc, CHUNK_CACHE_DEFAULT_SIZE);
+    char source[32];
+    for (int i = 0; i < CHUNK_CACHE_MIN_BUCKETS * 4; i++) {
+        snprintf(source, sizeof(source), "%d * 2", i);
+        TEST_ASSERT_NOT_NULL(put(&cache, source, i * 2));
+    }
+    TEST_ASSERT_TRUE(cache.num_buckets > CHUNK_CACHE_MIN_BUCKETS);
+    for (int i = 0; i < CHUNK_CACHE_MIN_BUCKETS * 4; i++) {
+        snprintf(source, sizeof(source), "%d * 2", i);
+        ChunkCacheEntry *entry = chunk_cache_get(&cache, source, strlen(source));
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_TRUE(run(entry) == i * 2);
+    }
+    chunk_cache_destroy(&cache);
+}
+
+void test_chunk_cache_hash(void) {
+    const char *source = "print 1 + 2 * 3 - 4 / 5;";
+    size_t length = strlen(source);
+    TEST_ASSERT_EQUAL_UINT64(chunk_cache_hash(source, length), chunk_cache_hash(source, length));
+    // every length, including partial trailing words, hashes differently
+    for (size_t i = 0; i < length; i++) {
+        TEST_ASSERT_TRUE(chunk_cache_hash(source, i) != chunk_cache_hash(source, i + 1));
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_chunk_cache_get);
+    RUN_TEST(test_chunk_cache_eviction);
+    RUN_TEST(test_chunk_cache_growth);
+    RUN_TEST(test_chunk_cache_hash);
+    return UNITY_END();
+}
\ No newline at end of file
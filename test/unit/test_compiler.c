@@ -0,0 +1,212 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "compiler.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "source_stream.h"
+#include "vm.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_compile(void) {
+    struct {
+        const char *source;
+        CompileResult result;
+        Value value;
+    } test_cases[] = {
+        { .source = "1", .result = COMPILE_OK, .value = NUMBER_VAL(1) },
+        { .source = "1.5;", .result = COMPILE_OK, .value = NUMBER_VAL(1.5) },
+        { .source = "2 + 3 * 4", .result = COMPILE_OK, .value = NUMBER_VAL(14) },
+        { .source = "20 - 3 * 4", .result = COMPILE_OK, .value = NUMBER_VAL(8) },
+        { .source = "2 - 6 / 3", .result = COMPILE_OK, .value = NUMBER_VAL(0) },
+        { .source = "10 - 4 - 3", .result = COMPILE_OK, .value = NUMBER_VAL(3) },
+        { .source = "1-1", .result = COMPILE_OK, .value = NUMBER_VAL(0) },
+        { .source = "(5 - (3 - 1)) + -1", .result = COMPILE_OK, .value = NUMBER_VAL(2) },
+        { .source = "--2", .result = COMPILE_OK, .value = NUMBER_VAL(2) },
+        { .source = "-2 * 3", .result = COMPILE_OK, .value = NUMBER_VAL(-6) },
+        { .source = "// leading comment\n1 +\n// inner comment\n2", .result = COMPILE_OK,
+          .value = NUMBER_VAL(3) },
+        { .source = "true", .result = COMPILE_OK, .value = BOOL_VAL(true) },
+        { .source = "false", .result = COMPILE_OK, .value = BOOL_VAL(false) },
+        { .source = "nil", .result = COMPILE_OK, .value = NIL_VAL },
+        { .source = "", .result = COMPILE_PARSE_ERROR },
+        { .source = "1 +", .result = COMPILE_PARSE_ERROR },
+        { .source = "(1", .result = COMPILE_PARSE_ERROR },
+        { .source = "1 2", .result = COMPILE_PARSE_ERROR },
+        { .source = "1;;", .result = COMPILE_PARSE_ERROR },
+        { .source = "1 == 1", .result = COMPILE_PARSE_ERROR },
+        { .source = "1 # 2", .result = COMPILE_SCAN_ERROR },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    VirtualMachine vm;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *source = test_cases[test].source;
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].result,
+                                      compile(&t.alloc, source, &chunk, stderr), source);
+        if (test_cases[test].result == COMPILE_OK) {
+            TEST_ASSERT_EQUAL_INT_MESSAGE(INTERPRET_OK, virtual_machine_run(&vm, &chunk), source);
+            TEST_ASSERT_TRUE_MESSAGE(values_equal(test_cases[test].value, vm.result), source);
+        }
+        opcode_chunk_destroy(&chunk);
+    }
+    virtual_machine_destroy(&vm);
+}
+
+void test_compile_emits_bytecode(void) {
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    TEST_ASSERT_EQUAL_INT(COMPILE_OK, compile(&t.alloc, "1 +\n2 * -3", &chunk, stderr));
+
+    String *repr = opcode_chunk_repr(&chunk, string_create(&t.alloc, 1), "main");
+    TEST_ASSERT_EQUAL_STRING("== OpCodeChunk(main) ==\n"
+                             "0000    1 OP_CONSTANT         0 Value(1)\n"
+                             "0002    2 OP_CONSTANT         1 Value(2)\n"
+                             "0004    | OP_CONSTANT         2 Value(3)\n"
+                             "0006    | OP_NEGATE\n"
+                             "0007    | OP_MULTIPLY\n"
+                             "0008    1 OP_ADD\n"
+                             "0009    2 OP_RETURN\n",
+                             string_cstr(repr));
+
+    string_destroy(repr, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+}
+
+void test_compile_nesting(void) {
+    struct {
+        int depth;
+        CompileResult result;
+    } test_cases[] = {
+        { .depth = 100, .result = COMPILE_OK },
+        { .depth = 1024, .result = COMPILE_OK },
+        { .depth = 1025, .result = COMPILE_PARSE_ERROR },
+        { .depth = 100000, .result = COMPILE_PARSE_ERROR },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    for (int test = 0; test < num_test_cases; test++) {
+        int depth = test_cases[test].depth;
+        char *source = (char *)allocator_alloc(&t.alloc, depth * 2 + 2);
+        memset(source, '(', depth);
+        source[depth] = '1';
+        memset(source + depth + 1, ')', depth);
+        source[depth * 2 + 1] = '\0';
+
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        TEST_ASSERT_EQUAL_INT(test_cases[test].result, compile(&t.alloc, source, &chunk, stderr));
+        opcode_chunk_destroy(&chunk);
+        allocator_free(&t.alloc, source);
+    }
+}
+
+// A long left-associative chain compiles with constant native stack, one constant per literal.
+void test_compile_large(void) {
+    enum { NUM_TERMS = 200000 };
+    char *source = (char *)allocator_alloc(&t.alloc, NUM_TERMS * 4);
+    size_t length = 0;
+    for (int i = 0; i < NUM_TERMS; i++) {
+        length += (size_t)sprintf(source + length, i == 0 ? "1" : " + 1");
+    }
+
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    TEST_ASSERT_EQUAL_INT(COMPILE_OK, compile(&t.alloc, source, &chunk, stderr));
+    TEST_ASSERT_EQUAL_size_t(NUM_TERMS, vector_len(&chunk.constants.values));
+
+    VirtualMachine vm;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_run(&vm, &chunk));
+    TEST_ASSERT_TRUE(AS_NUMBER(vm.result) == NUM_TERMS);
+
+    virtual_machine_destroy(&vm);
+    opcode_chunk_destroy(&chunk);
+    allocator_free(&t.alloc, source);
+}
+
+// A source far larger than the chunk is presized for, here mostly whitespace, still compiles.
+void test_compile_huge_source(void) {
+    size_t length = 72 * 1024 * 1024; // a constant per 4 bytes would need 144 MB
+    char *source = (char *)allocator_alloc(&t.alloc, length + 1);
+    memset(source, ' ', length);
+    memcpy(source + length - 6, "1 + 2;", 6);
+    source[length] = '\0';
+
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    TEST_ASSERT_EQUAL_INT(COMPILE_OK, compile(&t.alloc, source, &chunk, stderr));
+    TEST_ASSERT_EQUAL_size_t(2, vector_len(&chunk.constants.values));
+
+    opcode_chunk_destroy(&chunk);
+    allocator_free(&t.alloc, source);
+}
+
+// Compiling from a stream, a few bytes at a time, emits the same bytecode and lines as compiling
+// the source whole.
+void test_compile_stream(void) {
+    const char *test_cases[] = {
+        "1 +\n2 * -3",
+        "\n(1 +\n\n2) == \"a\nb\" + \"c\";\n",
+        "// a comment\n-1.25e3 // and another\n",
+        "1 +\n",
+        "\"unterminated\n",
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *source = test_cases[test];
+        OpCodeChunk expected;
+        opcode_chunk_init(&expected, &t.alloc);
+        CompileResult result = compile(&t.alloc, source, &expected, stderr);
+
+        int fd = source_fd(source, strlen(source));
+        SourceStream stream;
+        source_stream_init(&stream, &t.alloc, fd, 3);
+        OpCodeChunk actual;
+        opcode_chunk_init(&actual, &t.alloc);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(result, compile_stream(&t.alloc, &stream, &actual, stderr),
+                                      source);
+        if (result == COMPILE_OK) {
+            String *expected_repr = opcode_chunk_repr(&expected, string_create(&t.alloc, 1), "");
+            String *actual_repr = opcode_chunk_repr(&actual, string_create(&t.alloc, 1), "");
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(string_cstr(expected_repr), string_cstr(actual_repr),
+                                             source);
+            string_destroy(actual_repr, &t.alloc);
+            string_destroy(expected_repr, &t.alloc);
+        }
+
+        opcode_chunk_destroy(&actual);
+        source_stream_destroy(&stream);
+        close(fd);
+        opcode_chunk_destroy(&expected);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compile);
+    RUN_TEST(test_compile_emits_bytecode);
+    RUN_TEST(test_compile_nesting);
+    RUN_TEST(test_compile_large);
+    RUN_TEST(test_compile_huge_source);
+    RUN_TEST(test_compile_stream);
+    return UNITY_END();
+}
\ No newline at end of file
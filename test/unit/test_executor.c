@@ -0,0 +1,119 @@
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "executor.h"
+#include "helpers.h"
+#include "vm.h"
+
+#define NUM_JOBS 500
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_executor_runs_every_job(void) {
+    static const char *sources[] = { "1 + 2", "-(3 * 4)", "10 / 4 - 1", "true", "1 +", "" };
+    int num_sources = sizeof(sources) / sizeof(sources[0]);
+    int worker_counts[] = { 1, 2, 4, 7 };
+
+    // The expected results come from running each source on a single VM.
+    InterpretResult expected[sizeof(sources) / sizeof(sources[0])];
+    Value expected_values[sizeof(sources) / sizeof(sources[0])];
+    VirtualMachine vm;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    for (int i = 0; i < num_sources; i++) {
+        expected[i] = interpret(&vm, sources[i]);
+        expected_values[i] = vm.result;
+    }
+    virtual_machine_destroy(&vm);
+
+    static Job jobs[NUM_JOBS];
+    for (int test = 0; test < (int)(sizeof(worker_counts) / sizeof(worker_counts[0])); test++) {
+        int num_workers = worker_counts[test];
+        for (int i = 0; i < NUM_JOBS; i++) {
+            jobs[i] = (Job){ .name = "job", .source = sources[i % num_sources], .worker = -1 };
+        }
+
+        Executor executor;
+        executor_init(&executor, &t.alloc, &t.log, num_workers);
+        TEST_ASSERT_TRUE(executor_run(&executor, jobs, NUM_JOBS));
+
+        size_t completed = 0;
+        for (int i = 0; i < num_workers; i++) {
+            completed += executor.workers[i].completed;
+        }
+        TEST_ASSERT_EQUAL_size_t(NUM_JOBS, completed);
+        for (int i = 0; i < NUM_JOBS; i++) {
+            TEST_ASSERT_TRUE(jobs[i].worker >= 0 && jobs[i].worker < num_workers);
+            TEST_ASSERT_FALSE(jobs[i].read_failed);
+            TEST_ASSERT_EQUAL_INT(expected[i % num_sources], jobs[i].result);
+            if (jobs[i].result == INTERPRET_OK) {
+                TEST_ASSERT_TRUE(values_equal(expected_values[i % num_sources], jobs[i].value));
+            }
+        }
+        executor_destroy(&executor);
+    }
+}
+
+void test_executor_missing_file(void) {
+    Job jobs[] = {
+        { .name = "/nonexistent/clox/script.lox" },
+    };
+
+    Executor executor;
+    executor_init(&executor, &t.alloc, &t.log, 2);
+    TEST_ASSERT_TRUE(executor_run(&executor, jobs, 1));
+    TEST_ASSERT_TRUE(jobs[0].read_failed);
+    executor_destroy(&executor);
+}
+
+// Each job's errors are kept apart from the others', however the jobs are spread over the workers.
+void test_executor_reports_per_job(void) {
+    struct {
+        Job job;
+        const char *errors;
+    } test_cases[] = {
+        { { .name = "ok", .source = "1 + 2" }, NULL },
+        { { .name = "runtime", .source = "-true" },
+          "Operand must be a number.\n[line 1] in script\n" },
+        { { .name = "compile", .source = "1 +" }, "[line 1] Error at end: Expect expression.\n" },
+        { { .name = "/nonexistent/clox/script.lox" },
+          "failed to open: No such file or directory\n" },
+    };
+    enum { NUM_TEST_CASES = sizeof(test_cases) / sizeof(test_cases[0]) };
+    static Job jobs[NUM_JOBS];
+    for (int i = 0; i < NUM_JOBS; i++) {
+        jobs[i] = test_cases[i % NUM_TEST_CASES].job;
+    }
+
+    Executor executor;
+    executor_init(&executor, &t.alloc, &t.log, 4);
+    TEST_ASSERT_TRUE(executor_run(&executor, jobs, NUM_JOBS));
+    for (int i = 0; i < NUM_JOBS; i++) {
+        const char *expected = test_cases[i % NUM_TEST_CASES].errors;
+        if (expected == NULL) {
+            TEST_ASSERT_NULL_MESSAGE(jobs[i].errors, jobs[i].name);
+        } else {
+            TEST_ASSERT_NOT_NULL_MESSAGE(jobs[i].errors, jobs[i].name);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(expected, string_cstr(jobs[i].errors), jobs[i].name);
+        }
+    }
+    executor_destroy(&executor);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_executor_runs_every_job);
+    RUN_TEST(test_executor_missing_file);
+    RUN_TEST(test_executor_reports_per_job);
+    return UNITY_END();
+}
\ No newline at end of file
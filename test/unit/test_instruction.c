@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "instruction.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_disassemble(void) {
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(1.5), 1);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(2), 1);
+    OpCodeChunk_write_code(&chunk, OP_ADD, 1);
+    OpCodeChunk_write_code(&chunk, OP_NEGATE, 2);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 3);
+
+    String *repr = opcode_chunk_repr(&chunk, string_create(&t.alloc, 1), "test");
+    TEST_ASSERT_EQUAL_STRING("== OpCodeChunk(test) ==\n"
+                             "0000    1 OP_CONSTANT         0 Value(1.5)\n"
+                             "0002    | OP_CONSTANT         1 Value(2)\n"
+                             "0004    | OP_ADD\n"
+                             "0005    2 OP_NEGATE\n"
+                             "0006    3 OP_RETURN\n",
+                             string_cstr(repr));
+
+    String *instruction = opcode_chunk_instruction_repr(&chunk, string_create(&t.alloc, 1), 2);
+    TEST_ASSERT_EQUAL_STRING("0002    | OP_CONSTANT         1 Value(2)", string_cstr(instruction));
+
+    string_destroy(repr, &t.alloc);
+    string_destroy(instruction, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_disassemble);
+    return UNITY_END();
+}
@@ -0,0 +1,144 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "jit.h"
+#include "vm.h"
+
+#define NUM_RANDOM_CHUNKS 500
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+// Runs the chunk through the interpreter and (when `jit` is set) the JIT, returning the result.
+static InterpretResult run(OpCodeChunk *chunk, bool jit, JitResult *jit_result, Value *result) {
+    VirtualMachine vm;
+    LoadedChunk loaded;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.jit = jit;
+    InterpretResult interpret_result = virtual_machine_load(&vm, chunk, &loaded);
+    if (interpret_result == INTERPRET_OK) {
+        *jit_result = loaded.jit_result;
+        interpret_result = virtual_machine_exec_loaded(&vm, &loaded);
+        *result = vm.result;
+        loaded_chunk_destroy(&loaded, &t.alloc);
+    }
+    virtual_machine_destroy(&vm);
+    return interpret_result;
+}
+
+static bool same_number(double a, double b) {
+    if (isnan(a) || isnan(b)) {
+        return isnan(a) && isnan(b);
+    }
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Writes a random chunk that keeps the stack within `max_depth` slots.
+static void write_random_chunk(OpCodeChunk *chunk, int num_operations, int max_depth) {
+    static const OpCode binary[] = { OP_ADD, OP_SUBTRACT, OP_MULTIPLY, OP_DIVIDE };
+    static const double interesting[] = { 0.0, -0.0, 1.0, -1.0, 0.5, 3.0, 1e308, -1e-308 };
+    int depth = 0;
+    for (int i = 0; i < num_operations; i++) {
+        int choice = random_int(0, 2);
+        if (depth < 2 || (choice == 0 && depth < max_depth)) {
+            double number = random_int(0, 3) == 0
+                                ? interesting[random_int(0, 7)]
+                                : (double)random_int(-1000, 1000) / (double)random_int(1, 64);
+            OpCodeChunk_write_constant(chunk, NUMBER_VAL(number), i);
+            depth++;
+        } else if (choice == 1) {
+            OpCodeChunk_write_code(chunk, OP_NEGATE, i);
+        } else {
+            OpCodeChunk_write_code(chunk, binary[random_int(0, 3)], i);
+            depth--;
+        }
+    }
+    for (; depth > 1; depth--) {
+        OpCodeChunk_write_code(chunk, binary[random_int(0, 3)], num_operations);
+    }
+    OpCodeChunk_write_code(chunk, OP_RETURN, num_operations);
+}
+
+void test_jit_matches_interpreter(void) {
+#ifdef JIT_SUPPORTED
+    for (int test = 0; test < NUM_RANDOM_CHUNKS; test++) {
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        write_random_chunk(&chunk, random_int(1, 300), random_int(2, JIT_MAX_STACK_DEPTH));
+
+        JitResult jit_result;
+        Value expected, actual;
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, run(&chunk, false, &jit_result, &expected));
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, run(&chunk, true, &jit_result, &actual));
+        TEST_ASSERT_EQUAL_INT(JIT_OK, jit_result);
+        TEST_ASSERT_TRUE(IS_NUMBER(actual));
+        TEST_ASSERT_TRUE(same_number(AS_NUMBER(expected), AS_NUMBER(actual)));
+
+        opcode_chunk_destroy(&chunk);
+    }
+#endif
+}
+
+void test_jit_fallback(void) {
+    struct {
+        const char *name;
+        int depth;
+        bool non_number;
+        JitResult jit_result;
+        InterpretResult result;
+    } test_cases[] = {
+        { .name = "too deep",
+          .depth = JIT_MAX_STACK_DEPTH + 1,
+          .jit_result = JIT_STACK_TOO_DEEP,
+          .result = INTERPRET_OK },
+        { .name = "non-number constant",
+          .depth = 2,
+          .non_number = true,
+          .jit_result = JIT_UNSUPPORTED_CONSTANT,
+          .result = INTERPRET_RUNTIME_ERROR },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+        OpCodeChunk chunk;
+        opcode_chunk_init(&chunk, &t.alloc);
+        for (int i = 0; i < test_cases[test].depth; i++) {
+            Value value = test_cases[test].non_number && i == 0 ? BOOL_VAL(true) : NUMBER_VAL(i);
+            OpCodeChunk_write_constant(&chunk, value, 1);
+        }
+        for (int i = 1; i < test_cases[test].depth; i++) {
+            OpCodeChunk_write_code(&chunk, OP_ADD, 1);
+        }
+        OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+
+        JitResult jit_result;
+        Value result;
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].result,
+                                      run(&chunk, true, &jit_result, &result), name);
+#ifdef JIT_SUPPORTED
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].jit_result, jit_result, name);
+#endif
+        opcode_chunk_destroy(&chunk);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_jit_matches_interpreter);
+    RUN_TEST(test_jit_fallback);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "line_index.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_line_index(void) {
+    struct {
+        const char *source;
+        size_t offset;
+        int line;
+        int column;
+    } test_cases[] = {
+        { "", 0, 1, 1 },          { "abc", 0, 1, 1 },       { "abc", 3, 1, 4 },
+        { "a\nb", 1, 1, 2 },      { "a\nb", 2, 2, 1 },      { "a\n", 2, 2, 1 },
+        { "\n\n\nx", 3, 4, 1 },   { "ab\ncd\nef", 4, 2, 2 }, { "ab\ncd\nef", 8, 3, 3 },
+        { "x\r\ny", 3, 2, 1 },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *source = test_cases[test].source;
+        LineIndex lines;
+        line_index_init(&lines, &t.alloc, source, strlen(source));
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].line,
+                                      line_index_line(&lines, test_cases[test].offset), source);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].column,
+                                      line_index_column(&lines, test_cases[test].offset), source);
+        line_index_destroy(&lines);
+    }
+}
+
+// Lookups forwards, backwards and scattered over many lines of different lengths agree with
+// counting the newlines before each offset.
+void test_line_index_order(void) {
+    static const char text[] = "print 1 + 2 * 3 - 4 / 5; // and so on";
+    static char source[16 * 1024];
+    size_t length = 0;
+    for (int i = 0; length + sizeof(text) < sizeof(source); i++) {
+        length += (size_t)sprintf(source + length, "%.*s\n", i % (int)sizeof(text), text);
+    }
+    static int expected[sizeof(source)];
+    int line = 1;
+    for (size_t offset = 0; offset <= length; offset++) {
+        expected[offset] = line;
+        line += source[offset] == '\n';
+    }
+
+    LineIndex lines;
+    line_index_init(&lines, &t.alloc, source, length);
+    for (size_t offset = 0; offset <= length; offset++) {
+        TEST_ASSERT_EQUAL_INT(expected[offset], line_index_line(&lines, offset));
+    }
+    for (size_t offset = length + 1; offset-- > 0;) {
+        TEST_ASSERT_EQUAL_INT(expected[offset], line_index_line(&lines, offset));
+    }
+    for (size_t i = 0; i <= length; i++) {
+        size_t offset = (i * 7919) % (length + 1);
+        TEST_ASSERT_EQUAL_INT(expected[offset], line_index_line(&lines, offset));
+    }
+    line_index_destroy(&lines);
+}
+
+// An index of more lines than one allocation could hold the starts of, at a size_t each, still
+// finds every line.
+void test_line_index_many_lines(void) {
+    size_t num_lines = ((size_t)1 << 24) + 12345;
+    size_t length = num_lines - 1 + 5;
+    char *source = (char *)allocator_alloc(&t.alloc, length + 1);
+    memset(source, '\n', num_lines - 1);
+    memcpy(source + num_lines - 1, "1 + 2", 6);
+
+    LineIndex lines;
+    line_index_init(&lines, &t.alloc, source, length);
+    TEST_ASSERT_EQUAL_INT(num_lines, line_index_line(&lines, length));
+    TEST_ASSERT_EQUAL_INT(5, line_index_column(&lines, length - 1));
+    for (size_t line = 0; line < num_lines; line += 65521) {
+        TEST_ASSERT_EQUAL_INT(line + 1, line_index_line(&lines, line));
+    }
+    TEST_ASSERT_EQUAL_INT(1, line_index_line(&lines, 0));
+    TEST_ASSERT_EQUAL_size_t(num_lines, lines.count);
+    line_index_destroy(&lines);
+    allocator_free(&t.alloc, source);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_line_index);
+    RUN_TEST(test_line_index_order);
+    RUN_TEST(test_line_index_many_lines);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "helpers.h"
+#include "number.h"
+
+#define NUM_RANDOM_LITERALS 200000
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+// Returns whether number_parse converted the literal, asserting it agrees with strtod to the bit.
+static bool check(const char *literal) {
+    double expected = strtod(literal, NULL);
+    double actual;
+    if (!number_parse(literal, strlen(literal), &actual)) {
+        return false;
+    }
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(&expected, &actual, sizeof(double), literal);
+    return true;
+}
+
+void test_number_parse(void) {
+    struct {
+        const char *literal;
+        bool converted;
+    } test_cases[] = {
+        { "0", true },
+        { "000", true },
+        { "0.0", true },
+        { "1", true },
+        { "12.5", true },
+        { "0.1", true },
+        { "0.30000000000000004", true },
+        { "3.141592653589793", true },
+        { "9007199254740992", true },     // 2^53
+        { "9007199254740993", true },     // halfway between doubles, rounds to even
+        { "9007199254740995", true },     // halfway, rounds up to even
+        { "123456789012345678", true },
+        { "9999999999999999999", true },  // 19 digits
+        { "2.2250738585072014", true },
+        { "1.7976931348623157", true },
+        { "0.000000000000000000000000000001", true },
+        { "7.3177701707893310", true },
+        { "18446744073709551615", false }, // 20 significant digits
+        { "1.00000000000000011102230246251565404236316680908203125", false },
+        { "179769313486231570000000000000000000000", false },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    for (int test = 0; test < num_test_cases; test++) {
+        TEST_ASSERT_EQUAL_MESSAGE(test_cases[test].converted, check(test_cases[test].literal),
+                                  test_cases[test].literal);
+    }
+}
+
+// Random literals of up to 19 significant digits, some below one with runs of leading zeros and
+// some ending in 5 to land near halfway cases, all convert and match strtod.
+void test_number_parse_random(void) {
+    char literal[64];
+    for (int i = 0; i < NUM_RANDOM_LITERALS; i++) {
+        int integer_digits = random_int(0, 10);
+        int fraction_digits = random_int(0, 19 - integer_digits);
+        int zeros = integer_digits == 0 && random_int(0, 3) == 0 ? random_int(0, 20) : 0;
+        int length = 0;
+        if (integer_digits == 0) {
+            literal[length++] = '0';
+        } else {
+            literal[length++] = (char)('0' + random_int(1, 9));
+            for (int d = 1; d < integer_digits; d++) {
+                literal[length++] = (char)('0' + random_int(0, 9));
+            }
+        }
+        if (fraction_digits > 0) {
+            literal[length++] = '.';
+            for (int d = 0; d < zeros; d++) {
+                literal[length++] = '0';
+            }
+            for (int d = 0; d < fraction_digits; d++) {
+                literal[length++] = (char)('0' + random_int(0, 9));
+            }
+            if (random_int(0, 1)) {
+                literal[length - 1] = '5';
+            }
+        }
+        literal[length] = '\0';
+        TEST_ASSERT_TRUE_MESSAGE(check(literal), literal);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_number_parse);
+    RUN_TEST(test_number_parse_random);
+    return UNITY_END();
+}
\ No newline at end of file
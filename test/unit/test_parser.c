@@ -20,8 +20,24 @@ void tearDown(void) {
 void test_parse(void) {
     struct {
         const char *source;
+        int num_tokens;
+        TokenType types[8];
+        ParserState state;
+        int error_line;
     } test_cases[] = {
-        { .source = "1 + 2;" },
+        { .source = "1 + 2;",
+          .num_tokens = 5,
+          .types = { TOKEN_NUMBER, TOKEN_PLUS, TOKEN_NUMBER, TOKEN_SEMICOLON, TOKEN_EOF },
+          .state = PARSER_OK },
+        { .source = "// comment\n1 // trailing",
+          .num_tokens = 2,
+          .types = { TOKEN_NUMBER, TOKEN_EOF },
+          .state = PARSER_OK },
+        { .source = "1\n# 2",
+          .num_tokens = 3,
+          .types = { TOKEN_NUMBER, TOKEN_NUMBER, TOKEN_EOF },
+          .state = PARSER_ERROR,
+          .error_line = 2 },
     };
     int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
 
@@ -32,10 +48,102 @@ void test_parse(void) {
 
         scanner_init(&scanner, &t.alloc, source);
         parser_init(&parser, &t.alloc, &scanner);
+        for (int i = 0; i < test_cases[test].num_tokens; i++) {
+            parser_advance(&parser);
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(token_type_name(test_cases[test].types[i]),
+                                             token_type_name(parser.current.type), source);
+        }
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].state, parser.state, source);
+        if (test_cases[test].state == PARSER_ERROR) {
+            TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].error_line, parser.error.line, source);
+            TEST_ASSERT_TRUE_MESSAGE(parser.error.scan, source);
+        }
 
-        // TODO
+        parser_destroy(&parser);
+        scanner_destroy(&scanner);
+    }
+}
+
+void test_parse_error(void) {
+    Scanner scanner;
+    Parser parser;
+    scanner_init(&scanner, &t.alloc, "(1 2");
+    parser_init(&parser, &t.alloc, &scanner);
+
+    parser_advance(&parser);
+    TEST_ASSERT_TRUE(parser_match(&parser, TOKEN_LEFT_PAREN));
+    TEST_ASSERT_FALSE(parser_match(&parser, TOKEN_RIGHT_PAREN));
+    parser_advance(&parser);
+    parser_consume(&parser, TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
+    TEST_ASSERT_EQUAL_INT(PARSER_ERROR, parser.state);
+    TEST_ASSERT_EQUAL_STRING("[line 1] Error at '2': Expect ')' after expression.\n",
+                             string_cstr(parser.error.message));
+    // only the first error is kept
+    parser_advance(&parser);
+    parser_consume(&parser, TOKEN_RIGHT_PAREN, "Expect ')' after expression.");
+    TEST_ASSERT_EQUAL_STRING("[line 1] Error at '2': Expect ')' after expression.\n",
+                             string_cstr(parser.error.message));
+
+    parser_destroy(&parser);
+    scanner_destroy(&scanner);
+}
+
+// An error at a string quotes the whole literal, as it appears in the source.
+void test_parse_error_at_string(void) {
+    Scanner scanner;
+    Parser parser;
+    scanner_init(&scanner, &t.alloc, "1 \"abc\"");
+    parser_init(&parser, &t.alloc, &scanner);
+
+    parser_advance(&parser);
+    parser_advance(&parser);
+    parser_consume(&parser, TOKEN_EOF, "Expect end of expression.");
+    TEST_ASSERT_EQUAL_STRING("[line 1] Error at '\"abc\"': Expect end of expression.\n",
+                             string_cstr(parser.error.message));
+
+    parser_destroy(&parser);
+    scanner_destroy(&scanner);
+}
+
+// A parser reading a tokenized buffer sees the same tokens, lines and errors as one reading the
+// scanner.
+void test_parse_tokens(void) {
+    static const char *const sources[] = { "(1 +\n2) * -3; // done", "1 +\n\n2 3", "" };
+    int num_sources = sizeof(sources) / sizeof(sources[0]);
+    for (int test = 0; test < num_sources; test++) {
+        Scanner scanner;
+        Parser expected, actual;
+        TokenBuffer tokens;
+        scanner_init(&scanner, &t.alloc, sources[test]);
+        parser_init(&expected, &t.alloc, &scanner);
+        token_buffer_init(&tokens, &t.alloc);
+        token_buffer_tokenize(&tokens, sources[test]);
+        parser_init_tokens(&actual, &t.alloc, &tokens);
+
+        do {
+            parser_advance(&expected);
+            parser_advance(&actual);
+            TEST_ASSERT_EQUAL_INT(expected.current.type, actual.current.type);
+            TEST_ASSERT_TRUE(expected.current.start == actual.current.start);
+            TEST_ASSERT_EQUAL_INT(parser_line(&expected, &expected.current),
+                                  parser_line(&actual, &actual.current));
+            if (expected.current.type == TOKEN_NUMBER && actual.current.start[0] == '3') {
+                parser_error_at(&expected, &expected.current, "Unexpected number.");
+                parser_error_at(&actual, &actual.current, "Unexpected number.");
+            }
+        } while (expected.current.type != TOKEN_EOF);
+        // reading past the end keeps returning TOKEN_EOF
+        parser_advance(&actual);
+        TEST_ASSERT_EQUAL_INT(TOKEN_EOF, actual.current.type);
 
-        // parser_destroy(&parser);
+        TEST_ASSERT_EQUAL_INT(expected.state, actual.state);
+        if (expected.state == PARSER_ERROR) {
+            TEST_ASSERT_EQUAL_STRING(string_cstr(expected.error.message),
+                                     string_cstr(actual.error.message));
+        }
+        parser_destroy(&expected);
+        parser_destroy(&actual);
+        token_buffer_destroy(&tokens);
         scanner_destroy(&scanner);
     }
 }
@@ -43,5 +151,8 @@ void test_parse(void) {
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_parse);
+    RUN_TEST(test_parse_error);
+    RUN_TEST(test_parse_error_at_string);
+    RUN_TEST(test_parse_tokens);
     return UNITY_END();
 }
\ No newline at end of file
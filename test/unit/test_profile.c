@@ -0,0 +1,86 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "profile.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_profile_record(void) {
+    Profile profile;
+    profile_init(&profile);
+
+    OpCode run[] = { OP_CONSTANT, OP_CONSTANT, OP_ADD, OP_NEGATE, OP_RETURN };
+    int num_runs = PROFILE_SAMPLE_PERIOD * 4;
+    for (int i = 0; i < num_runs; i++) {
+        profile_begin(&profile);
+        for (size_t j = 0; j < sizeof(run) / sizeof(run[0]); j++) {
+            profile_record(&profile, run[j]);
+        }
+        profile_end(&profile);
+    }
+
+    TEST_ASSERT_EQUAL_UINT64(2 * num_runs, profile.counts[OP_CONSTANT]);
+    TEST_ASSERT_EQUAL_UINT64(num_runs, profile.counts[OP_ADD]);
+    TEST_ASSERT_EQUAL_UINT64(0, profile.counts[OP_DIVIDE]);
+    TEST_ASSERT_EQUAL_UINT64(num_runs, profile.pairs[OP_CONSTANT][OP_CONSTANT]);
+    TEST_ASSERT_EQUAL_UINT64(num_runs, profile.pairs[OP_CONSTANT][OP_ADD]);
+    TEST_ASSERT_EQUAL_UINT64(num_runs, profile.pairs[OP_NEGATE][OP_RETURN]);
+    // pairs do not span separate runs
+    TEST_ASSERT_EQUAL_UINT64(0, profile.pairs[OP_RETURN][OP_CONSTANT]);
+
+    uint64_t samples = 0;
+    for (int code = 0; code < NUM_OPCODES; code++) {
+        samples += profile.samples[code];
+    }
+    TEST_ASSERT_EQUAL_UINT64(5 * num_runs / PROFILE_SAMPLE_PERIOD, samples);
+}
+
+void test_profile_report(void) {
+    Profile profile;
+    profile_init(&profile);
+    OpCode run[] = { OP_CONSTANT, OP_CONSTANT, OP_CONSTANT, OP_ADD, OP_ADD, OP_RETURN };
+    for (size_t i = 0; i < sizeof(run) / sizeof(run[0]); i++) {
+        profile_record(&profile, run[i]);
+    }
+    profile_end(&profile);
+
+    char *report = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&report, &size);
+    profile_write_report(&profile, out);
+    fclose(out);
+
+    TEST_ASSERT_NOT_NULL(strstr(report, "== Profile (6 instructions) =="));
+    TEST_ASSERT_NOT_NULL(strstr(report, "== Opcode pairs (5) =="));
+    // opcodes are listed by descending count and unexecuted opcodes are omitted
+    char *constant = strstr(report, "OP_CONSTANT ");
+    char *add = strstr(report, "OP_ADD ");
+    char *ret = strstr(report, "OP_RETURN ");
+    TEST_ASSERT_NOT_NULL(constant);
+    TEST_ASSERT_NOT_NULL(add);
+    TEST_ASSERT_NOT_NULL(ret);
+    TEST_ASSERT_TRUE(constant < add && add < ret);
+    TEST_ASSERT_NULL(strstr(report, "OP_DIVIDE"));
+    free(report);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_profile_record);
+    RUN_TEST(test_profile_report);
+    return UNITY_END();
+}
\ No newline at end of file
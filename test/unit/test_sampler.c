@@ -0,0 +1,94 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "sampler.h"
+#include "vm.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_sampler_collect(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    LoadedChunk loaded;
+    Sampler sampler;
+    virtual_machine_init(&vm, &t.alloc);
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(1), 1);   // instruction 0
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(2), 3);   // instruction 1
+    OpCodeChunk_write_code(&chunk, OP_ADD, 3);              // instruction 2
+    OpCodeChunk_write_code(&chunk, OP_NEGATE, 200);         // instruction 3
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 200);         // instruction 4
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+    sampler_init(&sampler, &vm, &t.alloc, "test.lox", SAMPLER_DEFAULT_INTERVAL_US);
+
+    int samples[] = { 0, 1, 2, 2, 3, 4, 4, 4 };
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        sampler_record(&sampler, &loaded.code[samples[i]]);
+    }
+    sampler_record(&sampler, NULL);
+    sampler_collect(&sampler, &loaded);
+    TEST_ASSERT_EQUAL_INT(0, sampler.num_ips);
+    TEST_ASSERT_EQUAL_INT(1, sampler.idle);
+
+    char *collapsed = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&collapsed, &size);
+    sampler_write_collapsed(&sampler, out);
+    fclose(out);
+    TEST_ASSERT_EQUAL_STRING("<script>;test.lox:1 1\n"
+                             "<script>;test.lox:3 3\n"
+                             "<script>;test.lox:200 4\n",
+                             collapsed);
+    free(collapsed);
+
+    sampler_destroy(&sampler);
+    loaded_chunk_destroy(&loaded, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+void test_sampler_signal(void) {
+    VirtualMachine vm;
+    Sampler sampler;
+    Instruction instruction;
+    virtual_machine_init(&vm, &t.alloc);
+    sampler_init(&sampler, &vm, &t.alloc, "test.lox", 1000);
+
+    // pretend the VM is executing and burn CPU time until the profiling timer has fired
+    vm.ip = &instruction;
+    TEST_ASSERT_TRUE(sampler_start(&sampler));
+    clock_t start = clock();
+    while (sampler.num_ips == 0 && clock() - start < 2 * CLOCKS_PER_SEC) {
+    }
+    sampler_stop(&sampler);
+    vm.ip = NULL;
+
+    TEST_ASSERT_TRUE(sampler.num_ips > 0);
+    TEST_ASSERT_TRUE(sampler.ips[0] == &instruction);
+
+    sampler_destroy(&sampler);
+    virtual_machine_destroy(&vm);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sampler_collect);
+    RUN_TEST(test_sampler_signal);
+    return UNITY_END();
+}
\ No newline at end of file
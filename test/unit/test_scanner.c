@@ -5,22 +5,30 @@
 
 #include "allocator.h"
 #include "helpers.h"
+#include "line_index.h"
 #include "logging.h"
 #include "scanner.h"
 
 static T t;
 
+// Tokens don't carry their line, so the expected line is checked against the source's LineIndex.
+typedef struct ExpectedToken {
+    Token token;
+    int line;
+} ExpectedToken;
+
 #define TOKEN(_type, _start, _length, _line)                                                       \
-    (Token) {                                                                                      \
-        .type = (_type), .start = (_start), .length = (_length), .line = (_line)                   \
+    (ExpectedToken) {                                                                              \
+        .token = { .type = (_type), .start = (_start), .length = (_length) }, .line = (_line)      \
     }
 
 #define EOF_TOKEN(_line)                                                                           \
-    (Token) {                                                                                      \
-        .type = TOKEN_EOF, .start = NULL, .length = 0, .line = (_line)                             \
+    (ExpectedToken) {                                                                              \
+        .token = { .type = TOKEN_EOF, .start = NULL, .length = 0 }, .line = (_line)                \
     }
 
-static void assert_token_equal(const char *source, Token *expected, Token *actual);
+static void assert_token_equal(const char *source, ExpectedToken *expected, Token *actual);
+static int line_of(const char *source, Token *token);
 
 void setUp(void) {
     setup(&t);
@@ -34,7 +42,7 @@ void test_scan(void) {
     struct {
         const char *source;
         int num_tokens;
-        const Token tokens[15];
+        const ExpectedToken tokens[15];
     } test_cases[] = {
         { .source = "and",
           .num_tokens = 2,
@@ -129,11 +137,12 @@ void test_scan(void) {
 
     };
     int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
-    Token expected, actual;
+    ExpectedToken expected;
+    Token actual;
     Scanner scanner;
     for (int test = 0; test < num_test_cases; test++) {
         const char *source = test_cases[test].source;
-        const Token *tokens = test_cases[test].tokens;
+        const ExpectedToken *tokens = test_cases[test].tokens;
 
         scanner_init(&scanner, &t.alloc, source);
 
@@ -147,14 +156,114 @@ void test_scan(void) {
     }
 }
 
+// Runs of every length around the vector width, so each fast path ends in every lane and in the
+// scalar tail, and the scanner never reads past the end of the source.
+void test_scan_runs(void) {
+    char source[256];
+    Scanner scanner;
+    Token token;
+    for (int n = 1; n < 100; n++) {
+        // an identifier, then whitespace containing n / 4 newlines, then a number
+        memset(source, 'a', n);
+        source[n / 2] = '_';
+        int length = n;
+        for (int i = 0; i < n; i++) {
+            source[length++] = i % 4 == 3 ? '\n' : " \t\r"[i % 3];
+        }
+        memset(source + length, '7', n);
+        strcpy(source + length + n, ".5");
+
+        scanner_init(&scanner, &t.alloc, source);
+        token = scanner_scan(&scanner);
+        TEST_ASSERT_EQUAL_INT(TOKEN_IDENTIFIER, token.type);
+        TEST_ASSERT_EQUAL_INT(n, token.length);
+        token = scanner_scan(&scanner);
+        TEST_ASSERT_EQUAL_INT(TOKEN_NUMBER, token.type);
+        TEST_ASSERT_EQUAL_INT(n + 2, token.length);
+        TEST_ASSERT_EQUAL_INT(1 + n / 4, line_of(source, &token));
+        TEST_ASSERT_EQUAL_INT(TOKEN_EOF, scanner_scan(&scanner).type);
+        scanner_destroy(&scanner);
+
+        // a string spanning n / 8 newlines, then a comment running to the end of the source
+        source[0] = '"';
+        for (int i = 1; i <= n; i++) {
+            source[i] = i % 8 == 0 ? '\n' : 'x';
+        }
+        strcpy(source + n + 1, "\"//");
+        memset(source + n + 4, '/', n);
+        source[2 * n + 4] = '\0';
+
+        scanner_init(&scanner, &t.alloc, source);
+        token = scanner_scan(&scanner);
+        TEST_ASSERT_EQUAL_INT(TOKEN_STRING, token.type);
+        TEST_ASSERT_EQUAL_INT(n, token.length);
+        TEST_ASSERT_EQUAL_INT(1, line_of(source, &token));
+        token = scanner_scan(&scanner);
+        TEST_ASSERT_EQUAL_INT(TOKEN_COMMENT, token.type);
+        TEST_ASSERT_EQUAL_INT(n, token.length);
+        TEST_ASSERT_EQUAL_INT(1 + n / 8, line_of(source, &token));
+        TEST_ASSERT_EQUAL_INT(TOKEN_EOF, scanner_scan(&scanner).type);
+        scanner_destroy(&scanner);
+    }
+}
+
+void test_scan_edges(void) {
+    struct {
+        const char *source;
+        TokenType type;
+        int length;
+    } test_cases[] = {
+        { "\"\"", TOKEN_STRING, 0 },   { "\"a\"", TOKEN_STRING, 1 },
+        { "\"", TOKEN_ERROR, 0 },       { "\"abc", TOKEN_ERROR, 0 },
+        { "//", TOKEN_COMMENT, 0 },      { "//\n", TOKEN_COMMENT, 0 },
+        { "1.", TOKEN_NUMBER, 1 },       { "12.x", TOKEN_NUMBER, 2 },
+        { "Zz_9", TOKEN_IDENTIFIER, 4 }, { "   ", TOKEN_EOF, 0 },
+        { "@", TOKEN_ERROR, 0 },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    Scanner scanner;
+    for (int test = 0; test < num_test_cases; test++) {
+        scanner_init(&scanner, &t.alloc, test_cases[test].source);
+        Token token = scanner_scan(&scanner);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].type, token.type, test_cases[test].source);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].length, token.length,
+                                      test_cases[test].source);
+        scanner_destroy(&scanner);
+    }
+}
+
+// Words that share a prefix with a keyword, or differ only in case, are identifiers.
+void test_scan_keyword_prefixes(void) {
+    static const char *const identifiers[] = {
+        "a",    "an",    "andy",  "And",  "f",     "fa",      "fals",   "falsey",
+        "fo",   "form",  "fun_",  "fu",   "i",     "iff",     "IF",     "n",
+        "nill", "o",     "orb",   "prin", "t",     "th",      "thi",    "thisx",
+        "tr",   "tru",   "truex", "v",    "va",    "vars",    "w",      "whil",
+        "_if",  "xor",   "super1", "returns", "classy", "elsewhere",
+    };
+    int num_identifiers = sizeof(identifiers) / sizeof(identifiers[0]);
+    Scanner scanner;
+    for (int i = 0; i < num_identifiers; i++) {
+        scanner_init(&scanner, &t.alloc, identifiers[i]);
+        Token token = scanner_scan(&scanner);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(TOKEN_IDENTIFIER, token.type, identifiers[i]);
+        TEST_ASSERT_EQUAL_INT_MESSAGE((int)strlen(identifiers[i]), token.length, identifiers[i]);
+        scanner_destroy(&scanner);
+    }
+}
+
 int main(void) {
     UNITY_BEGIN();
     RUN_TEST(test_scan);
+    RUN_TEST(test_scan_runs);
+    RUN_TEST(test_scan_edges);
+    RUN_TEST(test_scan_keyword_prefixes);
     return UNITY_END();
 }
 
-static void assert_token_equal(const char *source, Token *expected, Token *actual) {
+static void assert_token_equal(const char *source, ExpectedToken *expected_token, Token *actual) {
     static char message[4096];
+    Token *expected = &expected_token->token;
 
     String *escaped_source = escape_string(&t, source);
     String *expected_repr = token_repr(expected, &t.alloc);
@@ -164,12 +273,20 @@ static void assert_token_equal(const char *source, Token *expected, Token *actua
             (int)actual_repr->length, actual_repr->data);
 
     TEST_ASSERT_EQUAL_INT_MESSAGE(expected->type, actual->type, message);
-    if (expected->length == 0) {
-        TEST_ASSERT_NULL_MESSAGE(actual->start, message);
+    if (expected->type == TOKEN_EOF) {
+        TEST_ASSERT_TRUE_MESSAGE(actual->start == source + strlen(source), message);
     } else {
         TEST_ASSERT_EQUAL_STRING_LEN_MESSAGE(expected->start, actual->start, expected->length,
                                              message);
     }
     TEST_ASSERT_EQUAL_INT_MESSAGE(expected->length, actual->length, message);
-    TEST_ASSERT_EQUAL_INT_MESSAGE(expected->line, actual->line, message);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expected_token->line, line_of(source, actual), message);
+}
+
+static int line_of(const char *source, Token *token) {
+    LineIndex lines;
+    line_index_init(&lines, &t.alloc, source, strlen(source));
+    int line = line_index_line(&lines, (size_t)(token->start - source));
+    line_index_destroy(&lines);
+    return line;
 }
\ No newline at end of file
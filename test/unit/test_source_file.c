@@ -0,0 +1,153 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "compiler.h"
+#include "helpers.h"
+#include "source_file.h"
+
+static T t;
+
+static char *make_source(size_t length);
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+// Large files are mapped, whether or not they fill their last page, and small ones are read.
+void test_source_file_map(void) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t large = SOURCE_FILE_MIN_MAPPED + page;
+    struct {
+        size_t length;
+        bool mapped;
+    } test_cases[] = {
+        { 0, false },        { 1, false },     { SOURCE_FILE_MIN_MAPPED - 1, false },
+        { large - 1, true }, { large, true }, { large + 1, true },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    for (int test = 0; test < num_test_cases; test++) {
+        size_t length = test_cases[test].length;
+        char *source = make_source(length);
+        int fd = source_fd(source, length);
+
+        SourceFile file;
+        TEST_ASSERT_TRUE(source_file_map(&file, &t.alloc, fd));
+        TEST_ASSERT_EQUAL_INT(length, file.length);
+        TEST_ASSERT_EQUAL_INT(test_cases[test].mapped, file.mapping != NULL);
+        TEST_ASSERT_EQUAL_MEMORY(source, file.source, length);
+        TEST_ASSERT_EQUAL_INT('\0', file.source[length]);
+
+        source_file_destroy(&file);
+        close(fd);
+        allocator_free(&t.alloc, source);
+    }
+}
+
+// A mapped source larger than compile() presizes a chunk for compiles, as exec_file runs it.
+void test_source_file_compile_huge(void) {
+    size_t length = 72 * 1024 * 1024 + 1;
+    char *source = (char *)allocator_alloc(&t.alloc, length);
+    memset(source, ' ', length);
+    memcpy(source, "1 + 2;", 6);
+    int fd = source_fd(source, length);
+    allocator_free(&t.alloc, source);
+
+    SourceFile file;
+    TEST_ASSERT_TRUE(source_file_map(&file, &t.alloc, fd));
+    TEST_ASSERT_NOT_NULL(file.mapping);
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    TEST_ASSERT_EQUAL_INT(COMPILE_OK, compile(&t.alloc, file.source, &chunk, stderr));
+
+    opcode_chunk_destroy(&chunk);
+    source_file_destroy(&file);
+    close(fd);
+}
+
+// A file filling its last page, and larger than any one allocation, is mapped rather than read.
+// The file is sparse, so all but its first few bytes read as zeros without taking any disk.
+void test_source_file_map_page_multiple(void) {
+    size_t length = (MAX_LARGE_ALLOC_SIZE) + (size_t)sysconf(_SC_PAGESIZE);
+    int fd = source_fd("1 + 2;", 6);
+    TEST_ASSERT_EQUAL_INT(0, ftruncate(fd, (off_t)length));
+
+    SourceFile file;
+    TEST_ASSERT_TRUE(source_file_map(&file, &t.alloc, fd));
+    TEST_ASSERT_NOT_NULL(file.mapping);
+    TEST_ASSERT_EQUAL_size_t(length, file.length);
+    TEST_ASSERT_EQUAL_MEMORY("1 + 2;", file.source, 6);
+    TEST_ASSERT_EQUAL_INT('\0', file.source[length - 1]);
+    TEST_ASSERT_EQUAL_INT('\0', file.source[length]);
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    TEST_ASSERT_EQUAL_INT(COMPILE_OK, compile(&t.alloc, file.source, &chunk, stderr));
+
+    opcode_chunk_destroy(&chunk);
+    source_file_destroy(&file);
+    close(fd);
+}
+
+// A pipe can't be mapped, but is read whole, however many times the buffer has to grow.
+void test_source_file_pipe(void) {
+    size_t length = 10000; // small enough to fit in the pipe before it is read
+    char *source = make_source(length);
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    TEST_ASSERT_EQUAL_INT(length, write(fds[1], source, length));
+    close(fds[1]);
+
+    SourceFile file;
+    TEST_ASSERT_FALSE(source_file_map(&file, &t.alloc, fds[0]));
+    TEST_ASSERT_EQUAL_INT(ENODEV, errno);
+    TEST_ASSERT_TRUE(source_file_read(&file, &t.alloc, fds[0]));
+    TEST_ASSERT_EQUAL_INT(length, file.length);
+    TEST_ASSERT_EQUAL_MEMORY(source, file.source, length);
+    TEST_ASSERT_EQUAL_INT('\0', file.source[length]);
+
+    source_file_destroy(&file);
+    close(fds[0]);
+    allocator_free(&t.alloc, source);
+}
+
+void test_source_file_read_error(void) {
+    SourceFile file;
+    TEST_ASSERT_FALSE(source_file_map(&file, &t.alloc, -1));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+    TEST_ASSERT_FALSE(source_file_read(&file, &t.alloc, -1));
+    TEST_ASSERT_EQUAL_INT(EBADF, errno);
+}
+
+#pragma region Private
+
+// Returns `length` bytes of lines of source, without a terminating NUL of their own.
+static char *make_source(size_t length) {
+    static const char line[] = "print 1 + 2;\n";
+    char *source = (char *)allocator_alloc(&t.alloc, length + 1);
+    for (size_t i = 0; i < length; i++) {
+        source[i] = line[i % (sizeof(line) - 1)];
+    }
+    return source;
+}
+
+#pragma endregion
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_source_file_map);
+    RUN_TEST(test_source_file_compile_huge);
+    RUN_TEST(test_source_file_map_page_multiple);
+    RUN_TEST(test_source_file_pipe);
+    RUN_TEST(test_source_file_read_error);
+    return UNITY_END();
+}
\ No newline at end of file
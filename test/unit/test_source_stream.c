@@ -0,0 +1,167 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "compiler.h"
+#include "helpers.h"
+#include "line_index.h"
+#include "scanner.h"
+#include "source_stream.h"
+
+static T t;
+
+static size_t assert_stream_scans(const char *source, size_t length, size_t window);
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+// Whatever the window, a stream yields the tokens, text and lines of scanning the whole source.
+void test_source_stream(void) {
+    const char *test_cases[] = {
+        "",
+        "1 + 2",
+        "1 +\n2;\n",
+        "\n\n\n(1 == 2) != !true\n",
+        "\"a\nb\nc\" + \"\" + \"d\"\n",
+        "\"unterminated\n\n",
+        "// a comment\n1 // and another",
+        "a_rather_long_identifier_longer_than_the_window >= 1.5",
+        "1\n\n\n#\n",
+        "x\r\ny",
+    };
+    size_t windows[] = { 1, 2, 3, 7, SOURCE_STREAM_WINDOW };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+    for (int test = 0; test < num_test_cases; test++) {
+        for (size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+            assert_stream_scans(test_cases[test], strlen(test_cases[test]), windows[i]);
+        }
+    }
+}
+
+// A source many windows long is read without the buffer growing past the window.
+void test_source_stream_large(void) {
+    static const char line[] = "print 1 + 2 * 3 - \"four\nfive\" / 6; // and so on\n";
+    enum { NUM_LINES = 4096 };
+    size_t length = (sizeof(line) - 1) * NUM_LINES;
+    char *source = (char *)allocator_alloc(&t.alloc, length + 1);
+    for (int i = 0; i < NUM_LINES; i++) {
+        memcpy(source + i * (sizeof(line) - 1), line, sizeof(line));
+    }
+    TEST_ASSERT_EQUAL_INT(256, assert_stream_scans(source, length, 256));
+    allocator_free(&t.alloc, source);
+}
+
+void test_source_stream_read_error(void) {
+    SourceStream stream;
+    source_stream_init(&stream, &t.alloc, -1, SOURCE_STREAM_WINDOW);
+    TEST_ASSERT_FALSE(source_stream_refill(&stream, 0));
+    TEST_ASSERT_TRUE(stream.done);
+    TEST_ASSERT_TRUE(stream.error != 0);
+    source_stream_destroy(&stream);
+}
+
+// A line longer than the buffer may grow to ends the stream with EFBIG, after the lines before it,
+// and compiling it reports a read error rather than running out of memory.
+void test_source_stream_line_too_long(void) {
+    const char *source = "1 +\n\"a string longer than the buffer may grow\" + 2\n";
+    int fd = source_fd(source, strlen(source));
+    SourceStream stream;
+    source_stream_init(&stream, &t.alloc, fd, 4);
+    stream.max_capacity = 16;
+    Scanner scanner;
+    scanner_init_stream(&scanner, &t.alloc, &stream);
+    TokenType expected[] = { TOKEN_NUMBER, TOKEN_PLUS, TOKEN_EOF };
+    Token previous = { 0 };
+    for (size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+        Token token = scanner_scan_stream(&scanner, &previous);
+        TEST_ASSERT_EQUAL_STRING(token_type_name(expected[i]), token_type_name(token.type));
+        previous = token;
+    }
+    TEST_ASSERT_EQUAL_INT(EFBIG, stream.error);
+    TEST_ASSERT_EQUAL_INT(16, stream.capacity);
+    scanner_destroy(&scanner);
+    source_stream_destroy(&stream);
+
+    TEST_ASSERT_EQUAL_INT(0, lseek(fd, 0, SEEK_SET));
+    source_stream_init(&stream, &t.alloc, fd, 4);
+    stream.max_capacity = 16;
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    TEST_ASSERT_EQUAL_INT(COMPILE_READ_ERROR, compile_stream(&t.alloc, &stream, &chunk, stderr));
+    opcode_chunk_destroy(&chunk);
+    source_stream_destroy(&stream);
+    close(fd);
+}
+
+#pragma region Private
+
+// Scans the source whole and through a stream side by side, and returns the capacity the stream's
+// buffer grew to. Each stream token is checked while the next one is scanned past it, as the
+// parser's previous token is.
+static size_t assert_stream_scans(const char *source, size_t length, size_t window) {
+    Scanner scanner;
+    scanner_init_range(&scanner, &t.alloc, source, source + length);
+    LineIndex lines;
+    line_index_init(&lines, &t.alloc, source, length);
+
+    int fd = source_fd(source, length);
+    SourceStream stream;
+    source_stream_init(&stream, &t.alloc, fd, window);
+    Scanner streamed;
+    scanner_init_stream(&streamed, &t.alloc, &stream);
+
+    Token expected_previous = { 0 }, previous = { 0 };
+    for (;;) {
+        Token expected = scanner_scan(&scanner);
+        Token actual = scanner_scan_stream(&streamed, &previous);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(token_type_name(expected.type),
+                                         token_type_name(actual.type), source);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(expected.length, actual.length, source);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected.start, actual.start, expected.length, source);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(line_index_line(&lines, expected.start - source),
+                                      source_stream_line(&stream, actual.start), source);
+        if (expected.type == TOKEN_ERROR) {
+            TEST_ASSERT_EQUAL_STRING_MESSAGE(scanner.error, streamed.error, source);
+        }
+        if (expected_previous.start != NULL) {
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected_previous.start, previous.start,
+                                             expected_previous.length, source);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(line_index_line(&lines, expected_previous.start - source),
+                                          source_stream_line(&stream, previous.start), source);
+        }
+        if (expected.type == TOKEN_EOF) {
+            break;
+        }
+        expected_previous = expected;
+        previous = actual;
+    }
+    TEST_ASSERT_EQUAL_INT(0, stream.error);
+    size_t capacity = stream.capacity;
+
+    scanner_destroy(&streamed);
+    source_stream_destroy(&stream);
+    close(fd);
+    line_index_destroy(&lines);
+    scanner_destroy(&scanner);
+    return capacity;
+}
+
+#pragma endregion
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_source_stream);
+    RUN_TEST(test_source_stream_large);
+    RUN_TEST(test_source_stream_read_error);
+    RUN_TEST(test_source_stream_line_too_long);
+    return UNITY_END();
+}
\ No newline at end of file
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "scanner.h"
+#include "token_buffer.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+static const char *const sources[] = {
+    "",
+    "1 + 2;",
+    "\n\n  1\n",
+    "fun add(x, y) {\n return x + y; // sum\n }\n",
+    "// only a comment",
+    "print \"multi\nline\nstring\" + \"\" + \"\nleading\";\n\n\nvar x = 1.5;",
+    "(((-1)))\n*\n2\n/\n// comment\n3",
+};
+
+void test_token_buffer_matches_scanner(void) {
+    int num_sources = sizeof(sources) / sizeof(sources[0]);
+    TokenBuffer tokens;
+    token_buffer_init(&tokens, &t.alloc);
+    for (int test = 0; test < num_sources; test++) {
+        const char *source = sources[test];
+        token_buffer_tokenize(&tokens, source);
+
+        Scanner scanner;
+        LineIndex lines;
+        scanner_init(&scanner, &t.alloc, source);
+        line_index_init(&lines, &t.alloc, source, strlen(source));
+        size_t index = 0;
+        for (;;) {
+            Token expected = scanner_scan(&scanner);
+            if (expected.type == TOKEN_COMMENT) {
+                continue;
+            }
+            TEST_ASSERT_TRUE_MESSAGE(index < tokens.count, source);
+            Token actual = token_buffer_get(&tokens, index);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(expected.type, actual.type, source);
+            TEST_ASSERT_TRUE_MESSAGE(expected.start == actual.start, source);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(expected.length, actual.length, source);
+            TEST_ASSERT_EQUAL_INT_MESSAGE(line_index_line(&lines, expected.start - source),
+                                          token_buffer_line(&tokens, index), source);
+            index++;
+            if (expected.type == TOKEN_EOF) {
+                break;
+            }
+        }
+        TEST_ASSERT_EQUAL_size_t(index, tokens.count);
+        line_index_destroy(&lines);
+        scanner_destroy(&scanner);
+    }
+    token_buffer_destroy(&tokens);
+}
+
+// Lines looked up out of order, and far apart, match those found walking forwards.
+void test_token_buffer_lines(void) {
+    char source[4096];
+    size_t length = 0;
+    for (int i = 0; i < 500; i++) {
+        length += (size_t)sprintf(source + length, i % 3 == 0 ? "%d\n" : "%d + ", i);
+    }
+    TokenBuffer tokens;
+    token_buffer_init(&tokens, &t.alloc);
+    token_buffer_tokenize(&tokens, source);
+
+    int lines[1024];
+    TEST_ASSERT_TRUE(tokens.count <= 1024);
+    for (size_t i = 0; i < tokens.count; i++) {
+        lines[i] = token_buffer_line(&tokens, i);
+        TEST_ASSERT_TRUE(i == 0 || lines[i] >= lines[i - 1]);
+    }
+    TEST_ASSERT_EQUAL_INT(168, lines[tokens.count - 1]);
+    for (size_t i = tokens.count; i-- > 0;) {
+        TEST_ASSERT_EQUAL_INT(lines[i], token_buffer_line(&tokens, i));
+    }
+    for (size_t i = 0; i < tokens.count; i++) {
+        size_t index = (i * 7919) % tokens.count;
+        TEST_ASSERT_EQUAL_INT(lines[index], token_buffer_line(&tokens, index));
+    }
+    token_buffer_destroy(&tokens);
+}
+
+void test_token_buffer_error(void) {
+    TokenBuffer tokens;
+    token_buffer_init(&tokens, &t.alloc);
+    const char *source = "1 +\n@ 2 3";
+    token_buffer_tokenize(&tokens, source);
+
+    TEST_ASSERT_EQUAL_size_t(4, tokens.count);
+    TEST_ASSERT_EQUAL_INT(TOKEN_NUMBER, tokens.types[0]);
+    TEST_ASSERT_EQUAL_INT(TOKEN_PLUS, tokens.types[1]);
+    Token error = token_buffer_get(&tokens, 2);
+    TEST_ASSERT_EQUAL_INT(TOKEN_ERROR, error.type);
+    TEST_ASSERT_TRUE(error.start == source + 4);
+    TEST_ASSERT_EQUAL_STRING("Unexpected character '@'", tokens.error);
+    TEST_ASSERT_EQUAL_INT(2, token_buffer_line(&tokens, 2));
+    // tokenizing stops at the first error
+    TEST_ASSERT_EQUAL_INT(TOKEN_EOF, token_buffer_get(&tokens, 3).type);
+    token_buffer_destroy(&tokens);
+}
+
+// Writes about `size` bytes of code whose strings span lines and hold comment markers, and whose
+// comments hold quotes, so that segment boundaries are only safe at some newlines.
+static char *write_source(size_t size, const char *insert) {
+    static const char *const lines[] = {
+        "var x = 1.5 * (y - 2); // a \"quoted\" comment\n",
+        "print \"a string // not a comment\n",
+        "   spanning lines\n\n\" + z;\n",
+        "\n",
+        "fun f(a, b) { return a / b; }\n",
+    };
+    char *source = (char *)allocator_alloc(&t.alloc, size + 256);
+    size_t length = 0;
+    for (int i = 0; length < size; i++) {
+        if (insert != NULL && length >= size / 2) {
+            length += (size_t)sprintf(source + length, "%s", insert);
+            insert = NULL;
+        }
+        length += (size_t)sprintf(source + length, "%s", lines[i % 5]);
+    }
+    return source;
+}
+
+void test_token_buffer_parallel(void) {
+    static const char *const inserts[] = { NULL, "1 @ 2\n", "\"unterminated\n" };
+    int thread_counts[] = { 1, 2, 3, 8 };
+    for (int test = 0; test < (int)(sizeof(inserts) / sizeof(inserts[0])); test++) {
+        char *source = write_source(1024 * 1024, inserts[test]);
+        TokenBuffer expected, actual;
+        token_buffer_init(&expected, &t.alloc);
+        token_buffer_init(&actual, &t.alloc);
+        token_buffer_tokenize(&expected, source);
+        TEST_ASSERT_EQUAL_INT(test == 0 ? TOKEN_EOF : TOKEN_ERROR,
+                              expected.types[expected.count - 2 + (test == 0)]);
+
+        for (int i = 0; i < (int)(sizeof(thread_counts) / sizeof(thread_counts[0])); i++) {
+            token_buffer_tokenize_parallel(&actual, source, thread_counts[i]);
+            TEST_ASSERT_EQUAL_size_t(expected.count, actual.count);
+            TEST_ASSERT_EQUAL_MEMORY(expected.types, actual.types, expected.count);
+            TEST_ASSERT_EQUAL_MEMORY(expected.offsets, actual.offsets,
+                                     expected.count * sizeof(uint32_t));
+            TEST_ASSERT_EQUAL_MEMORY(expected.lengths, actual.lengths,
+                                     expected.count * sizeof(uint32_t));
+            for (size_t index = 0; index < expected.count; index += 97) {
+                TEST_ASSERT_EQUAL_INT(token_buffer_line(&expected, index),
+                                      token_buffer_line(&actual, index));
+            }
+            size_t last = expected.count - 2;
+            TEST_ASSERT_EQUAL_INT(token_buffer_line(&expected, last),
+                                  token_buffer_line(&actual, last));
+            if (expected.error != NULL) {
+                TEST_ASSERT_EQUAL_STRING(expected.error, actual.error);
+            }
+        }
+        token_buffer_destroy(&expected);
+        token_buffer_destroy(&actual);
+        allocator_free(&t.alloc, source);
+    }
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_token_buffer_matches_scanner);
+    RUN_TEST(test_token_buffer_lines);
+    RUN_TEST(test_token_buffer_error);
+    RUN_TEST(test_token_buffer_parallel);
+    return UNITY_END();
+}
\ No newline at end of file
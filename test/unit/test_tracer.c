@@ -0,0 +1,123 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "tracer.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+static uint32_t read_u32(const uint8_t *bytes) {
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t read_u64(const uint8_t *bytes) {
+    return read_u32(bytes) | (uint64_t)read_u32(bytes + 4) << 32;
+}
+
+void test_tracer_record(void) {
+    Tracer tracer;
+    tracer_init(&tracer, &t.alloc, 4);
+    Value stack[] = { NUMBER_VAL(1.5), BOOL_VAL(true), NIL_VAL };
+
+    tracer_record(&tracer, 0, OP_CONSTANT, stack, stack);
+    tracer_record(&tracer, 2, OP_CONSTANT, stack, stack + 1);
+    tracer_record(&tracer, 4, OP_ADD, stack, stack + 2);
+    tracer_record(&tracer, 5, OP_RETURN, stack, stack + 3);
+
+    TEST_ASSERT_EQUAL_UINT64(4, tracer.total);
+    TEST_ASSERT_EQUAL_INT(TRACE_STACK_EMPTY, tracer.records[0].top_type);
+    TEST_ASSERT_EQUAL_INT(0, tracer.records[0].depth);
+    TEST_ASSERT_EQUAL_INT(TRACE_NUMBER, tracer.records[1].top_type);
+    double number;
+    memcpy(&number, &tracer.records[1].top, sizeof(number));
+    TEST_ASSERT_TRUE(number == 1.5);
+    TEST_ASSERT_EQUAL_INT(TRACE_BOOL, tracer.records[2].top_type);
+    TEST_ASSERT_EQUAL_UINT64(1, tracer.records[2].top);
+    TEST_ASSERT_EQUAL_INT(TRACE_NIL, tracer.records[3].top_type);
+    TEST_ASSERT_EQUAL_INT(3, tracer.records[3].depth);
+    TEST_ASSERT_EQUAL_INT(OP_RETURN, tracer.records[3].opcode);
+    TEST_ASSERT_EQUAL_UINT32(5, tracer.records[3].offset);
+
+    // the ring wraps around, overwriting the oldest record
+    tracer_record(&tracer, 6, OP_NEGATE, stack, stack + 1);
+    TEST_ASSERT_EQUAL_UINT64(5, tracer.total);
+    TEST_ASSERT_EQUAL_UINT32(6, tracer.records[0].offset);
+
+    tracer_destroy(&tracer);
+}
+
+void test_tracer_dump(void) {
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(1), 1);
+    OpCodeChunk_write_code(&chunk, OP_NEGATE, 2);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 2);
+
+    Tracer tracer;
+    tracer_init(&tracer, &t.alloc, 2);
+    Value stack[] = { NUMBER_VAL(1) };
+    tracer_record(&tracer, 0, OP_CONSTANT, stack, stack);
+    tracer_record(&tracer, 2, OP_NEGATE, stack, stack + 1);
+    tracer_record(&tracer, 3, OP_RETURN, stack, stack + 1);
+
+    char *data = NULL;
+    size_t size = 0;
+    FILE *out = open_memstream(&data, &size);
+    TEST_ASSERT_TRUE(tracer_dump(&tracer, &chunk, out));
+    fclose(out);
+
+    const uint8_t *bytes = (const uint8_t *)data;
+    TEST_ASSERT_EQUAL_MEMORY(TRACE_FORMAT_MAGIC, bytes, 8);
+    TEST_ASSERT_EQUAL_UINT32(TRACE_FORMAT_VERSION, read_u32(bytes + 8));
+    TEST_ASSERT_EQUAL_UINT32(16, read_u32(bytes + 12));
+    TEST_ASSERT_EQUAL_UINT64(3, read_u64(bytes + 16));
+    TEST_ASSERT_EQUAL_UINT32(2, read_u32(bytes + 24));
+    TEST_ASSERT_EQUAL_UINT32(NUM_OPCODES, read_u32(bytes + 28));
+
+    size_t position = 32;
+    for (int code = 0; code < NUM_OPCODES; code++) {
+        size_t length = bytes[position];
+        TEST_ASSERT_EQUAL_size_t(strlen(opcode_name(code)), length);
+        TEST_ASSERT_EQUAL_MEMORY(opcode_name(code), bytes + position + 1, length);
+        position += 1 + length;
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, read_u32(bytes + position));
+    TEST_ASSERT_EQUAL_UINT32(1, read_u32(bytes + position + 4));  // line 1
+    TEST_ASSERT_EQUAL_UINT32(2, read_u32(bytes + position + 8));  // 2 bytes
+    TEST_ASSERT_EQUAL_UINT32(2, read_u32(bytes + position + 12)); // line 2
+    TEST_ASSERT_EQUAL_UINT32(2, read_u32(bytes + position + 16)); // 2 bytes
+    position += 20;
+
+    // the two most recent records, oldest first
+    TEST_ASSERT_EQUAL_size_t(position + 2 * 16, size);
+    TEST_ASSERT_EQUAL_UINT32(2, read_u32(bytes + position));
+    TEST_ASSERT_EQUAL_INT(OP_NEGATE, bytes[position + 4]);
+    TEST_ASSERT_EQUAL_INT(TRACE_NUMBER, bytes[position + 5]);
+    TEST_ASSERT_EQUAL_UINT32(3, read_u32(bytes + position + 16));
+    TEST_ASSERT_EQUAL_INT(OP_RETURN, bytes[position + 20]);
+
+    free(data);
+    tracer_destroy(&tracer);
+    opcode_chunk_destroy(&chunk);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_tracer_record);
+    RUN_TEST(test_tracer_dump);
+    return UNITY_END();
+}
\ No newline at end of file
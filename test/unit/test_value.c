@@ -0,0 +1,101 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "value.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_value_size(void) {
+#ifndef VALUE_TAGGED_UNION
+    TEST_ASSERT_EQUAL_size_t(8, sizeof(Value));
+#endif
+}
+
+void test_value_box(void) {
+    struct {
+        const char *name;
+        Value value;
+        ValueType type;
+        const char *repr;
+    } test_cases[] = {
+        { .name = "nil", .value = NIL_VAL, .type = VAL_NIL, .repr = "Value(nil)" },
+        { .name = "true", .value = BOOL_VAL(true), .type = VAL_BOOL, .repr = "Value(true)" },
+        { .name = "false", .value = BOOL_VAL(false), .type = VAL_BOOL, .repr = "Value(false)" },
+        { .name = "zero", .value = NUMBER_VAL(0), .type = VAL_NUMBER, .repr = "Value(0)" },
+        { .name = "negative zero", .value = NUMBER_VAL(-0.0), .type = VAL_NUMBER,
+          .repr = "Value(-0)" },
+        { .name = "number", .value = NUMBER_VAL(1.5), .type = VAL_NUMBER, .repr = "Value(1.5)" },
+        { .name = "infinity", .value = NUMBER_VAL(INFINITY), .type = VAL_NUMBER,
+          .repr = "Value(inf)" },
+        { .name = "nan", .value = NUMBER_VAL(NAN), .type = VAL_NUMBER, .repr = "Value(nan)" },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+        Value value = test_cases[test].value;
+
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].type, value_type(value), name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].type == VAL_NIL, IS_NIL(value), name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].type == VAL_BOOL, IS_BOOL(value), name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].type == VAL_NUMBER, IS_NUMBER(value), name);
+
+        String *repr = value_repr(value, string_create(&t.alloc, 1), &t.alloc);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(test_cases[test].repr, string_cstr(repr), name);
+        string_destroy(repr, &t.alloc);
+    }
+}
+
+void test_value_unbox(void) {
+    double numbers[] = { 0, 1, -1, 0.1, 1e308, -1e-308, 4.9e-324, INFINITY, -INFINITY };
+    int num_numbers = sizeof(numbers) / sizeof(numbers[0]);
+    for (int i = 0; i < num_numbers; i++) {
+        Value value = NUMBER_VAL(numbers[i]);
+        TEST_ASSERT_TRUE(IS_NUMBER(value));
+        TEST_ASSERT_TRUE(AS_NUMBER(value) == numbers[i]);
+    }
+    TEST_ASSERT_TRUE(AS_BOOL(BOOL_VAL(true)));
+    TEST_ASSERT_FALSE(AS_BOOL(BOOL_VAL(false)));
+
+    // NaNs produced by arithmetic must still be numbers
+    Value nan = NUMBER_VAL(AS_NUMBER(NUMBER_VAL(0)) / AS_NUMBER(NUMBER_VAL(0)));
+    TEST_ASSERT_TRUE(IS_NUMBER(nan));
+    TEST_ASSERT_TRUE(isnan(AS_NUMBER(nan)));
+
+    TEST_ASSERT_TRUE(ARE_NUMBERS(NUMBER_VAL(1), NUMBER_VAL(2)));
+    TEST_ASSERT_FALSE(ARE_NUMBERS(NUMBER_VAL(1), NIL_VAL));
+    TEST_ASSERT_FALSE(ARE_NUMBERS(BOOL_VAL(true), NUMBER_VAL(2)));
+}
+
+void test_values_equal(void) {
+    TEST_ASSERT_TRUE(values_equal(NIL_VAL, NIL_VAL));
+    TEST_ASSERT_TRUE(values_equal(BOOL_VAL(true), BOOL_VAL(true)));
+    TEST_ASSERT_TRUE(values_equal(NUMBER_VAL(2), NUMBER_VAL(2)));
+    TEST_ASSERT_TRUE(values_equal(NUMBER_VAL(0.0), NUMBER_VAL(-0.0)));
+    TEST_ASSERT_FALSE(values_equal(NUMBER_VAL(NAN), NUMBER_VAL(NAN)));
+    TEST_ASSERT_FALSE(values_equal(BOOL_VAL(true), BOOL_VAL(false)));
+    TEST_ASSERT_FALSE(values_equal(NIL_VAL, BOOL_VAL(false)));
+    TEST_ASSERT_FALSE(values_equal(NUMBER_VAL(0), BOOL_VAL(false)));
+    TEST_ASSERT_FALSE(values_equal(NUMBER_VAL(0), NIL_VAL));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_value_size);
+    RUN_TEST(test_value_box);
+    RUN_TEST(test_value_unbox);
+    RUN_TEST(test_values_equal);
+    return UNITY_END();
+}
\ No newline at end of file
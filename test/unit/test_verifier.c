@@ -0,0 +1,176 @@
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "verifier.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+void test_verify(void) {
+    struct {
+        const char *name;
+        int num_codes;
+        uint8_t codes[16];
+        int num_constants;
+        int stack_limit;
+        VerifyResult result;
+        int offset;
+        int max_stack_depth;
+    } test_cases[] = {
+        { .name = "return constant",
+          .num_codes = 3,
+          .codes = { OP_CONSTANT, 0, OP_RETURN },
+          .num_constants = 1,
+          .stack_limit = 256,
+          .result = VERIFY_OK,
+          .offset = -1,
+          .max_stack_depth = 1 },
+        { .name = "binary expression",
+          .num_codes = 8,
+          .codes = { OP_CONSTANT, 0, OP_CONSTANT, 1, OP_CONSTANT, 0, OP_MULTIPLY, OP_ADD },
+          .num_constants = 2,
+          .stack_limit = 256,
+          .result = VERIFY_MISSING_RETURN,
+          .offset = 8,
+          .max_stack_depth = 3 },
+        { .name = "nested expression",
+          .num_codes = 10,
+          .codes = { OP_CONSTANT, 0, OP_CONSTANT, 1, OP_CONSTANT, 0, OP_MULTIPLY, OP_ADD,
+                     OP_NEGATE, OP_RETURN },
+          .num_constants = 2,
+          .stack_limit = 256,
+          .result = VERIFY_OK,
+          .offset = -1,
+          .max_stack_depth = 3 },
+        { .name = "empty chunk",
+          .num_codes = 0,
+          .codes = { 0 },
+          .num_constants = 0,
+          .stack_limit = 256,
+          .result = VERIFY_MISSING_RETURN,
+          .offset = 0,
+          .max_stack_depth = 0 },
+        { .name = "underflow",
+          .num_codes = 4,
+          .codes = { OP_CONSTANT, 0, OP_ADD, OP_RETURN },
+          .num_constants = 1,
+          .stack_limit = 256,
+          .result = VERIFY_STACK_UNDERFLOW,
+          .offset = 2,
+          .max_stack_depth = 1 },
+        { .name = "overflow",
+          .num_codes = 6,
+          .codes = { OP_CONSTANT, 0, OP_CONSTANT, 0, OP_CONSTANT, 0 },
+          .num_constants = 1,
+          .stack_limit = 2,
+          .result = VERIFY_STACK_OVERFLOW,
+          .offset = 4,
+          .max_stack_depth = 3 },
+        { .name = "invalid constant",
+          .num_codes = 3,
+          .codes = { OP_CONSTANT, 1, OP_RETURN },
+          .num_constants = 1,
+          .stack_limit = 256,
+          .result = VERIFY_INVALID_CONSTANT,
+          .offset = 0,
+          .max_stack_depth = 0 },
+        { .name = "truncated long constant",
+          .num_codes = 3,
+          .codes = { OP_CONSTANT_LONG, 0, 0 },
+          .num_constants = 1,
+          .stack_limit = 256,
+          .result = VERIFY_TRUNCATED_INSTRUCTION,
+          .offset = 0,
+          .max_stack_depth = 0 },
+        { .name = "unknown opcode",
+          .num_codes = 2,
+          .codes = { 0xFF, OP_RETURN },
+          .num_constants = 0,
+          .stack_limit = 256,
+          .result = VERIFY_UNKNOWN_OPCODE,
+          .offset = 0,
+          .max_stack_depth = 0 },
+        { .name = "quickened opcode",
+          .num_codes = 6,
+          .codes = { OP_CONSTANT, 0, OP_CONSTANT, 0, OP_ADD_NUM, OP_RETURN },
+          .num_constants = 1,
+          .stack_limit = 256,
+          .result = VERIFY_UNKNOWN_OPCODE,
+          .offset = 4,
+          .max_stack_depth = 2 },
+        { .name = "unreachable code after return",
+          .num_codes = 5,
+          .codes = { OP_CONSTANT, 0, OP_RETURN, OP_ADD, 0xFF },
+          .num_constants = 1,
+          .stack_limit = 256,
+          .result = VERIFY_OK,
+          .offset = -1,
+          .max_stack_depth = 1 },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    OpCodeChunk chunk;
+    Verification verification;
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+
+        opcode_chunk_init(&chunk, &t.alloc);
+        for (int i = 0; i < test_cases[test].num_constants; i++) {
+            value_write(&chunk.constants, NUMBER_VAL(i));
+        }
+        // write raw bytes since malformed chunks can't be produced through the chunk API
+        vector_extend(&chunk.codes.codes, test_cases[test].codes, test_cases[test].num_codes);
+
+        VerifyResult result = verify_chunk(&chunk, test_cases[test].stack_limit, &verification);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].result, result, name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].result, verification.result, name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].offset, verification.offset, name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].max_stack_depth,
+                                      verification.max_stack_depth, name);
+
+        opcode_chunk_destroy(&chunk);
+    }
+}
+
+void test_verify_constants(void) {
+    OpCodeChunk chunk;
+    Verification verification;
+    opcode_chunk_init(&chunk, &t.alloc);
+
+    // enough constants to spill over into OP_CONSTANT_LONG
+    int num_constants = 300;
+    for (int i = 0; i < num_constants; i++) {
+        OpCodeChunk_write_constant(&chunk, NUMBER_VAL(i), 1);
+    }
+    for (int i = 1; i < num_constants; i++) {
+        OpCodeChunk_write_code(&chunk, OP_ADD, 1);
+    }
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+
+    TEST_ASSERT_EQUAL_INT(VERIFY_OK, verify_chunk(&chunk, 512, &verification));
+    TEST_ASSERT_EQUAL_INT(num_constants, verification.max_stack_depth);
+    TEST_ASSERT_EQUAL_INT(vector_len(&chunk.codes.codes), verification.code_length);
+    TEST_ASSERT_EQUAL_INT(2 * num_constants, verification.num_instructions);
+
+    TEST_ASSERT_EQUAL_INT(VERIFY_STACK_OVERFLOW, verify_chunk(&chunk, 256, &verification));
+
+    opcode_chunk_destroy(&chunk);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_verify);
+    RUN_TEST(test_verify_constants);
+    return UNITY_END();
+}
@@ -0,0 +1,379 @@
+#include <stdio.h>
+
+#include "unity.h"
+
+#include "allocator.h"
+#include "helpers.h"
+#include "instruction.h"
+#include "vm.h"
+
+static T t;
+
+void setUp(void) {
+    setup(&t);
+}
+
+void tearDown(void) {
+    teardown(&t);
+}
+
+// Writes a chunk that pushes `depth` constants before summing them, requiring `depth` stack slots.
+static void write_deep_chunk(OpCodeChunk *chunk, int depth) {
+    for (int i = 0; i < depth; i++) {
+        OpCodeChunk_write_constant(chunk, NUMBER_VAL(i), 1);
+    }
+    for (int i = 1; i < depth; i++) {
+        OpCodeChunk_write_code(chunk, OP_ADD, 1);
+    }
+    OpCodeChunk_write_code(chunk, OP_RETURN, 1);
+}
+
+void test_vm_stack_growth(void) {
+    struct {
+        const char *name;
+        int depth;
+        int stack_limit;
+        InterpretResult result;
+    } test_cases[] = {
+        { .name = "fits initial capacity",
+          .depth = STACK_INITIAL_CAPACITY,
+          .stack_limit = DEFAULT_STACK_LIMIT,
+          .result = INTERPRET_OK },
+        { .name = "grows past initial capacity",
+          .depth = STACK_INITIAL_CAPACITY * 20 + 1,
+          .stack_limit = DEFAULT_STACK_LIMIT,
+          .result = INTERPRET_OK },
+        { .name = "exactly at limit",
+          .depth = 100,
+          .stack_limit = 100,
+          .result = INTERPRET_OK },
+        { .name = "beyond limit",
+          .depth = 101,
+          .stack_limit = 100,
+          .result = INTERPRET_RUNTIME_ERROR },
+        { .name = "beyond small limit",
+          .depth = 3,
+          .stack_limit = 2,
+          .result = INTERPRET_RUNTIME_ERROR },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+
+        virtual_machine_init(&vm, &t.alloc);
+        vm.stack_limit = test_cases[test].stack_limit;
+        opcode_chunk_init(&chunk, &t.alloc);
+        write_deep_chunk(&chunk, test_cases[test].depth);
+
+        InterpretResult result = virtual_machine_run(&vm, &chunk);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].result, result, name);
+        TEST_ASSERT_TRUE_MESSAGE(vm.stack.capacity <= test_cases[test].stack_limit
+                                     || vm.stack.capacity == STACK_INITIAL_CAPACITY,
+                                 name);
+        if (result == INTERPRET_OK) {
+            TEST_ASSERT_TRUE_MESSAGE(vm.stack.capacity >= test_cases[test].depth, name);
+        }
+        TEST_ASSERT_TRUE_MESSAGE(vm.stack.top == vm.stack.values, name);
+
+        opcode_chunk_destroy(&chunk);
+        virtual_machine_destroy(&vm);
+    }
+}
+
+void test_vm_stack_limit_lowered(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    LoadedChunk loaded;
+    virtual_machine_init(&vm, &t.alloc);
+    opcode_chunk_init(&chunk, &t.alloc);
+    write_deep_chunk(&chunk, 64);
+
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+    vm.stack_limit = 32;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_RUNTIME_ERROR, virtual_machine_exec_loaded(&vm, &loaded));
+    vm.stack_limit = 64;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &loaded));
+
+    loaded_chunk_destroy(&loaded, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+void test_vm_type_error(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    virtual_machine_init(&vm, &t.alloc);
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(1), 1);
+    OpCodeChunk_write_constant(&chunk, BOOL_VAL(true), 1);
+    OpCodeChunk_write_code(&chunk, OP_ADD, 2);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 2);
+
+    TEST_ASSERT_EQUAL_INT(INTERPRET_RUNTIME_ERROR, virtual_machine_run(&vm, &chunk));
+    TEST_ASSERT_TRUE(vm.stack.top == vm.stack.values);
+
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+void test_vm_input_columns(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_column(&chunk, 1, 1);
+    OpCodeChunk_write_column(&chunk, 0, 1);
+    OpCodeChunk_write_code(&chunk, OP_SUBTRACT, 1);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+
+    double row[] = { 2, 7 };
+    vm.inputs = row;
+    vm.num_inputs = 2;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_run(&vm, &chunk));
+    TEST_ASSERT_TRUE(AS_NUMBER(vm.result) == 5);
+
+    vm.num_inputs = 1;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_RUNTIME_ERROR, virtual_machine_run(&vm, &chunk));
+    TEST_ASSERT_TRUE(vm.stack.top == vm.stack.values);
+
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+void test_vm_fuel(void) {
+    struct {
+        const char *name;
+        int64_t slice;
+        int yields;
+    } test_cases[] = {
+        { .name = "one instruction at a time", .slice = 1, .yields = 39 },
+        { .name = "uneven slices", .slice = 7, .yields = 5 },
+        { .name = "exact budget", .slice = 40, .yields = 0 },
+        { .name = "more than enough", .slice = 1000, .yields = 0 },
+    };
+    int num_test_cases = sizeof(test_cases) / sizeof(test_cases[0]);
+
+    OpCodeChunk chunk;
+    opcode_chunk_init(&chunk, &t.alloc);
+    write_deep_chunk(&chunk, 20); // 40 instructions returning 0 + 1 + ... + 19
+    for (int test = 0; test < num_test_cases; test++) {
+        const char *name = test_cases[test].name;
+        VirtualMachine vm;
+        LoadedChunk loaded;
+        virtual_machine_init(&vm, &t.alloc);
+        vm.output = NULL;
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+
+        vm.fuel = test_cases[test].slice;
+        int yields = 0;
+        InterpretResult result = virtual_machine_exec_loaded(&vm, &loaded);
+        while (result == INTERPRET_YIELD) {
+            TEST_ASSERT_TRUE_MESSAGE(vm.fuel == 0, name);
+            // the yield patched in for the run is taken out when it suspends
+            for (int i = 0; i < loaded.length; i++) {
+                OpCode code = instruction_opcode(&loaded, &loaded.code[i]);
+                TEST_ASSERT_TRUE_MESSAGE(code < NUM_OPCODES, name);
+            }
+            yields++;
+            vm.fuel = test_cases[test].slice;
+            result = virtual_machine_resume(&vm);
+        }
+        TEST_ASSERT_EQUAL_INT_MESSAGE(INTERPRET_OK, result, name);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(test_cases[test].yields, yields, name);
+        TEST_ASSERT_TRUE_MESSAGE(AS_NUMBER(vm.result) == 190, name);
+        TEST_ASSERT_TRUE_MESSAGE(vm.loaded == NULL, name);
+        int64_t left = (test_cases[test].slice - 40 % test_cases[test].slice) % test_cases[test].slice;
+        TEST_ASSERT_TRUE_MESSAGE(vm.fuel == left, name);
+
+        loaded_chunk_destroy(&loaded, &t.alloc);
+        virtual_machine_destroy(&vm);
+    }
+    opcode_chunk_destroy(&chunk);
+}
+
+// Time-slices several runs of different lengths on one thread, as a scheduler would.
+void test_vm_fuel_round_robin(void) {
+    enum { NUM_VMS = 3 };
+    int depths[NUM_VMS] = { 5, 50, 17 };
+    OpCodeChunk chunks[NUM_VMS];
+    LoadedChunk loaded[NUM_VMS];
+    VirtualMachine vms[NUM_VMS];
+    InterpretResult results[NUM_VMS];
+    for (int i = 0; i < NUM_VMS; i++) {
+        opcode_chunk_init(&chunks[i], &t.alloc);
+        write_deep_chunk(&chunks[i], depths[i]);
+        virtual_machine_init(&vms[i], &t.alloc);
+        vms[i].output = NULL;
+        vms[i].fuel = 4;
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vms[i], &chunks[i], &loaded[i]));
+        results[i] = virtual_machine_exec_loaded(&vms[i], &loaded[i]);
+    }
+    for (bool running = true; running;) {
+        running = false;
+        for (int i = 0; i < NUM_VMS; i++) {
+            if (results[i] == INTERPRET_YIELD) {
+                vms[i].fuel = 4;
+                results[i] = virtual_machine_resume(&vms[i]);
+                running = true;
+            }
+        }
+    }
+    for (int i = 0; i < NUM_VMS; i++) {
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, results[i]);
+        TEST_ASSERT_TRUE(AS_NUMBER(vms[i].result) == depths[i] * (depths[i] - 1) / 2);
+        loaded_chunk_destroy(&loaded[i], &t.alloc);
+        opcode_chunk_destroy(&chunks[i]);
+        virtual_machine_destroy(&vms[i]);
+    }
+}
+
+void test_vm_fuel_abandon(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    opcode_chunk_init(&chunk, &t.alloc);
+    write_deep_chunk(&chunk, 10);
+
+    // virtual_machine_run owns its loaded chunk, so running out of fuel abandons the run
+    vm.fuel = 5;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_YIELD, virtual_machine_run(&vm, &chunk));
+    TEST_ASSERT_TRUE(vm.loaded == NULL);
+    TEST_ASSERT_TRUE(vm.stack.top == vm.stack.values);
+    vm.fuel = FUEL_UNLIMITED;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_run(&vm, &chunk));
+    TEST_ASSERT_TRUE(AS_NUMBER(vm.result) == 45);
+    // and so does interpret(), which runs through it
+    vm.fuel = 2;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_YIELD, interpret(&vm, "1 + 2 + 3"));
+    TEST_ASSERT_TRUE(vm.loaded == NULL);
+
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+// A run of virtual_machine_exec_loaded stays suspended on the caller's loaded chunk until resumed.
+void test_vm_fuel_resume_loaded(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    LoadedChunk loaded;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    opcode_chunk_init(&chunk, &t.alloc);
+    write_deep_chunk(&chunk, 10); // 10 constants, 9 adds and a return
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+
+    vm.fuel = 5;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_YIELD, virtual_machine_exec_loaded(&vm, &loaded));
+    TEST_ASSERT_TRUE(vm.loaded == &loaded);
+    TEST_ASSERT_TRUE(vm.ip == &loaded.code[5]);
+    TEST_ASSERT_TRUE(loaded.stop == NULL);
+
+    // While a run has a yield patched over an instruction, its opcode is the one the patch saved.
+    // Stand in for the patch with another instruction's dispatch.
+    loaded.stopped = loaded.code[12];
+    loaded.stop = &loaded.code[12];
+    loaded.code[12] = loaded.code[0];
+    TEST_ASSERT_EQUAL_INT(OP_ADD, instruction_opcode(&loaded, &loaded.code[12]));
+    TEST_ASSERT_EQUAL_INT(OP_CONSTANT, instruction_opcode(&loaded, &loaded.code[0]));
+    loaded.code[12] = loaded.stopped;
+    loaded.stop = NULL;
+
+    vm.fuel = FUEL_UNLIMITED;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_resume(&vm));
+    TEST_ASSERT_TRUE(AS_NUMBER(vm.result) == 45);
+
+    loaded_chunk_destroy(&loaded, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+void test_vm_quickening(void) {
+    VirtualMachine vm;
+    OpCodeChunk chunk;
+    LoadedChunk loaded;
+    virtual_machine_init(&vm, &t.alloc);
+    vm.output = NULL;
+    opcode_chunk_init(&chunk, &t.alloc);
+    // -((6 - 3) * 2) + 4) / 2
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(6), 1);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(3), 1);
+    OpCodeChunk_write_code(&chunk, OP_SUBTRACT, 1);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(2), 1);
+    OpCodeChunk_write_code(&chunk, OP_MULTIPLY, 1);
+    OpCodeChunk_write_code(&chunk, OP_NEGATE, 1);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(4), 1);
+    OpCodeChunk_write_code(&chunk, OP_ADD, 1);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(2), 1);
+    OpCodeChunk_write_code(&chunk, OP_DIVIDE, 1);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+    OpCode generic[] = { OP_CONSTANT, OP_CONSTANT, OP_SUBTRACT, OP_CONSTANT, OP_MULTIPLY, OP_NEGATE,
+                         OP_CONSTANT, OP_ADD,      OP_CONSTANT, OP_DIVIDE,   OP_RETURN };
+    OpCode quickened[] = { OP_CONSTANT, OP_CONSTANT,     OP_SUBTRACT_NUM, OP_CONSTANT,
+                           OP_MULTIPLY_NUM, OP_NEGATE_NUM, OP_CONSTANT,   OP_ADD_NUM,
+                           OP_CONSTANT, OP_DIVIDE_NUM,   OP_RETURN };
+    int length = sizeof(generic) / sizeof(generic[0]);
+
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+    TEST_ASSERT_EQUAL_INT(length, loaded.length);
+    for (int i = 0; i < length; i++) {
+        TEST_ASSERT_EQUAL_INT(generic[i], instruction_opcode(&loaded, &loaded.code[i]));
+    }
+    // the first run quickens every arithmetic instruction, and later runs use the quickened forms
+    for (int run = 0; run < 2; run++) {
+        TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &loaded));
+        TEST_ASSERT_TRUE(AS_NUMBER(vm.result) == -1);
+        for (int i = 0; i < length; i++) {
+            TEST_ASSERT_EQUAL_INT(quickened[i], instruction_opcode(&loaded, &loaded.code[i]));
+        }
+    }
+
+    // A site that later sees another type (as a variable could) deoptimises and reports the error
+    // exactly as the generic instruction does.
+    loaded.code[1].operand = BOOL_VAL(true);
+    TEST_ASSERT_EQUAL_INT(INTERPRET_RUNTIME_ERROR, virtual_machine_exec_loaded(&vm, &loaded));
+    TEST_ASSERT_EQUAL_INT(OP_SUBTRACT, instruction_opcode(&loaded, &loaded.code[2]));
+    TEST_ASSERT_EQUAL_INT(OP_MULTIPLY_NUM, instruction_opcode(&loaded, &loaded.code[4]));
+    TEST_ASSERT_TRUE(vm.stack.top == vm.stack.values);
+    // and quickens again once it sees numbers
+    loaded.code[1].operand = NUMBER_VAL(3);
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &loaded));
+    TEST_ASSERT_TRUE(AS_NUMBER(vm.result) == -1);
+    TEST_ASSERT_EQUAL_INT(OP_SUBTRACT_NUM, instruction_opcode(&loaded, &loaded.code[2]));
+
+    loaded_chunk_destroy(&loaded, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+
+    opcode_chunk_init(&chunk, &t.alloc);
+    OpCodeChunk_write_constant(&chunk, NUMBER_VAL(1), 1);
+    OpCodeChunk_write_code(&chunk, OP_NEGATE, 1);
+    OpCodeChunk_write_code(&chunk, OP_RETURN, 1);
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_load(&vm, &chunk, &loaded));
+    TEST_ASSERT_EQUAL_INT(INTERPRET_OK, virtual_machine_exec_loaded(&vm, &loaded));
+    TEST_ASSERT_EQUAL_INT(OP_NEGATE_NUM, instruction_opcode(&loaded, &loaded.code[1]));
+    loaded.code[0].operand = NIL_VAL;
+    TEST_ASSERT_EQUAL_INT(INTERPRET_RUNTIME_ERROR, virtual_machine_exec_loaded(&vm, &loaded));
+    TEST_ASSERT_EQUAL_INT(OP_NEGATE, instruction_opcode(&loaded, &loaded.code[1]));
+
+    loaded_chunk_destroy(&loaded, &t.alloc);
+    opcode_chunk_destroy(&chunk);
+    virtual_machine_destroy(&vm);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_vm_stack_growth);
+    RUN_TEST(test_vm_stack_limit_lowered);
+    RUN_TEST(test_vm_type_error);
+    RUN_TEST(test_vm_input_columns);
+    RUN_TEST(test_vm_fuel);
+    RUN_TEST(test_vm_fuel_round_robin);
+    RUN_TEST(test_vm_fuel_abandon);
+    RUN_TEST(test_vm_fuel_resume_loaded);
+    RUN_TEST(test_vm_quickening);
+    return UNITY_END();
+}
\ No newline at end of file
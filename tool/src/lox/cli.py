@@ -1,7 +1,9 @@
 import argparse
+import pathlib
 
 from lox.config import Config, load_config
 from lox.test import TestRunner
+from lox.trace import Trace
 
 
 def main() -> None:
@@ -27,23 +29,44 @@ def main() -> None:
         nargs="+",
         help="Path to a test program",
     )
+    parser_test.add_argument(
+        "--compare",
+        type=str,
+        action="append",
+        metavar="ARG",
+        help="Also run each test with ARG (e.g. --compare=--jit) and require identical output",
+    )
     parser_test.set_defaults(func=test)
 
+    parser_trace = subparsers.add_parser("trace")
+    parser_trace.add_argument(
+        "path",
+        type=pathlib.Path,
+        help="Path to an execution trace written by clox --exec-trace",
+    )
+    parser_trace.set_defaults(func=trace)
+
     args = parser.parse_args()
-    args.func(args, load_config())
+    args.func(args)
 
 
-def test(args: argparse.Namespace, config: Config) -> None:
+def test(args: argparse.Namespace) -> None:
+    config: Config = load_config()
     if args.test:
         tests = [test for tests in args.test for test in tests]
     else:
         tests = [path for path in (config.root_dir / "test" / "lox").rglob("*.lox")]
 
-    runner = TestRunner(program=args.program, tests=tests)
+    runner = TestRunner(program=args.program, tests=tests, compare_args=args.compare)
     for result in runner.run():
         result.ansi_color = True
         print(result)
 
 
+def trace(args: argparse.Namespace) -> None:
+    for line in Trace.from_file(args.path).render():
+        print(line)
+
+
 if __name__ == "__main__":
     main()
@@ -12,36 +12,70 @@ class TestRunner:
         program: str,
         tests: list[str],
         max_workers: int = MAX_WORKERS,
+        compare_args: list[str] | None = None,
     ) -> None:
         self.program = program
         self.tests = tests
         self.max_workers = max_workers
+        self.compare_args = compare_args
 
     def run(self) -> list["Result"]:
+        """
+        Runs every test. When compare_args are given each test is also run with those extra
+        arguments (e.g. --jit) and fails unless both runs produce identical output and exit codes.
+        """
         with ThreadPoolExecutor(max_workers=self.max_workers) as executor:
-            futures = [
-                executor.submit(execute, Request(program=self.program, test=test))
-                for test in self.tests
-            ]
+            if self.compare_args is None:
+                futures = [
+                    executor.submit(execute, Request(program=self.program, test=test))
+                    for test in self.tests
+                ]
+            else:
+                futures = [
+                    executor.submit(
+                        compare,
+                        Request(program=self.program, test=test),
+                        Request(program=self.program, test=test, args=self.compare_args),
+                    )
+                    for test in self.tests
+                ]
         return [future.result() for future in as_completed(futures)]
 
 
 def execute(request: "Request") -> "Result":
+    result, _ = run(request)
+    return result
+
+
+def compare(baseline: "Request", candidate: "Request") -> "Result":
+    result, baseline_output = run(baseline)
+    if result.error is not None:
+        return result
+    candidate_result, candidate_output = run(candidate)
+    if candidate_result.error is not None:
+        return candidate_result
+    if baseline_output != candidate_output:
+        args = " ".join(candidate.args)
+        result.failure = f"Output with {args} differs from output without it"
+    return result
+
+
+def run(request: "Request") -> tuple["Result", tuple[int, bytes, bytes] | None]:
     result = Result(str(request.test_path))
     if not request.program_path.exists():
         result.error = FileNotFoundError(
             f"Program file not found: {request.program_path}"
         )
-        return result
+        return result, None
 
     if not request.test_path.exists():
         result.error = FileNotFoundError(f"Test file not found: {request.test_path}")
-        return result
+        return result, None
 
-    test = Test(path=request.test_path)
+    test = Test(path=request.test_path, args=request.args)
 
     proc = subprocess.Popen(
-        [request.program_path, test.path, *test.args],
+        [request.program_path, *test.args, test.path],
         stdin=subprocess.PIPE,
         stdout=subprocess.PIPE,
         stderr=subprocess.PIPE,
@@ -54,7 +88,7 @@ def execute(request: "Request") -> "Result":
     except subprocess.TimeoutExpired as ex:
         proc.kill()
         result.error = ex
-        return result
+        return result, None
 
     result = test.verify(
         result=result,
@@ -62,7 +96,7 @@ def execute(request: "Request") -> "Result":
         stdout=stdout,
         stderr=stderr,
     )
-    return result
+    return result, (proc.returncode, stdout, stderr)
 
 
 class Test:
@@ -107,16 +141,19 @@ class Request:
         program: str,
         test: str,
         timeout_seconds: int = TIMEOUT_SECONDS,
+        args: list[str] | None = None,
     ) -> None:
         self.program_path = pathlib.Path(program)
         self.test_path = pathlib.Path(test)
         self.timeout_seconds = timeout_seconds
+        self.args = args if args is not None else []
 
     def __repr__(self) -> str:
         return (
             f"Request(program_path={self.program_path}, "
             f"test_path={self.test_path}, "
-            f"timeout_seconds={self.timeout_seconds})"
+            f"timeout_seconds={self.timeout_seconds}, "
+            f"args={self.args})"
         )
 
 
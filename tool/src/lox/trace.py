@@ -0,0 +1,142 @@
+import pathlib
+import struct
+import typing
+
+
+class TraceFormatError(Exception):
+    pass
+
+
+class LineTable:
+    def __init__(self, encodings: list[tuple[int, int]]) -> None:
+        self.encodings = encodings
+
+    def line_for(self, offset: int) -> int:
+        for line, size_count in self.encodings:
+            if offset < size_count:
+                return line
+            offset -= size_count
+        return -1
+
+
+class Record:
+    STACK_EMPTY = 0
+    NIL = 1
+    BOOL = 2
+    NUMBER = 3
+
+    def __init__(self, offset: int, opcode: int, top_type: int, depth: int, top: int) -> None:
+        self.offset = offset
+        self.opcode = opcode
+        self.top_type = top_type
+        self.depth = depth
+        self.top = top
+
+    def __repr__(self) -> str:
+        return (
+            f"Record(offset={self.offset}, opcode={self.opcode}, "
+            f"top_type={self.top_type}, depth={self.depth}, top={self.top})"
+        )
+
+    def top_repr(self) -> str:
+        match self.top_type:
+            case self.STACK_EMPTY:
+                return "<empty>"
+            case self.NIL:
+                return "nil"
+            case self.BOOL:
+                return "true" if self.top else "false"
+            case self.NUMBER:
+                (number,) = struct.unpack("<d", struct.pack("<Q", self.top))
+                return f"{number:g}"
+            case _:
+                return f"<unknown type {self.top_type}>"
+
+
+class Trace:
+    """
+    An execution trace dumped by clox (see tracer_dump in src/tracer.c).
+    """
+
+    MAGIC = b"LOXTRACE"
+    VERSION = 1
+    RECORD = struct.Struct("<IBBHQ")
+    HEADER = struct.Struct("<8sIIQII")
+
+    def __init__(
+        self,
+        total: int,
+        opcodes: list[str],
+        lines: LineTable,
+        records: list[Record],
+    ) -> None:
+        self.total = total
+        self.opcodes = opcodes
+        self.lines = lines
+        self.records = records
+
+    @classmethod
+    def from_file(cls, path: pathlib.Path) -> "Trace":
+        with open(path, "rb") as f:
+            return cls.from_bytes(f.read())
+
+    @classmethod
+    def from_bytes(cls, data: bytes) -> "Trace":
+        reader = _Reader(data)
+        magic, version, record_size, total, count, num_opcodes = reader.unpack(cls.HEADER)
+        if magic != cls.MAGIC:
+            raise TraceFormatError(f"not a clox trace (magic {magic!r})")
+        if version != cls.VERSION:
+            raise TraceFormatError(f"unsupported trace version {version}")
+        if record_size != cls.RECORD.size:
+            raise TraceFormatError(f"unexpected record size {record_size}")
+
+        opcodes = []
+        for _ in range(num_opcodes):
+            (length,) = reader.unpack(struct.Struct("<B"))
+            opcodes.append(reader.read(length).decode("ascii"))
+
+        (num_encodings,) = reader.unpack(struct.Struct("<I"))
+        encoding = struct.Struct("<ii")
+        lines = LineTable([reader.unpack(encoding) for _ in range(num_encodings)])
+
+        records = [Record(*reader.unpack(cls.RECORD)) for _ in range(count)]
+        return cls(total=total, opcodes=opcodes, lines=lines, records=records)
+
+    def opcode_name(self, opcode: int) -> str:
+        if opcode < len(self.opcodes):
+            return self.opcodes[opcode]
+        return f"<unknown opcode {opcode}>"
+
+    def render(self) -> typing.Iterator[str]:
+        dropped = self.total - len(self.records)
+        yield (
+            f"== Trace ({len(self.records)} of {self.total} instructions"
+            + (f", {dropped} overwritten" if dropped > 0 else "")
+            + ") =="
+        )
+        prev_line = None
+        for record in self.records:
+            line = self.lines.line_for(record.offset)
+            line_text = "   |" if line == prev_line else f"{line:4d}"
+            prev_line = line
+            yield (
+                f"{record.offset:04d} {line_text} {self.opcode_name(record.opcode):<16s} "
+                f"depth={record.depth:<5d} top={record.top_repr()}"
+            )
+
+
+class _Reader:
+    def __init__(self, data: bytes) -> None:
+        self.data = data
+        self.position = 0
+
+    def read(self, size: int) -> bytes:
+        if self.position + size > len(self.data):
+            raise TraceFormatError("truncated trace")
+        chunk = self.data[self.position : self.position + size]
+        self.position += size
+        return chunk
+
+    def unpack(self, fmt: struct.Struct) -> tuple[typing.Any, ...]:
+        return fmt.unpack(self.read(fmt.size))
\ No newline at end of file